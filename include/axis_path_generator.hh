@@ -0,0 +1,121 @@
+/** @file axis_path_generator.hh
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Inspection waypoints along the axis of a long riser: straight (vertical or
+ *  inclined) or a catenary. Rings of standoff poses are placed every spacing
+ *  metres of axis arc length, each pose looks at the riser surface. Waypoints
+ *  are produced on demand in chunks, the executor asks for the next chunk while
+ *  it flies the current one, so a 10k waypoint survey is never built up front.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef AXIS_PATH_GEN_H
+#define AXIS_PATH_GEN_H
+
+// System includes
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class AxisShape {
+    LINE,
+    CATENARY
+};
+
+/// Standoff pose, position in metres (north, east, up) from the start pose, yaw and camera pitch in degrees
+struct AxisWaypoint {
+    double x = 0, y = 0, z = 0;
+    double yaw = 0;
+    double pitch = 0;
+    double s = 0;   // axis arc length of the ring
+    int ring = 0;
+};
+
+class AxisPathGenerator {
+private:
+    AxisShape shape_ = AxisShape::LINE;
+    double length_ = 30;       // line length or catenary span, m
+    double inclination_ = 0;   // line, degrees from vertical
+    double height_ = 0;        // catenary rise from the start end, m
+    double azimuth_ = 90;      // horizontal progression of the axis, degrees from the start heading
+    double catenary_a_ = 0;    // horizontal tension over weight, m
+    double climb_ = 1;         // +1 up the axis, -1 down
+
+    double standoff_ = 5;      // drone to riser surface, m
+    double radius_ = 0.15;     // riser radius, m
+    double spacing_ = 0.3;     // axis arc length between rings, m
+    int ring_points_ = 5;
+    double ring_step_ = 15;    // degrees between the poses of a ring
+
+    /// Set by start
+    double heading_ = 0;
+    double axis_length_ = 0;
+    int rings_ = 0;
+    double origin_[3] = {0, 0, 0};
+    double front_[2] = {1, 0};        // start heading, north and east
+    double progression_[2] = {0, 1};  // heading + azimuth
+    std::vector<double> ring_cos_, ring_sin_;
+
+    /// Axis point and ring frame of the ring being generated
+    int frame_ring_ = -1;
+    double centre_[3], normal_[3], binormal_[3];
+
+    /// Generation cursor
+    size_t next_ = 0;
+    double last_[3] = {0, 0, 0};
+    double last_yaw_ = 0;
+
+    void axisAt(double s, double point[3], double tangent[3]) const;
+
+    void ringFrame(int ring);
+
+    AxisWaypoint pose(size_t k);
+
+public:
+    AxisPathGenerator();
+
+    ~AxisPathGenerator();
+
+    /// Straight axis, inclination from vertical towards azimuth. A negative length goes down the riser.
+    void setLine(double length, double inclination, double azimuth);
+
+    /** Catenary rising height metres over a horizontal span towards azimuth, from its low point.
+     *  A negative height goes down the same catenary from its top end to the low point. */
+    void setCatenary(double span, double height, double azimuth);
+
+    /// Metres: standoff to the surface, riser diameter, axis spacing between rings; ring_points poses ring_step degrees apart
+    void setInspectionParam(double standoff, double diameter, int ring_points, double ring_step, double spacing);
+
+    /** Places the axis start standoff + radius ahead of the drone at heading (degrees) and rewinds.
+     *  False when the geometry has no solution or no ring fits. */
+    bool start(double heading);
+
+    void rewind();
+
+    /// Total number of waypoints
+    size_t size() const { return (size_t) rings_ * ring_points_; }
+
+    size_t remaining() const { return size() - next_; }
+
+    bool done() const { return next_ >= size(); }
+
+    double getAxisLength() const { return axis_length_; }
+
+    /// Appends up to max_count waypoints to chunk, returns how many
+    size_t next(size_t max_count, std::vector<AxisWaypoint> &chunk);
+
+    /// As next, but as executor legs {wp, dx, dy, dz, yaw, pitch} relative to the previous waypoint
+    size_t nextRelative(size_t max_count, std::vector<std::vector<float>> &waypoints);
+
+    /// Streams the remaining waypoints to a WP,X,Y,Z,Yaw,Pitch CSV of relative legs
+    bool saveRelative(const std::string &file, size_t chunk = 1024);
+
+    static AxisShape parseShape(const std::string &name, bool &valid);
+};
+
+#endif // AXIS_PATH_GEN_H
@@ -0,0 +1,112 @@
+/** @file capture_scheduler.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Fires the gimbal camera and the SV3D stereo triggers concurrently at each
+ *  waypoint. The mission is released once every shutter service has answered,
+ *  the results are logged on a background thread.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_CAPTURE_SCHEDULER_H
+#define RISER_INSPECTION_CAPTURE_SCHEDULER_H
+
+// ROS includes
+#include <ros/ros.h>
+#include <ros/service_client.h>
+#include <stereo_vant/PointGray.h>
+// DJI SDK includes
+#include <dji_osdk_ros/CameraStartShootSinglePhoto.h>
+#include <dji_osdk_ros/GimbalAction.h>
+#include <dji_osdk_ros/common_type.h>
+#include <telemetry_log.h>
+#include <telemetry_store.h>
+// System includes
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CaptureScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /// Outcome of one trigger, duration is the full service round trip
+    struct CaptureResult {
+        std::string name;
+        bool result;
+        double duration;
+        TelemetrySnapshot pose; // aircraft state when the trigger was sent
+        double stamp;           // ROS time of the trigger, s
+    };
+
+private:
+    /// Triggers fired at a single waypoint, waiting for their acknowledge
+    struct CaptureRecord {
+        int wp;
+        double blocked;
+        std::vector<std::shared_future<CaptureResult>> tasks;
+    };
+
+    ros::ServiceClient camera_photo_client;
+    ros::ServiceClient gimbal_control_client;
+    ros::ServiceClient sv3d_client;
+
+    const TelemetryStore *telemetry = nullptr;
+
+    bool use_gimbal = false;
+    bool use_stereo = false;
+    bool reset_gimbal = true;
+    std::string stereo_path;
+    int camera_count = 1;
+    int stereo_count = 1;
+
+    /// stamp, wp and file of every acknowledged capture, the photo list of telemetry_geotag
+    std::string capture_log_dir = ".";
+    TelemetryLogWriter capture_log;
+
+    /// Last trigger of each device, a new one is only fired after the previous is acknowledged
+    std::shared_future<CaptureResult> gimbal_pending;
+    std::shared_future<CaptureResult> stereo_pending;
+
+    /// Confirmation thread
+    std::thread confirm_thread;
+    std::mutex confirm_mutex;
+    std::condition_variable confirm_cv;
+    std::deque<CaptureRecord> confirm_queue;
+    bool running = true;
+    double total_saved = 0;
+
+    CaptureResult gimbal_photo(std::shared_future<CaptureResult> previous);
+
+    CaptureResult stereo_photo(std::shared_future<CaptureResult> previous);
+
+    void confirm_captures();
+
+public:
+    CaptureScheduler();
+
+    ~CaptureScheduler();
+
+    void init(ros::NodeHandle &nh, const TelemetryStore *telemetry_store);
+
+    /** reset_gimbal_photo re-centres the gimbal before every gimbal camera shot.
+     *  Starts a new capture log, captures_<unix time>.txt in the capture_log_dir parameter. */
+    void configure(bool gimbal_camera, bool stereo, const std::string &stereo_folder, bool reset_gimbal_photo = true);
+
+    /// False when a shutter service reported a failure, always true without wait_result
+    bool capture(int wp, bool wait_result = true);
+
+    void flush();
+
+    double get_total_saved();
+};
+
+#endif //RISER_INSPECTION_CAPTURE_SCHEDULER_H
@@ -0,0 +1,98 @@
+/** @file compressed_preview.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Low bandwidth preview of the stereo images for the ground station. Each
+ *  stream takes a share of a bitrate budget, a token bucket drops frames the
+ *  link cannot carry and the resolution and JPEG quality follow the measured
+ *  frame size. Downscaling and encoding (JPEG for imagery, 16 bit PNG for the
+ *  raw disparity) run on a background thread, submit only copies the newest
+ *  frame and never waits for the encoder.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_COMPRESSED_PREVIEW_H
+#define RISER_INSPECTION_COMPRESSED_PREVIEW_H
+
+#include <ros/ros.h>
+#include <std_msgs/Header.h>
+#include <sensor_msgs/CompressedImage.h>
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CompressedPreview {
+public:
+    enum Codec {
+        JPEG,  // 8 bit imagery, lossy
+        PNG16  // CV_16S StereoBM disparity, lossless, 1/16 pixel of the full resolution image
+    };
+
+private:
+    struct Stream {
+        ros::Publisher publisher;
+        Codec codec;
+        double share;         // fraction of the budget
+        /// Newest frame, encoded by the worker
+        cv::Mat frame;
+        std_msgs::Header header;
+        bool fresh = false;
+        /// Rate control
+        double tokens = 0;    // bytes the stream may still send
+        double last_refill = 0;
+        double last_submit = 0;
+        double scale = 0.5;
+        int quality = 60;
+        double frame_bytes = 0; // EMA of the encoded size
+        int samples = 0;        // frames encoded with the current setting
+        size_t sent = 0, dropped = 0;
+    };
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::mutex stream_mutex;
+    std::condition_variable frame_ready;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    /// Parameters
+    double bitrate = 256e3;   // bit/s over every stream
+    double max_rate = 5;      // Hz per stream
+    double min_scale = 0.25;
+    int min_quality = 30;
+    int max_quality = 80;
+
+    void run();
+
+    void encode(Stream &stream, cv::Mat &frame, const std_msgs::Header &header);
+
+    /// Degrade quality then resolution when frames outgrow the budget, recover in reverse
+    void adapt(Stream &stream);
+
+public:
+    CompressedPreview();
+
+    ~CompressedPreview();
+
+    void setBudget(double bitrate_bps, double max_rate_hz, double min_scale, int min_quality, int max_quality);
+
+    /// Returns the stream index, streams are added before start
+    int addStream(ros::NodeHandle &nh, const std::string &topic, Codec codec, double share);
+
+    void start();
+
+    void stop();
+
+    /// Copy of image is queued if the stream has budget left, returns false if the frame was dropped
+    bool submit(int stream, const std_msgs::Header &header, const cv::Mat &image);
+};
+
+#endif //RISER_INSPECTION_COMPRESSED_PREVIEW_H
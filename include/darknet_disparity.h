@@ -10,9 +10,17 @@
 #include <ros/ros.h>
 #include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.h>
-#include <darknet_ros_msgs/ObjectCount.h>
+#include <geometry_msgs/PointStamped.h>
+#include <riser_inspection/ObjectDistances.h>
+#include <riser_inspection/ObjectTracks.h>
+#include <disparity_ring.h>
+#include <object_tracker.h>
+#include <stereo_utility/preview_worker.hpp>
 #include <opencv2/opencv.hpp>
 
+#include <set>
+#include <string>
+
 
 class DarknetDisparity {
 private:
@@ -20,15 +28,32 @@ private:
 
     ros::Subscriber darknet_bb_sub;
     ros::Subscriber m210_disparity_sub;
-    ros::Subscriber darknet_obj_sub;
 
-    cv_bridge::CvImagePtr cv_disp;
-    cv::Mat disp_img;
-    cv::Point top_left;
-    cv::Point bot_right;
+    /// Riser position in the left camera frame (x right, y down, z forward), consumed by the standoff correction
+    ros::Publisher distance_pub;
+    /// Every filtered detection of a BoundingBoxes message
+    ros::Publisher objects_pub;
+    /// Tracks predicted to every disparity frame
+    ros::Publisher tracks_pub;
+
+    /// Recent disparity frames, a detection is measured on the frame of its own image
+    DisparityRing disparity_ring;
+    double match_tolerance = 0.005; // s
+    std::vector<cv::Rect> boxes_to_show;
+    /// Disparity and boxes preview, null when headless
+    M210_STEREO::PreviewWorker::Ptr preview;
     std::string object_to_track;
-    int n_detected_obj = 0;
-    int found_obj_darknet = 0;
+    std::set<std::string> classes;  // empty accepts every class
+
+    ObjectTracker tracker;
+    bool use_tracker = true;
+
+    /// Stereo calibration of the 8 bit disparity image
+    float baseline_x_fx_ = -45.3569;
+    float principal_x_ = 450.6202;
+    float principal_y_ = 231.8208;
+    float fx_ = 444.3998;
+    float fy_ = 444.3998;
 
 public:
     DarknetDisparity();
@@ -41,9 +66,13 @@ public:
 
     void disparity_cb(const sensor_msgs::ImageConstPtr &disp_msgs);
 
-    void darknet_obj_count_cb(const darknet_ros_msgs::ObjectCount::ConstPtr &obj_msg);
+    bool calculate_position(const DisparityRing::Frame &frame, const cv::Rect &box, cv::Point3f &position,
+                            int &valid_pixels);
+
+    void track_frame(const DisparityRing::Frame &frame);
 
-    float calculate_distance();
+    /// Point in the left camera frame from the box centre and depth, same scale as calculate_position
+    cv::Point3f depth_to_point(float u, float v, float depth);
 
     void show_disp_image();
 };
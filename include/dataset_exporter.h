@@ -0,0 +1,94 @@
+/** @file dataset_exporter.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Builds training records from the stereo pipeline: the rectified left image
+ *  and the raw disparity of a frame are joined by stamp, tagged with the latest
+ *  GPS, local position and attitude, and held for the darknet boxes of that
+ *  frame before they go to the DatasetWriter. Runs on the live topics during
+ *  flight or over a bag offline, the same handlers serve both.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_DATASET_EXPORTER_H
+#define RISER_INSPECTION_DATASET_EXPORTER_H
+
+#include <dataset_store.h>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/NavSatFix.h>
+#include <geometry_msgs/PointStamped.h>
+#include <geometry_msgs/QuaternionStamped.h>
+#include <darknet_ros_msgs/BoundingBoxes.h>
+
+#include <map>
+#include <string>
+
+class DatasetExporter {
+public:
+    struct Topics {
+        std::string image = "/stereo_depth_perception/rectified_vga_front_left_image";
+        std::string disparity = "/stereo_depth_perception/raw_disparity_front_left_image";
+        std::string boxes = "/darknet_ros/bounding_boxes";
+        std::string gps = "/dji_osdk_ros/gps_position";
+        std::string attitude = "/dji_osdk_ros/attitude";
+        std::string local = "/dji_osdk_ros/local_position";
+    };
+
+private:
+    struct Pending {
+        DatasetFrame frame;
+        sensor_msgs::ImageConstPtr image_msg, disparity_msg;
+        ros::Time created;
+    };
+
+    DatasetWriter writer;
+    Topics topics;
+    std::map<double, Pending> pending; // by image stamp
+    DatasetHeader pose;                // latest pose fields, copied into every new frame
+    double box_wait = 1.0;             // s a frame waits for its boxes
+    size_t max_pending = 60;
+    bool offline = false;
+    ros::Time bag_time;
+    uint64_t late_boxes = 0;
+
+    std::vector<ros::Subscriber> subscribers;
+
+    ros::Time now() const { return offline ? bag_time : ros::Time::now(); }
+
+    Pending &frameAt(const ros::Time &stamp);
+
+    /// Frames older than box_wait go to the writer, all of them when everything is set
+    void flush(bool everything);
+
+    static bool toMat(const sensor_msgs::ImageConstPtr &msg, cv::Mat &mat);
+
+public:
+    bool open(const std::string &dir, size_t chunk_mb, size_t max_queue, double wait);
+
+    void setTopics(const Topics &names) { topics = names; }
+
+    void subscribe(ros::NodeHandle &nh);
+
+    /// Replays the topics of the bag in recording order, true when the bag could be read
+    bool processBag(const std::string &file);
+
+    void close();
+
+    void imageCallback(const sensor_msgs::ImageConstPtr &msg);
+
+    void disparityCallback(const sensor_msgs::ImageConstPtr &msg);
+
+    void boxesCallback(const darknet_ros_msgs::BoundingBoxesConstPtr &msg);
+
+    void gpsCallback(const sensor_msgs::NavSatFixConstPtr &msg);
+
+    void attitudeCallback(const geometry_msgs::QuaternionStampedConstPtr &msg);
+
+    void localCallback(const geometry_msgs::PointStampedConstPtr &msg);
+};
+
+#endif //RISER_INSPECTION_DATASET_EXPORTER_H
@@ -0,0 +1,163 @@
+/** @file dataset_store.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Chunked, indexed container for training data recorded in flight: the
+ *  rectified left image, the disparity, the pose and the darknet boxes of every
+ *  stereo frame. Records are appended to fixed-size chunk files by a background
+ *  thread and an index of fixed-size entries gives random access by frame
+ *  number or stamp. Images are stored raw, so a record can be read back
+ *  without decoding.
+ *
+ *  <dir>/chunk_00000.rds ...   records
+ *  <dir>/index.rds             one DatasetIndexEntry per frame, in frame order
+ *  <dir>/classes.txt           "id name" of every class seen
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_DATASET_STORE_H
+#define RISER_INSPECTION_DATASET_STORE_H
+
+#include <opencv2/core/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint32_t DATASET_MAGIC = 0x46534452; // "RDSF"
+static const uint32_t DATASET_MAX_BOXES = 4096;     // per frame, more is a corrupt record
+static const int32_t DATASET_MAX_SIDE = 16384;      // pixels
+
+struct DatasetBox {
+    int32_t class_id;
+    float probability;
+    float xmin, ymin, xmax, ymax; // pixels, inclusive
+};
+
+/// Fixed part of a record, followed by the boxes, the image and the disparity bytes
+struct DatasetHeader {
+    uint32_t magic = DATASET_MAGIC;
+    uint32_t header_size = sizeof(DatasetHeader);
+    uint64_t frame = 0;
+    double stamp = 0;          // stereo image stamp, s
+    double gps_stamp = 0;
+    double latitude = 0, longitude = 0, altitude = 0; // deg, deg, m
+    double local_stamp = 0;
+    double x = 0, y = 0, z = 0;                       // local position ENU, m
+    double attitude_stamp = 0;
+    double qw = 1, qx = 0, qy = 0, qz = 0;            // FLU body w.r.t. ENU ground
+    uint32_t flags = 0;
+    uint32_t n_boxes = 0;
+    int32_t image_rows = 0, image_cols = 0, image_type = 0;
+    int32_t disparity_rows = 0, disparity_cols = 0, disparity_type = 0;
+    uint64_t image_bytes = 0, disparity_bytes = 0;
+};
+
+enum DatasetFlags {
+    DATASET_DETECTED = 1 // darknet ran on this frame, no boxes means no object
+};
+
+struct DatasetIndexEntry {
+    uint64_t frame;
+    double stamp;
+    uint32_t chunk;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct DatasetFrame {
+    DatasetHeader header;
+    std::vector<DatasetBox> boxes;
+    cv::Mat image;
+    cv::Mat disparity;
+    /// Keeps the buffers of image and disparity alive, e.g. the ROS message they view
+    std::shared_ptr<const void> owner;
+};
+
+class DatasetWriter {
+private:
+    std::string directory;
+    uint64_t chunk_bytes;
+    size_t max_queue;
+
+    std::deque<DatasetFrame> queue;
+    std::map<int, std::string> classes;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::condition_variable queue_space;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    FILE *chunk = nullptr;
+    FILE *index = nullptr;
+    uint32_t chunk_number = 0;
+    uint64_t chunk_offset = 0;
+    uint64_t frames = 0;
+    bool failed = false; // the files could not be brought back to the last indexed record
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+
+    void run();
+
+    bool write(DatasetFrame &frame);
+
+    bool discardRecord();
+
+    bool openChunk();
+
+public:
+    DatasetWriter();
+
+    ~DatasetWriter();
+
+    /// Creates the directory, chunk_mb per chunk file, at most max_queue frames waiting
+    bool open(const std::string &dir, size_t chunk_mb = 256, size_t max_queue = 60);
+
+    /// Returns false and counts a drop when the writer is behind, unless wait (offline export)
+    bool push(DatasetFrame &&frame, bool wait = false);
+
+    void setClassName(int id, const std::string &name);
+
+    /// Writes every queued frame, then the class table
+    void close();
+
+    uint64_t getWritten() const { return written; }
+
+    uint64_t getDropped() const { return dropped; }
+};
+
+class DatasetReader {
+private:
+    std::string directory;
+    std::vector<DatasetIndexEntry> entries;
+    std::vector<FILE *> chunks;
+
+public:
+    ~DatasetReader();
+
+    bool open(const std::string &dir);
+
+    size_t size() const { return entries.size(); }
+
+    /// Frame by number, the matrices own their data
+    bool read(size_t frame, DatasetFrame &out);
+
+    /// Frame closest to stamp, binary search on the index
+    size_t findStamp(double stamp) const;
+
+    const std::vector<DatasetIndexEntry> &getIndex() const { return entries; }
+};
+
+#endif //RISER_INSPECTION_DATASET_STORE_H
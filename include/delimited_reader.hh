@@ -0,0 +1,111 @@
+/** @file delimited_reader.hh
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Streaming reader of comma or tab separated files (waypoint CSV, telemetry
+ *  logs). The file is memory mapped and every row is split in place: fields
+ *  are views into the mapping, nothing is allocated per row, and numbers are
+ *  parsed straight from the mapped bytes. Columns are found by header name.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef DELIMITED_READER_H
+#define DELIMITED_READER_H
+
+// System includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class DelimitedReader {
+public:
+    /// View of one field, valid until the reader moves or closes
+    struct Field {
+        const char *begin;
+        const char *end;
+
+        size_t size() const { return (size_t) (end - begin); }
+
+        bool empty() const { return begin == end; }
+
+        std::string str() const { return std::string(begin, end); }
+
+        bool operator==(const char *text) const;
+    };
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    const char *cursor_ = nullptr;
+    bool is_delimiter_[256];
+
+    std::vector<std::string> names_;
+    std::vector<Field> fields_;
+    size_t line_ = 0;
+
+    void split(const char *begin, const char *end);
+
+public:
+    DelimitedReader();
+
+    ~DelimitedReader();
+
+    DelimitedReader(const DelimitedReader &) = delete;
+
+    DelimitedReader &operator=(const DelimitedReader &) = delete;
+
+    /** Maps the file. delimiters lists every separator character, empty picks tab when the
+     *  first line has one and comma otherwise. With header the first row names the columns. */
+    bool open(const std::string &filepath, const std::string &delimiters = "", bool header = true);
+
+    void close();
+
+    /// Next non-empty row, false at the end of the file
+    bool next();
+
+    /// Byte offset of the row next() reads, for an index of the file
+    size_t tell() const { return (size_t) (cursor_ - data_); }
+
+    /// Continue reading at a row start returned by tell(), false past the end
+    bool seek(size_t offset);
+
+    /// True when offset is the start of the file or follows a line break, i.e. a row start
+    bool isRowStart(size_t offset) const {
+        return data_ != nullptr && offset <= size_ && (offset == 0 || data_[offset - 1] == '\n');
+    }
+
+    /// Column of a header name, -1 if missing. Look it up once, not per row.
+    int column(const std::string &name) const;
+
+    const std::vector<std::string> &getNames() const { return names_; }
+
+    size_t getLine() const { return line_; }
+
+    size_t size() const { return fields_.size(); }
+
+    const Field &field(size_t i) const { return fields_[i]; }
+
+    /// Typed fields, false if the column is missing or not a number
+    bool getDouble(size_t i, double &value) const;
+
+    bool getFloat(size_t i, float &value) const;
+
+    bool getInt(size_t i, long &value) const;
+
+    /// Typed fields with a default for missing or malformed cells
+    double asDouble(size_t i, double fallback = 0) const;
+
+    long asInt(size_t i, long fallback = 0) const;
+
+    /// Decimal or scientific number, correctly rounded; falls back to strtod outside the fast path
+    static bool parseDouble(const char *begin, const char *end, double &value);
+
+    /// Decimal integer of at most 18 digits, false for anything longer
+    static bool parseInt(const char *begin, const char *end, long &value);
+};
+
+#endif // DELIMITED_READER_H
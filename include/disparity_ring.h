@@ -0,0 +1,61 @@
+/** @file disparity_ring.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Fixed-size history of disparity frames ordered by header stamp, so a
+ *  detection that arrives several frames late is measured against the
+ *  disparity of the image it was computed on. Frames share the message
+ *  buffer and the prefix-sum buffers of a slot are reused on every lap.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_DISPARITY_RING_H
+#define RISER_INSPECTION_DISPARITY_RING_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+class DisparityRing {
+public:
+    struct Frame {
+        sensor_msgs::ImageConstPtr msg;
+        cv_bridge::CvImageConstPtr image; // view on msg, no copy
+        /// Prefix sums of the disparity and of the matched-pixel mask, built on the first lookup
+        cv::Mat disp_sum, valid_count, valid_mask;
+        bool integral_ready = false;
+    };
+
+private:
+    std::vector<Frame> slots;
+    size_t head = 0;  // next slot to write
+    size_t count = 0;
+
+    /// i-th oldest frame
+    Frame &at(size_t i);
+
+public:
+    explicit DisparityRing(size_t capacity = 30);
+
+    /// Store a frame, returns false if its stamp is older than the newest one
+    bool push(const sensor_msgs::ImageConstPtr &msg);
+
+    /// Frame closest to stamp within tolerance seconds, binary search, nullptr if none
+    Frame *find(const ros::Time &stamp, double tolerance);
+
+    Frame *latest();
+
+    void buildIntegral(Frame &frame);
+
+    size_t size() const { return count; }
+
+    size_t capacity() const { return slots.size(); }
+};
+
+#endif //RISER_INSPECTION_DISPARITY_RING_H
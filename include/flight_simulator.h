@@ -0,0 +1,151 @@
+/** @file flight_simulator.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Stand-in for dji_vehicle_node. Serves the flight, camera and stereo services
+ *  used by LocalController and publishes the telemetry topics at DJI rates from
+ *  a kinematic multirotor model, so missions can run headless on a laptop.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_FLIGHT_SIMULATOR_H
+#define RISER_INSPECTION_FLIGHT_SIMULATOR_H
+
+// ROS includes
+#include <ros/ros.h>
+#include <ros/service_server.h>
+#include <sensor_msgs/NavSatFix.h>
+#include <geometry_msgs/QuaternionStamped.h>
+#include <geometry_msgs/PointStamped.h>
+#include <geometry_msgs/Vector3Stamped.h>
+#include <std_msgs/Float32.h>
+#include <std_msgs/UInt8.h>
+#include <sensor_msgs/Joy.h>
+#include <stereo_vant/PointGray.h>
+// DJI SDK includes
+#include <dji_osdk_ros/FlightTaskControl.h>
+#include <dji_osdk_ros/ObtainControlAuthority.h>
+#include <dji_osdk_ros/SetLocalPosRef.h>
+#include <dji_osdk_ros/CameraStartShootSinglePhoto.h>
+#include <dji_osdk_ros/CameraRecordVideoAction.h>
+#include <dji_osdk_ros/GimbalAction.h>
+#include <dji_osdk_ros/MissionWpUpload.h>
+#include <dji_osdk_ros/MissionWpAction.h>
+#include <dji_osdk_ros/EmergencyBrake.h>
+// System includes
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Kinematic state of the simulated aircraft, position in ENU metres from takeoff
+struct SimulatedState {
+    double x = 0, y = 0, z = 0;
+    double vx = 0, vy = 0, vz = 0;
+    double heading = 0; // degrees from north, clockwise (DJI convention)
+    double target_x = 0, target_y = 0, target_z = 0;
+    double target_heading = 0;
+    double origin_x = 0, origin_y = 0, origin_z = 0; // local position reference
+    bool in_air = false;
+    bool authority = false;
+    /// Streamed velocity setpoint (ENU m/s, CCW yaw rate rad/s), overrides the position target while fresh
+    double cmd_vx = 0, cmd_vy = 0, cmd_vz = 0, cmd_yaw_rate = 0;
+    ros::Time setpoint_stamp;
+};
+
+class FlightSimulator {
+private:
+    ros::NodeHandle nh_;
+
+    ros::Subscriber setpoint_sub;
+
+    ros::Publisher gps_pub, attitude_pub, local_pos_pub, height_pub, velocity_pub, flight_status_pub;
+
+    ros::ServiceServer task_control_service;
+    ros::ServiceServer control_authority_service;
+    ros::ServiceServer local_ref_service;
+    ros::ServiceServer camera_photo_service;
+    ros::ServiceServer camera_video_service;
+    ros::ServiceServer gimbal_service;
+    ros::ServiceServer sv3d_service;
+    ros::ServiceServer waypoint_upload_service;
+    ros::ServiceServer waypoint_action_service;
+    ros::ServiceServer emergency_brake_service;
+
+    ros::Timer physics_timer, attitude_timer, telemetry_timer;
+
+    std::mutex state_mutex;
+    SimulatedState state;
+
+    /// Uploaded onboard mission, flown by mission_thread
+    std::vector<dji_osdk_ros::MissionWaypoint> mission;
+    std::thread mission_thread;
+    std::atomic<bool> mission_running{false};
+    std::atomic<bool> mission_paused{false};
+    std::atomic<bool> leg_interrupted{false};
+
+    /// Model parameters
+    double max_speed = 2.0;     // m/s
+    double max_accel = 1.0;     // m/s^2
+    double max_yaw_rate = 60;   // deg/s
+    double settle_time = 1.0;   // s hovering inside the threshold before a task is acknowledged
+    double task_timeout = 60;   // s
+    double photo_latency = 0.8; // s, camera acknowledge after writing the file
+    double stereo_latency = 0.3;
+    double physics_rate = 200;
+    double setpoint_timeout = 0.2; // s without setpoints before falling back to position hold
+    double home_lat = -27.6, home_lon = -48.5;
+
+    void step(double dt);
+
+    void physics_callback(const ros::TimerEvent &event);
+
+    void attitude_callback(const ros::TimerEvent &event);
+
+    void telemetry_callback(const ros::TimerEvent &event);
+
+    bool wait_target(double pos_thresh, double yaw_thresh);
+
+    void setpoint_callback(const sensor_msgs::Joy::ConstPtr &msg);
+
+    void fly_mission();
+
+public:
+    FlightSimulator();
+
+    ~FlightSimulator();
+
+    void advertising(ros::NodeHandle &nh);
+
+    bool task_control_cb(dji_osdk_ros::FlightTaskControl::Request &req,
+                         dji_osdk_ros::FlightTaskControl::Response &res);
+
+    bool control_authority_cb(dji_osdk_ros::ObtainControlAuthority::Request &req,
+                              dji_osdk_ros::ObtainControlAuthority::Response &res);
+
+    bool local_ref_cb(dji_osdk_ros::SetLocalPosRef::Request &req, dji_osdk_ros::SetLocalPosRef::Response &res);
+
+    bool camera_photo_cb(dji_osdk_ros::CameraStartShootSinglePhoto::Request &req,
+                         dji_osdk_ros::CameraStartShootSinglePhoto::Response &res);
+
+    bool camera_video_cb(dji_osdk_ros::CameraRecordVideoAction::Request &req,
+                         dji_osdk_ros::CameraRecordVideoAction::Response &res);
+
+    bool gimbal_cb(dji_osdk_ros::GimbalAction::Request &req, dji_osdk_ros::GimbalAction::Response &res);
+
+    bool sv3d_cb(stereo_vant::PointGray::Request &req, stereo_vant::PointGray::Response &res);
+
+    bool waypoint_upload_cb(dji_osdk_ros::MissionWpUpload::Request &req,
+                            dji_osdk_ros::MissionWpUpload::Response &res);
+
+    bool waypoint_action_cb(dji_osdk_ros::MissionWpAction::Request &req,
+                            dji_osdk_ros::MissionWpAction::Response &res);
+
+    bool emergency_brake_cb(dji_osdk_ros::EmergencyBrake::Request &req, dji_osdk_ros::EmergencyBrake::Response &res);
+};
+
+#endif //RISER_INSPECTION_FLIGHT_SIMULATOR_H
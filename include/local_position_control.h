@@ -15,9 +15,14 @@
 #include <sensor_msgs/Joy.h>
 #include <geometry_msgs/QuaternionStamped.h>
 #include <geometry_msgs/PointStamped.h>
-#include <ignition/math/Pose3.hh>
 #include <std_msgs/Float32.h>
-#include <tf/tf.h>
+
+// System includes
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/resource.h>
 
 // Services
 #include <ros/service_client.h>
@@ -25,6 +30,8 @@
 #include <iostream>
 #include <riser_inspection/LocalPosition.h>
 #include <riser_inspection/StartMission.h>
+#include <riser_inspection/RiserCylinder.h>
+#include <riser_inspection/SectorDistances.h>
 #include <stereo_vant/PointGray.h>
 // DJI SDK includes
 #include <dji_osdk_ros/FlightTaskControl.h>
@@ -34,55 +41,113 @@
 #include <dji_osdk_ros/CameraRecordVideoAction.h>
 #include <dji_osdk_ros/common_type.h>
 #include <dji_osdk_ros/GimbalAction.h>
+#include <dji_osdk_ros/MissionWpUpload.h>
+#include <dji_osdk_ros/MissionWpAction.h>
+#include <dji_osdk_ros/EmergencyBrake.h>
 
 
 #include <path_generator.hh>
+#include <trajectory_generator.hh>
+#include <axis_path_generator.hh>
+#include <capture_scheduler.h>
+#include <telemetry_store.h>
+#include <standoff_filter.h>
+
+/// States of the mission executor. The executor thread walks through them while
+/// the ROS callbacks only keep the telemetry up to date.
+enum class MissionState {
+    IDLE,
+    MOVE_TO_WP,
+    CAPTURE,
+    TRACK_TRAJECTORY,
+    ONBOARD_MISSION,
+    RETURN_HOME
+};
 
 class LocalController {
 private:
     ros::NodeHandle nh_;
     /// Filter to acquire same time GPS and RTK
     ros::Subscriber gps_sub, attitude_sub, local_pos_sub, height_sub, rtk_status;
+    ros::Subscriber standoff_sub, cylinder_sub, sector_sub;
+    ros::WallTimer proximity_timer;
 
     /// XYZ service
     ros::ServiceServer local_position_service;
     ros::ServiceServer start_mission_service;
 
+    /// Velocity setpoints for the continuous mode
+    ros::Publisher setpoint_pub;
+
     /// Stereo VANT3D
     ros::ServiceClient sv3d_client;
 
     /// DJI Services
     ros::ServiceClient obtain_crl_authority_client;
     ros::ServiceClient task_control_client;
-    ros::ServiceClient camera_photo_client;
     ros::ServiceClient camera_record_video_client;
     ros::ServiceClient set_local_ref_client;
     ros::ServiceClient gimbal_control_client;
-
-    /// Messages from GPS, RTK and Attitude
-    sensor_msgs::NavSatFix current_gps;
-    geometry_msgs::PointStamped current_local_pos;
-    geometry_msgs::QuaternionStamped current_atti;
-    ignition::math::Quaterniond current_atti_euler;
-    tf::Matrix3x3 atti_matrix;
-    tf::Quaternion q_atti_matrix;
-
-    float rpa_height = 0;
+    ros::ServiceClient waypoint_upload_client;
+    ros::ServiceClient waypoint_action_client;
+    ros::ServiceClient emergency_brake_client;
+
+    /// GPS, local position, height and attitude shared with the executor and the capture scheduler
+    TelemetryStore telemetry;
+
+    /// Mission executor
+    std::thread mission_thread;
+    std::mutex mission_mutex;
+    std::condition_variable mission_cv;
+    MissionState mission_state = MissionState::IDLE;
+    std::atomic<bool> executor_running{true};
+    ros::WallTime mission_start;
+    double mission_cpu_start = 0;
 
     /// Internal references
-    bool doing_mission = false;
+    std::atomic<bool> doing_mission{false};
     int wp_n = 1;
     double yaw_error=1, pos_error=0.1;
     bool use_gimbal = false;
     bool camera_gimbal = false;
     bool video_gimbal = false;
     bool use_stereo = false;
-    int camera_count = 1;
+    bool continuous_mode = false;
+    bool onboard_mission = false;
     int stereo_count = 1;
     double init_heading = 0;
 
+    /// Closed-loop standoff from the stereo riser range
+    StandoffFilter standoff;
+    bool standoff_correction = false;
+    double standoff_target = 10;  // commanded riser distance, m
+    double standoff_offset = 0;   // total radial shift applied this mission, m
+    double standoff_deadband = 0.1, standoff_max_step = 0.5, standoff_max_total = 2.0; // m
+
+    /// Last stereo cylinder fit, seeds riser distance and diameter when riser_from_stereo is set
+    std::mutex cylinder_mutex;
+    riser_inspection::RiserCylinder riser_cylinder;
+    bool riser_from_stereo = false;
+
+    /// Proximity guard, the executor holds while proximity_hold is set
+    bool proximity_guard = false;
+    std::atomic<bool> proximity_hold{false};
+    std::atomic<bool> leg_interrupted{false};
+    std::atomic<double> last_sector_time{0};
+    double proximity_stop = 2.0, proximity_clear = 2.5; // m, hysteresis
+    double proximity_timeout = 0.5;                      // s without fresh sectors before holding
+    double proximity_max_latency = 0.15;                 // s, image stamp to sector message
+
+    CaptureScheduler capture_scheduler;
+    TrajectoryGenerator trajectory;
     PathGenerate pathGenerator;
+    /// Long or curved risers, legs are generated a chunk ahead of the executor
+    AxisPathGenerator axisPath;
+    bool axis_path = false;
+    int axis_chunk = 200;
+    float gimbal_pitch = 0; // pitch commanded for the axis poses, degrees from level
     std::vector<std::vector<float>> waypoint_list;
+    std::vector<std::vector<double>> mission_gnss; // onboard waypoints {lat, lon, height above takeoff, yaw}
 
 public:
     LocalController();
@@ -102,6 +167,18 @@ public:
 
     void height_callback(const std_msgs::Float32::ConstPtr &msg);
 
+    void standoff_callback(const geometry_msgs::PointStamped::ConstPtr &msg);
+
+    void apply_standoff_correction();
+
+    void cylinder_callback(const riser_inspection::RiserCylinder::ConstPtr &msg);
+
+    void sector_callback(const riser_inspection::SectorDistances::ConstPtr &msg);
+
+    void proximity_timer_callback(const ros::WallTimerEvent &event);
+
+    void hold_position();
+
     bool local_pos_service_cb(riser_inspection::LocalPosition::Request &req,
                               riser_inspection::LocalPosition::Response &res);
 
@@ -113,13 +190,32 @@ public:
     void set_gimbal_angles(float roll, float pitch, float yaw);
 
     bool gimbal_camera(bool record_video);
-    bool stereo_photo();
 
     bool local_position_ctrl(float xCmd, float yCmd, float zCmd, float yawCmd, float pos_thresh, float yaw_thresh);
 
     bool local_position_ctrl_mission();
 
+    bool track_trajectory();
+
+    bool plan_waypoint_mission();
+
+    bool fly_waypoint_mission();
+
+    bool upload_waypoint_mission(int first, int end);
+
+    bool monitor_waypoint_mission(int first, int end);
+
     bool generate_WP(int csv_type);
+
+    bool generate_axis_WP(double distance, double diameter, int ring_points, int ring_step, double spacing);
+
+    void mission_executor();
+
+    void set_mission_state(MissionState state);
+
+    MissionState get_mission_state();
+
+    static double process_cpu_time();
 };
 
 #ifndef RISER_INSPECTION_LOCAL_POSITION_CONTROL_H
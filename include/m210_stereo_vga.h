@@ -12,11 +12,20 @@
 #include <ros/ros.h>
 #include <sensor_msgs/Image.h>
 #include "sensor_msgs/PointCloud2.h"
-#include <message_filters/subscriber.h>
-#include <message_filters/time_synchronizer.h>
 
 // Utility includes
 #include "stereo_utility/stereo_frame.hpp"
+#include "stereo_utility/cylinder_fitter.hpp"
+#include "stereo_utility/proximity_guard.hpp"
+#include "stereo_utility/preview_worker.hpp"
+#include "stereo_utility/raw_stereo_ring.hpp"
+#include "compressed_preview.h"
+#include "stereo_pair_mailbox.h"
+#include <riser_inspection/RiserCylinder.h>
+#include <riser_inspection/SectorDistances.h>
+#include <riser_inspection/LoadCalibration.h>
+#include <std_msgs/UInt8.h>
+#include <std_srvs/Trigger.h>
 
 typedef std::chrono::time_point<std::chrono::high_resolution_clock> timer;
 typedef std::chrono::duration<float> duration;
@@ -26,6 +35,21 @@ void displayStereoFilteredDisparityCallback(const sensor_msgs::ImageConstPtr &im
                                             M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
 
 
+void publishSectorDistances(const std_msgs::Header &header, timer received,
+                            M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
+
+void fitRiserCylinder(const std_msgs::Header &header, M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
+
+bool loadCalibrationCallback(riser_inspection::LoadCalibration::Request &request,
+                             riser_inspection::LoadCalibration::Response &response,
+                             M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
+
+void recordBlackBox(const sensor_msgs::ImageConstPtr &img_left, const sensor_msgs::ImageConstPtr &img_right);
+
+bool flushBlackBoxCallback(std_srvs::Trigger::Request &request, std_srvs::Trigger::Response &response);
+
+void flightStatusCallback(const std_msgs::UInt8::ConstPtr &status);
+
 void visualizeRectImgHelper(M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
 
 void visualizeDisparityMapHelper(M210_STEREO::StereoFrame::Ptr stereo_frame_ptr);
@@ -0,0 +1,95 @@
+/** @file object_tracker.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Multi-target tracker for the darknet detections. Each track runs constant
+ *  velocity Kalman filters on the box centre (pixels) and depth (metres),
+ *  detections are assigned with the Hungarian method inside a gate. Tracks
+ *  coast between detections on depth measured in their predicted box, so
+ *  darknet can run on every Nth frame and tracks are still published at the
+ *  stereo rate. Late detections are advanced to the track time before fusion.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_OBJECT_TRACKER_H
+#define RISER_INSPECTION_OBJECT_TRACKER_H
+
+#include <string>
+#include <vector>
+
+/// Position and velocity along one axis, constant velocity model driven by white acceleration
+struct AxisFilter {
+    double p = 0, v = 0;
+    double P[2][2] = {{0, 0}, {0, 0}};
+
+    void init(double position, double position_var, double velocity_var);
+
+    void predict(double dt, double accel_var);
+
+    void update(double measurement, double measurement_var);
+};
+
+struct TrackedObject {
+    int id = 0;
+    std::string label;
+    AxisFilter u, v, z;         // box centre (pixels) and depth (m)
+    float width = 0, height = 0; // box size, smoothed (pixels)
+    double probability = 0;
+    double last_detection = 0;   // stamp of the last darknet box
+    int hits = 0;
+    bool confirmed = false;
+};
+
+struct Detection {
+    std::string label;
+    double probability;
+    float x, y, width, height; // box, pixels
+    float depth;               // m, <= 0 if not measured
+};
+
+class ObjectTracker {
+private:
+    std::vector<TrackedObject> tracks;
+    double time = 0; // stamp the tracks are predicted to
+    int next_id = 1;
+
+    /// Parameters
+    double gate = 60;          // pixels, maximum assignment distance
+    double depth_weight = 20;  // pixels per metre of depth difference in the cost
+    double pixel_accel = 400;  // pixels/s^2, process noise
+    double depth_accel = 2;    // m/s^2, process noise
+    double pixel_noise = 4;    // pixels, box centre measurement
+    double depth_noise = 0.2;  // m, depth measurement
+    double max_coast = 1.0;    // s without detection before a track is dropped
+    int min_hits = 2;          // detections before a track is published
+
+public:
+    void setParameters(double gate_px, double max_coast_s, int confirm_hits);
+
+    void setNoise(double pixel_accel, double depth_accel, double pixel_noise, double depth_noise);
+
+    /// Advance every track to stamp, tracks never run backwards
+    void predict(double stamp);
+
+    /// Fuse one frame of detections taken at stamp (may be older than the track time)
+    void update(double stamp, const std::vector<Detection> &detections);
+
+    /// Depth measured in the predicted box of a track on the current frame
+    void updateDepth(int id, double depth);
+
+    const std::vector<TrackedObject> &getTracks() const { return tracks; }
+
+    double getTime() const { return time; }
+
+    /// Minimum cost assignment, result[row] is the column or -1
+    static std::vector<int> hungarian(const std::vector<std::vector<double>> &cost);
+
+    /** Gated assignment: entries at or above gate are not allowed. As many pairs as possible
+     *  are matched, then the lowest total cost; result[row] is the column or -1. */
+    static std::vector<int> assign(const std::vector<std::vector<double>> &cost, double gate);
+};
+
+#endif //RISER_INSPECTION_OBJECT_TRACKER_H
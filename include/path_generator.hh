@@ -21,7 +21,7 @@
 #include <vector>
 #include <iomanip>
 #include <sys/stat.h>
-#include <boost/algorithm/string.hpp>
+#include <delimited_reader.hh>
 
 #define DEG2RAD(DEG) ((DEG) * ((3.141592653589793) / (180.0)))
 #define RAD2DEG(RAD) ((RAD) * (180.0) / (3.141592653589793))
@@ -48,10 +48,10 @@ private:
     std::vector<std::vector<float>> h_xy_points_;
     std::vector<std::vector<float>> delta_cartesian_points_;
     std::vector<std::vector<float>> cartesian_points_;
-    std::vector<std::vector<float>> gnss_points_;
+    std::vector<std::vector<double>> gnss_points_;
     /// Initial position to waypoint creates
     // TODO: Must come as initialize parameters
-    std::vector<float> gnss_initial{0, 0, 0, 0};
+    std::vector<double> gnss_initial{0, 0, 0, 0};
     std::vector<float> xyz_initial{0, 0, 0, 0};
 
     /// Internal parameters
@@ -83,6 +83,12 @@ public:
 
     std::string getFolderName();
 
+    /// {lat, lon, altitude, yaw} of every waypoint, filled by setGNSSpoints
+    const std::vector<std::vector<double>> &getGNSSpoints() const { return gnss_points_; }
+
+    /// {north, east, altitude, yaw} of every waypoint, filled by setCartesianPoints
+    const std::vector<std::vector<float>> &getCartesianPoints() const { return cartesian_points_; }
+
     void save_cartesian();
 
     void save_delta_cartesian();
@@ -97,7 +103,7 @@ public:
 
     static bool exists(const std::string &name);
 
-    // Function to fetch data from a CSV File
+    // Function to fetch data from a CSV File, every row as strings. Prefer DelimitedReader for typed columns.
     static std::vector<std::vector<std::string> > read_csv(const std::string &filepath, const std::string &delimiter);
 };
 
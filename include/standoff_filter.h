@@ -0,0 +1,54 @@
+/** @file standoff_filter.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Filters the stereo riser range published by darknet_disparity. A sliding
+ *  median rejects samples far from the recent history (bad boxes, disparity
+ *  holes) and an exponential average smooths the accepted ones.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_STANDOFF_FILTER_H
+#define RISER_INSPECTION_STANDOFF_FILTER_H
+
+#include <deque>
+#include <mutex>
+
+class StandoffFilter {
+private:
+    mutable std::mutex filter_mutex;
+    std::deque<double> window;
+    double estimate = 0;
+    double last_stamp = 0;
+    int accepted = 0;
+    int rejected = 0;
+
+    /// Parameters
+    int window_size = 9;
+    int min_samples = 5;
+    double alpha = 0.3;       // EMA weight of a new sample
+    double outlier_gate = 0.5; // m, maximum distance from the median
+    double max_age = 1.0;     // s, estimate is stale after this
+
+    double median() const;
+
+public:
+    void setParameters(int window, int min_samples, double alpha, double gate, double max_age);
+
+    void reset();
+
+    /// Add one range sample (m), returns false if it was rejected as an outlier
+    bool update(double stamp, double range);
+
+    /// True if enough recent samples back the estimate at time now
+    bool valid(double now) const;
+
+    double getEstimate() const;
+
+    int getRejected() const;
+};
+
+#endif //RISER_INSPECTION_STANDOFF_FILTER_H
@@ -0,0 +1,95 @@
+/** @file stereo_pair_mailbox.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Latest-only synchronisation of the left and right stereo images. Each side
+ *  keeps one frame, a pair is complete when both carry the same stamp (or
+ *  sequence), and the pipeline thread always takes the newest complete pair.
+ *  A pair that is replaced before it is processed is dropped instead of queued,
+ *  so latency stays bounded by one pipeline run. Drops, unmatched and late
+ *  frames are counted and published as StereoPipelineStats.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_STEREO_PAIR_MAILBOX_H
+#define RISER_INSPECTION_STEREO_PAIR_MAILBOX_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <riser_inspection/StereoPipelineStats.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class StereoPairMailbox {
+public:
+    typedef std::function<void(const sensor_msgs::ImageConstPtr &, const sensor_msgs::ImageConstPtr &)> PairCallback;
+
+private:
+    ros::Subscriber left_sub;
+    ros::Subscriber right_sub;
+
+    std::mutex mailbox_mutex;
+    std::condition_variable pair_ready;
+    /// Newest unpaired frame of each side
+    sensor_msgs::ImageConstPtr left, right;
+    /// Newest complete pair, waiting for the pipeline
+    sensor_msgs::ImageConstPtr ready_left, ready_right;
+    ros::Time last_pair;
+
+    PairCallback callback;
+    PairCallback observer;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    /// Parameters
+    double tolerance = 0;        // s, 0 matches exact stamps
+    bool match_sequence = false; // pair by header seq instead of stamp
+
+    /// Counters
+    uint64_t received_left = 0, received_right = 0;
+    uint64_t delivered = 0, dropped = 0, mismatched = 0, late = 0;
+    double processing_time = 0, latency = 0; // EMA, s
+    uint64_t stats_delivered = 0;
+    ros::WallTime stats_time;
+
+    bool matches(const sensor_msgs::ImageConstPtr &a, const sensor_msgs::ImageConstPtr &b) const;
+
+    void push(const sensor_msgs::ImageConstPtr &msg, bool is_left);
+
+    void run();
+
+public:
+    StereoPairMailbox();
+
+    ~StereoPairMailbox();
+
+    void setMatching(double tolerance_s, bool by_sequence);
+
+    /// Queue size 1 subscriptions, the mailbox replaces the transport queues
+    void subscribe(ros::NodeHandle &nh, const std::string &left_topic, const std::string &right_topic);
+
+    /// Pipeline thread, callback runs once per delivered pair
+    void start(const PairCallback &pair_callback);
+
+    void stop();
+
+    /// Sees every complete pair on the subscriber thread, dropped ones included; set before subscribe
+    void setPairObserver(const PairCallback &pair_observer) { observer = pair_observer; }
+
+    void pushLeft(const sensor_msgs::ImageConstPtr &msg) { push(msg, true); }
+
+    void pushRight(const sensor_msgs::ImageConstPtr &msg) { push(msg, false); }
+
+    /// Counters since start, rate since the previous call
+    riser_inspection::StereoPipelineStats getStats();
+};
+
+#endif //RISER_INSPECTION_STEREO_PAIR_MAILBOX_H
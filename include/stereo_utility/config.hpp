@@ -21,6 +21,8 @@ public:
 
   static void setParamFile(const std::string& file_name);
 
+  static std::string getParamFile() { return Config::instancePtr()->file_name_; }
+
   template <typename T>
   static T get(const std::string& key)
   {
@@ -34,6 +36,8 @@ private:
 
   cv::FileStorage file_;
 
+  std::string file_name_;
+
 };
 
 } // namespace M210_STEREO
@@ -0,0 +1,96 @@
+#ifndef ONBOARDSDK_CYLINDER_FITTER_H
+#define ONBOARDSDK_CYLINDER_FITTER_H
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace M210_STEREO {
+
+    //! Cylinder in the rectified left camera frame (x right, y down, z forward), metres
+    struct CylinderModel {
+        cv::Point3f axis_point;   // axis point closest to the camera
+        cv::Vec3f axis_direction; // unit vector
+        float radius = 0;
+        float distance = 0;       // from the camera to the cylinder surface
+        float rms = 0;            // residual of the inliers
+        int inliers = 0;
+        bool valid = false;
+    };
+
+    /** Fits the riser as a cylinder to the stereo points of one disparity map.
+     *  Points are reprojected with Q, the axis is either the camera vertical or the
+     *  principal direction of the points (inclined risers), a circle is fitted in the
+     *  plane normal to the axis by RANSAC and refined by Gauss-Newton. The point
+     *  reprojection and the RANSAC scoring run on OpenCV universal intrinsics. */
+    class CylinderFitter {
+    public:
+        typedef std::shared_ptr<CylinderFitter> Ptr;
+
+        CylinderFitter();
+
+        ~CylinderFitter();
+
+        static CylinderFitter::Ptr createCylinderFitter();
+
+        //! raw_disparity is the CV_16S StereoBM output (4 fractional bits), roi limits the search
+        CylinderModel fit(const cv::Mat &raw_disparity, const cv::Mat &Q, const cv::Rect &roi = cv::Rect());
+
+        inline void setDepthRange(float min_depth, float max_depth) {
+            min_depth_ = min_depth;
+            max_depth_ = max_depth;
+        }
+
+        inline void setRadiusRange(float min_radius, float max_radius) {
+            min_radius_ = min_radius;
+            max_radius_ = max_radius;
+        }
+
+        inline void setRansac(int iterations, float inlier_threshold) {
+            iterations_ = iterations;
+            inlier_threshold_ = inlier_threshold;
+        }
+
+        inline void setStride(int stride) { stride_ = std::max(1, stride); }
+
+        inline void setInclinedAxis(bool inclined) { inclined_axis_ = inclined; }
+
+        inline int getNumPoints() { return (int) px_.size(); }
+
+        inline double getFitTime() { return fit_time_; }
+
+    protected:
+        void reprojectPoints(const cv::Mat &raw_disparity, const cv::Mat &Q, const cv::Rect &roi);
+
+        cv::Vec3f estimateAxis();
+
+        void projectToPlane(const cv::Vec3f &axis);
+
+        int countInliers(float cx, float cy, float r);
+
+        bool refineCircle(float &cx, float &cy, float &r, float &rms, int &inliers);
+
+    protected:
+        //! Structure of arrays, the layout the vector loops want
+        std::vector<float> px_, py_, pz_;
+        //! Points in the plane normal to the axis
+        std::vector<float> u_, v_;
+        cv::Vec3f plane_u_, plane_v_;
+
+        std::mt19937 rng_;
+
+        float min_depth_ = 0.5f;
+        float max_depth_ = 15.0f;
+        float min_radius_ = 0.05f;
+        float max_radius_ = 1.0f;
+        float inlier_threshold_ = 0.03f;
+        int iterations_ = 200;
+        int stride_ = 2;
+        bool inclined_axis_ = false;
+        double fit_time_ = 0;
+    };
+
+} // namespace M210_STEREO
+
+#endif //ONBOARDSDK_CYLINDER_FITTER_H
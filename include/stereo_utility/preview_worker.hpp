@@ -0,0 +1,78 @@
+#ifndef ONBOARDSDK_PREVIEW_WORKER_H
+#define ONBOARDSDK_PREVIEW_WORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace M210_STEREO {
+
+    /** Optional HighGUI preview off the processing thread. Callers hand over a
+     *  downscaled copy of an image, at most rate times per second per window; only
+     *  the newest copy of each window is kept. A low priority thread owns the
+     *  windows, runs the drawing and the imshow / waitKey event loop. */
+    class PreviewWorker {
+    public:
+        typedef std::shared_ptr<PreviewWorker> Ptr;
+
+        //! Drawing on the downscaled copy, runs on the preview thread, returns the image to show
+        typedef std::function<cv::Mat(cv::Mat &image, double scale)> Render;
+
+        PreviewWorker(double rate, double scale);
+
+        ~PreviewWorker();
+
+        static PreviewWorker::Ptr createPreviewWorker(double rate, double scale);
+
+        //! True if no display is available, the default of the headless parameter
+        static bool noDisplay();
+
+        //! Run once on the preview thread before the first frame, e.g. windows and trackbars
+        inline void setSetup(std::function<void()> setup) { setup_ = setup; }
+
+        void start();
+
+        void stop();
+
+        //! Cheap check so callers skip preparing a frame that would be throttled away
+        bool wantsFrame(const std::string &window);
+
+        //! Never blocks on the display, returns false if the frame was throttled
+        bool show(const std::string &window, const cv::Mat &image, Render render = Render());
+
+        inline double getScale() { return scale_; }
+
+    protected:
+        typedef std::chrono::steady_clock clock;
+
+        struct Slot {
+            cv::Mat image;
+            Render render;
+            clock::time_point last;
+            bool fresh = false;
+        };
+
+        void run();
+
+        double period_;
+        double scale_;
+        std::function<void()> setup_;
+
+        std::map<std::string, Slot> slots_;
+        std::mutex slots_mutex_;
+        std::condition_variable frame_ready_;
+        std::atomic<bool> running_;
+        std::thread thread_;
+    };
+
+} // namespace M210_STEREO
+
+#endif //ONBOARDSDK_PREVIEW_WORKER_H
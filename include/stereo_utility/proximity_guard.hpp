@@ -0,0 +1,59 @@
+#ifndef ONBOARDSDK_PROXIMITY_GUARD_H
+#define ONBOARDSDK_PROXIMITY_GUARD_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace M210_STEREO {
+
+    /** Nearest depth in each sector of a rows x cols grid over the disparity map.
+     *  Bands of image rows are reduced in parallel into per-sector disparity
+     *  histograms, the nearest depth of a sector is the largest disparity backed by
+     *  at least min_pixels pixels, so isolated speckles do not stop the aircraft. */
+    class ProximityGuard {
+    public:
+        typedef std::shared_ptr<ProximityGuard> Ptr;
+
+        static const int DISPARITY_BINS = 256;
+
+        ProximityGuard(int cols, int rows);
+
+        ~ProximityGuard();
+
+        static ProximityGuard::Ptr createProximityGuard(int cols, int rows);
+
+        //! raw_disparity is the CV_16S StereoBM output, returns the depth of each sector in metres
+        std::vector<float> compute(const cv::Mat &raw_disparity, const cv::Mat &Q);
+
+        inline void setMinPixels(int min_pixels) { min_pixels_ = std::max(1, min_pixels); }
+
+        inline void setDepthRange(float min_depth, float max_depth) {
+            min_depth_ = min_depth;
+            max_depth_ = max_depth;
+        }
+
+        inline int getCols() { return cols_; }
+
+        inline int getRows() { return rows_; }
+
+        inline float getMaxDepth() { return max_depth_; }
+
+        inline double getComputeTime() { return compute_time_; }
+
+    protected:
+        int cols_;
+        int rows_;
+        int min_pixels_ = 50;
+        float min_depth_ = 0.3f;  // ignore anything closer, e.g. landing gear in view
+        float max_depth_ = 20.0f; // reported for sectors without valid disparity
+        double compute_time_ = 0;
+
+        std::vector<int> histogram_;
+        std::mutex histogram_mutex_;
+    };
+
+} // namespace M210_STEREO
+
+#endif //ONBOARDSDK_PROXIMITY_GUARD_H
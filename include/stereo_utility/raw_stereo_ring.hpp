@@ -0,0 +1,119 @@
+#ifndef ONBOARDSDK_RAW_STEREO_RING_H
+#define ONBOARDSDK_RAW_STEREO_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "frame.hpp"
+
+namespace M210_STEREO {
+
+    static const uint32_t RAW_RING_MAGIC = 0x52535452; // "RTSR"
+    static const size_t RAW_RING_PAGE = 4096;
+
+    //! First page of the ring file
+    struct RawRingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint64_t slots;
+        uint64_t slot_bytes;
+        uint64_t written;   // pairs written since the file was created
+    };
+
+    //! Start of every slot, followed by the left then the right 8 bit image
+    struct RawRingSlot {
+        uint64_t sequence;  // 1 based write order, 0 while empty or being written
+        double stamp_left;
+        double stamp_right;
+        uint32_t seq_left;
+        uint32_t seq_right;
+    };
+
+    /** Black box of the raw VGA pairs: a preallocated ring file of fixed duration
+     *  mapped in memory. A pair is two memcpy into its slot, no allocation and no
+     *  encoding, the kernel writes the dirty pages back. A slot is marked valid only
+     *  after its images, so the file survives a crash of this process at any point.
+     *  The kernel writes the pages back in no particular order: after a power loss or
+     *  a kernel crash only the pairs written before the last completed flush() are
+     *  sure to be whole, later slots may hold a sequence without its images. */
+    class RawStereoRing {
+    public:
+        typedef std::shared_ptr<RawStereoRing> Ptr;
+
+        RawStereoRing();
+
+        ~RawStereoRing();
+
+        //! Null if the file cannot be created or mapped, the whole file is allocated up front
+        static RawStereoRing::Ptr createRawStereoRing(const std::string &file, size_t slots,
+                                                      int width = VGA_WIDTH, int height = VGA_HEIGHT);
+
+        //! Called from one thread, false while frozen or for images of another size
+        bool write(const uint8_t *left, const uint8_t *right, double stamp_left, double stamp_right,
+                   uint32_t seq_left, uint32_t seq_right);
+
+        //! Starts writing the ring back to disk on a background thread, never blocks the caller
+        void flush();
+
+        //! A frozen ring keeps its content, e.g. from landing until the next take-off
+        inline void setFrozen(bool frozen) { frozen_ = frozen; }
+
+        inline bool isFrozen() { return frozen_; }
+
+        inline uint64_t getWritten() { return header_->written; }
+
+        inline size_t getSlots() { return slots_; }
+
+    protected:
+        bool open(const std::string &file, size_t slots, int width, int height);
+
+        int fd_ = -1;
+        uint8_t *map_ = nullptr;
+        size_t map_bytes_ = 0;
+        RawRingHeader *header_ = nullptr;
+        size_t slots_ = 0;
+        size_t slot_bytes_ = 0;
+        size_t image_bytes_ = 0;
+
+        std::atomic<bool> frozen_;
+        std::atomic<bool> flushing_;
+        std::thread flusher_;
+        std::mutex flush_mutex_;
+    };
+
+    //! Read side of a ring file, pairs in write order, images view the mapping (no copy)
+    class RawStereoRingReader {
+    public:
+        typedef std::shared_ptr<RawStereoRingReader> Ptr;
+
+        ~RawStereoRingReader();
+
+        //! Null if the file is not a complete ring file
+        static RawStereoRingReader::Ptr createRawStereoRingReader(const std::string &file);
+
+        inline size_t size() { return order_.size(); }
+
+        //! Valid while the reader lives, copy the images to keep them longer
+        bool read(size_t index, cv::Mat &left, cv::Mat &right, RawRingSlot &slot);
+
+        inline const RawRingHeader &getHeader() { return *header_; }
+
+    protected:
+        bool open(const std::string &file);
+
+        uint8_t *map_ = nullptr;
+        size_t map_bytes_ = 0;
+        const RawRingHeader *header_ = nullptr;
+        std::vector<size_t> order_;  // slot of each pair, oldest first
+    };
+
+} // namespace M210_STEREO
+
+#endif //ONBOARDSDK_RAW_STEREO_RING_H
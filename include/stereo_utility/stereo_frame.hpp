@@ -1,7 +1,11 @@
 #ifndef ONBOARDSDK_STEREO_FRAME_H
 #define ONBOARDSDK_STEREO_FRAME_H
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <opencv2/opencv.hpp>
 #include "frame.hpp"
 #include "camera_param.hpp"
@@ -14,6 +18,19 @@
 
 namespace M210_STEREO {
 
+    //! Everything derived from one calibration, built off the pipeline and swapped in as a whole
+    struct StereoCalibration {
+        typedef std::shared_ptr<StereoCalibration> Ptr;
+
+        std::string file;
+        cv::Mat rect_left, rect_right, proj_left, proj_right;
+        cv::Mat rot_stereo, tran_stereo, q;
+        cv::Mat mapping[2][2];
+        cv::Ptr<cv::StereoBM> block_matcher;
+        cv::Ptr<cv::ximgproc::DisparityWLSFilter> wls_filter;
+        cv::Ptr<cv::StereoMatcher> right_matcher;
+    };
+
     class StereoFrame {
     public:
         typedef std::shared_ptr<StereoFrame> Ptr;
@@ -28,12 +45,24 @@ namespace M210_STEREO {
 
         void readStereoImgs(const sensor_msgs::ImageConstPtr &img_left, const sensor_msgs::ImageConstPtr &img_right);
 
+        //! Offline replay of 8 bit VGA pairs, e.g. from RawStereoRingReader
+        void readStereoImgs(const cv::Mat &img_left, const cv::Mat &img_right, uint64_t id, uint32_t time_stamp);
+
         void rectifyImgs();
 
         void computeDisparityMap();
 
         void filterDisparityMap();
 
+        //! Rebuild maps and matcher for a calibration YAML on a background thread, they replace
+        //! the current ones before the next rectifyImgs. False if the file cannot be used or a
+        //! load is still running.
+        bool loadCalibration(const std::string &file, std::string &message);
+
+        inline bool isCalibrationLoading() { return this->calibration_loading_; }
+
+        std::string getCalibrationFile();
+
 
         inline cv::Mat getRectLeftImg() { return this->rectified_img_left_; }
 
@@ -43,6 +72,15 @@ namespace M210_STEREO {
 
         inline cv::Mat getFilteredDispMap() { return this->filtered_disparity_map_8u_; }
 
+        //! StereoBM output, CV_16S with 4 fractional bits
+        inline cv::Mat getRawDisparityMap() { return this->raw_disparity_map_; }
+
+        //! WLS filtered disparity, same scale as getRawDisparityMap
+        inline cv::Mat getRawFilteredDispMap() { return this->filtered_disparity_map_; }
+
+        //! Disparity-to-depth mapping of the rectified pair
+        inline cv::Mat getQ() { return this->param_q_; }
+
         inline int getNumDisparities() { return this->block_matcher_->getNumDisparities(); }
 
         inline int getMinDisparity() { return this->block_matcher_->getMinDisparity(); }
@@ -56,6 +94,13 @@ namespace M210_STEREO {
     protected:
         bool initStereoParam();
 
+        StereoCalibration::Ptr buildCalibration(const cv::Mat &intrinsic_left, const cv::Mat &dist_left,
+                                                const cv::Mat &intrinsic_right, const cv::Mat &dist_right,
+                                                const cv::Mat &rot_stereo, const cv::Mat &tran_stereo);
+
+        //! Pipeline thread only, between two frames
+        void applyCalibration(const StereoCalibration::Ptr &calibration);
+
     protected:
         //! Image frames
         Frame::Ptr frame_left_ptr_;
@@ -72,6 +117,7 @@ namespace M210_STEREO {
         cv::Mat param_proj_right_;
         cv::Mat param_rot_stereo_;
         cv::Mat param_tran_stereo_;
+        cv::Mat param_q_;
 
         cv::Mat rectified_mapping_[2][2];
 
@@ -103,6 +149,14 @@ namespace M210_STEREO {
         int speckleRange = 30;
         int speckleWindowSize = 16;
         int disp12MaxDiff = -1;
+
+        //! Calibration hot reload
+        std::string calibration_file_;
+        StereoCalibration::Ptr pending_calibration_;
+        std::mutex calibration_mutex_;
+        std::atomic<bool> calibration_pending_;
+        std::atomic<bool> calibration_loading_;
+        std::thread calibration_loader_;
     };
 
 } // namespace M210_STEREO
@@ -0,0 +1,110 @@
+/** @file telemetry_log.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Stamped telemetry logs with a sparse time index. The recorders write a tab
+ *  separated text file whose first column is the header stamp of the row and,
+ *  next to it, <log>.idx with the stamp and byte offset of every Nth row.
+ *  TelemetryLog answers "state at time t" (interpolated between the two rows
+ *  around t) and "rows in [t0, t1]" with a binary search on the index and a
+ *  scan of at most N rows of the memory-mapped log, nothing is loaded up front.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_TELEMETRY_LOG_H
+#define RISER_INSPECTION_TELEMETRY_LOG_H
+
+#include <delimited_reader.hh>
+
+// System includes
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+static const uint32_t TELEMETRY_INDEX_MAGIC = 0x58444954; // "TIDX"
+
+struct TelemetryIndexEntry {
+    double stamp;
+    uint64_t offset;
+};
+
+class TelemetryLogWriter {
+private:
+    FILE *log = nullptr;
+    FILE *index = nullptr;
+    uint64_t offset = 0;
+    uint64_t rows = 0;
+    uint32_t index_every = 64;
+    double last_indexed = -1e300;
+    size_t columns = 0;
+
+    bool writeRow(double stamp, const std::vector<double> &values, const std::string *text);
+
+public:
+    ~TelemetryLogWriter();
+
+    /// Creates <path> with the header "stamp<TAB>columns..." and <path>.idx, a row in every index_every is indexed
+    bool open(const std::string &path, const std::vector<std::string> &names, uint32_t every = 64);
+
+    bool isOpen() const { return log != nullptr; }
+
+    /// One row, values in the order of the names given to open
+    bool append(double stamp, const std::vector<double> &values);
+
+    /// One row whose last column is text (a file name), tabs and line breaks in it are replaced
+    bool append(double stamp, const std::vector<double> &values, const std::string &text);
+
+    void flush();
+
+    void close();
+};
+
+class TelemetryLog {
+private:
+    DelimitedReader reader;
+    std::vector<TelemetryIndexEntry> entries;
+    std::vector<std::string> names;
+    std::vector<bool> angle;
+    size_t first_row = 0;
+    double max_gap = 1.0;                // s between the rows around t
+    std::vector<double> row, previous;
+
+    bool readRow(double &stamp, std::vector<double> &values);
+
+    /// Reader at the last indexed row not after t
+    void locate(double t);
+
+    bool buildIndex(const std::string &index_path);
+
+public:
+    /// Maps the log and loads <path>.idx, building and saving it first if it is missing
+    bool open(const std::string &path);
+
+    /// Value columns, without the stamp
+    const std::vector<std::string> &getNames() const { return names; }
+
+    int column(const std::string &name) const;
+
+    /// Degrees, interpolated over the shortest arc (e.g. yaw across +-180)
+    void setAngleColumn(const std::string &name);
+
+    /// Rows further apart than gap are a dropout, no value is interpolated across them
+    void setMaxGap(double gap) { max_gap = gap; }
+
+    /// Every value column at t, linear between the rows around t. False outside the log or in a dropout.
+    bool at(double t, std::vector<double> &values);
+
+    /// Calls row for every row with t0 <= stamp <= t1, returns how many
+    size_t range(double t0, double t1, const std::function<void(double, const std::vector<double> &)> &visit);
+
+    double getStart();
+
+    double getEnd();
+};
+
+#endif //RISER_INSPECTION_TELEMETRY_LOG_H
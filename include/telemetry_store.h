@@ -0,0 +1,141 @@
+/** @file telemetry_store.h
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Lock-free telemetry snapshot shared in-process by the mission executor,
+ *  the capture scheduler and recorders. Writers are serialized, readers never
+ *  block and always get every field from the same consistent state (seqlock).
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef RISER_INSPECTION_TELEMETRY_STORE_H
+#define RISER_INSPECTION_TELEMETRY_STORE_H
+
+// System includes
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+
+/// Plain copyable state, angles in degrees, local position ENU in metres
+struct TelemetrySnapshot {
+    double gps_stamp = 0;
+    double latitude = 0;
+    double longitude = 0;
+    double altitude = 0;
+
+    double local_stamp = 0;
+    double x = 0, y = 0, z = 0;
+
+    float height = 0;
+
+    double attitude_stamp = 0;
+    double qw = 1, qx = 0, qy = 0, qz = 0; // raw FLU body w.r.t. ENU ground
+    double roll = 0, pitch = 0, yaw = 0;   // body frame after the axis swap
+    double heading = 0;                    // degrees from north, clockwise (= -yaw)
+};
+
+/// Single-writer seqlock around a trivially copyable value
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+private:
+    std::atomic<uint32_t> sequence_{0};
+    T data_;
+
+public:
+    template<typename Fn>
+    void write(Fn &&update) {
+        uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        update(data_);
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T copy;
+        uint32_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            copy = data_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1u) || before != after);
+        return copy;
+    }
+};
+
+class TelemetryStore {
+private:
+    SeqLock<TelemetrySnapshot> snapshot_;
+    std::mutex write_mutex_; // callbacks of different topics may run concurrently on the AsyncSpinner
+
+public:
+    void setGPS(double stamp, double lat, double lon, double alt) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        snapshot_.write([&](TelemetrySnapshot &s) {
+            s.gps_stamp = stamp;
+            s.latitude = lat;
+            s.longitude = lon;
+            s.altitude = alt;
+        });
+    }
+
+    void setLocalPosition(double stamp, double x, double y, double z) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        snapshot_.write([&](TelemetrySnapshot &s) {
+            s.local_stamp = stamp;
+            s.x = x;
+            s.y = y;
+            s.z = z;
+        });
+    }
+
+    void setHeight(float height) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        snapshot_.write([&](TelemetrySnapshot &s) { s.height = height; });
+    }
+
+    /** Store the DJI attitude and precompute the body-frame Euler angles.
+     *  The fixed axis swap {0,-1,0; -1,0,0; 0,0,-1} is a half turn about (1,-1,0)/sqrt(2),
+     *  so it is applied as a quaternion product instead of rebuilding rotation matrices. */
+    void setAttitude(double stamp, double w, double x, double y, double z) {
+        const double k = M_SQRT1_2;
+        //! q * (0, k, -k, 0)
+        double bw = -x * k + y * k;
+        double bx = w * k + z * k;
+        double by = -w * k + z * k;
+        double bz = -x * k - y * k;
+
+        double sinp = 2 * (bw * by - bz * bx);
+        sinp = sinp > 1 ? 1 : (sinp < -1 ? -1 : sinp);
+        double roll = atan2(2 * (bw * bx + by * bz), 1 - 2 * (bx * bx + by * by)) * 180 / M_PI;
+        double pitch = asin(sinp) * 180 / M_PI;
+        double yaw = atan2(2 * (bw * bz + bx * by), 1 - 2 * (by * by + bz * bz)) * 180 / M_PI;
+
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        snapshot_.write([&](TelemetrySnapshot &s) {
+            s.attitude_stamp = stamp;
+            s.qw = w;
+            s.qx = x;
+            s.qy = y;
+            s.qz = z;
+            s.roll = roll;
+            s.pitch = pitch;
+            s.yaw = yaw;
+            s.heading = -yaw;
+        });
+    }
+
+    /// Consistent copy of every field, never blocks the writers
+    TelemetrySnapshot snapshot() const {
+        return snapshot_.read();
+    }
+};
+
+#endif //RISER_INSPECTION_TELEMETRY_STORE_H
@@ -0,0 +1,76 @@
+/** @file trajectory_generator.hh
+ *  @author Daniel Regner
+ *  @version 1.0
+ *  @date Oct, 2026
+ *
+ *  @brief
+ *  Smooth time-parameterized trajectory through the inspection waypoints, used
+ *  by the continuous mission mode. Geometry is a centripetal Catmull-Rom spline,
+ *  the speed profile respects speed, acceleration and lateral acceleration limits.
+ *
+ *  @copyright 2021 VANT3D. All rights reserved.
+ */
+
+#ifndef TRAJECTORY_GEN_H
+#define TRAJECTORY_GEN_H
+
+// System includes
+#include <cmath>
+#include <vector>
+
+/// Reference state along the trajectory, position in metres (north, east, up) and yaw in degrees
+struct TrajectoryPoint {
+    double t = 0;
+    double s = 0;
+    double x = 0, y = 0, z = 0;
+    double vx = 0, vy = 0, vz = 0;
+    double yaw = 0;
+};
+
+class TrajectoryGenerator {
+private:
+    double max_speed_ = 1.0;         // m/s
+    double max_accel_ = 0.5;         // m/s^2
+    double max_lateral_accel_ = 0.5; // m/s^2
+    double resolution_ = 0.05;       // m between table samples
+
+    std::vector<TrajectoryPoint> table_;
+    std::vector<double> waypoint_s_;
+    std::vector<double> waypoint_yaw_;
+
+    double yawAt(double s) const;
+
+public:
+    TrajectoryGenerator();
+
+    ~TrajectoryGenerator();
+
+    void setLimits(double max_speed, double max_accel, double max_lateral_accel);
+
+    void setResolution(double resolution);
+
+    /** Build the trajectory through absolute waypoints {x, y, z, yaw}.
+     *  Starts and ends at rest. Returns false when fewer than two distinct points are given. */
+    bool generate(const std::vector<std::vector<float>> &waypoints);
+
+    TrajectoryPoint sample(double t) const;
+
+    double getDuration() const;
+
+    double getLength() const;
+
+    /// Time at which waypoint k is passed
+    double getWaypointTime(int k) const;
+
+    /// Arc length at which each waypoint is passed
+    const std::vector<double> &getWaypointArcs() const { return waypoint_s_; }
+
+    /** Point of the path closest to a measured position (x, y, z), searched within window
+     *  metres of arc length around s_hint so a serpentine path never snaps to a neighbouring leg. */
+    TrajectoryPoint project(double x, double y, double z, double s_hint, double window) const;
+
+    /// Cumulative sum of relative waypoints {wp, dx, dy, dz, yaw} into absolute {x, y, z, yaw}
+    static std::vector<std::vector<float>> toAbsolute(const std::vector<std::vector<float>> &delta_waypoints);
+};
+
+#endif // TRAJECTORY_GEN_H
@@ -0,0 +1,56 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Checks that a descending catenary pass flies the ascending one backwards: same poses relative
+// to the end they start from, same yaw and pitch, steep first and level at the low point. Both
+// progress towards the azimuth, so the ascending pass is laid out the opposite way.
+//
+
+#include <axis_path_generator.hh>
+#include <cmath>
+#include <cstdio>
+
+int main() {
+    const double span = 40, rise = 25, heading = 30;
+    AxisPathGenerator up, down;
+    up.setCatenary(span, rise, 270);
+    up.setInspectionParam(5, 0.3, 1, 15, 0.3);
+    if (!up.start(heading)) { return 1; }
+    //! Rings on both ends of the axis, so ring k going down is ring n - k going up
+    const int intervals = 200;
+    const double spacing = up.getAxisLength() / intervals;
+    up.setInspectionParam(5, 0.3, 1, 15, spacing);
+    down.setCatenary(span, -rise, 90);
+    down.setInspectionParam(5, 0.3, 1, 15, spacing);
+    if (!up.start(heading) || !down.start(heading) || up.size() != down.size() || up.size() != intervals + 1) {
+        printf("Unexpected ring count %zu / %zu\n", up.size(), down.size());
+        return 1;
+    }
+
+    std::vector<AxisWaypoint> ascending, descending;
+    up.next(up.size(), ascending);
+    down.next(down.size(), descending);
+    const AxisWaypoint &top = ascending.back(), &start = descending.front();
+    int failures = 0;
+    double worst = 0;
+    for (int k = 0; k <= intervals; k++) {
+        const AxisWaypoint &a = ascending[intervals - k], &d = descending[k];
+        double error = std::max(std::max(fabs((d.x - start.x) - (a.x - top.x)), fabs((d.y - start.y) - (a.y - top.y))),
+                                fabs((d.z - start.z) - (a.z - top.z)));
+        worst = std::max(worst, error);
+        if (error > 1e-6 || fabs(d.pitch - a.pitch) > 1e-6 || fabs(std::remainder(d.yaw - a.yaw, 360.0)) > 1e-6) {
+            if (failures++ < 5) {
+                printf("Ring %i: %.3g m off, pitch %.2f / %.2f, yaw %.2f / %.2f\n", k, error, d.pitch, a.pitch,
+                       d.yaw, a.yaw);
+            }
+        }
+    }
+    //! The descent ends rise metres below its start, on the level low point
+    const AxisWaypoint &end = descending.back();
+    if (fabs(end.z - start.z + rise) > 1e-6 || fabs(end.pitch) > 1e-6) {
+        printf("Descent ends %.3f m below its start, pitch %.2f\n", start.z - end.z, end.pitch);
+        failures++;
+    }
+    printf("%d rings, worst position error %.3g m, %d failures\n", intervals + 1, worst, failures);
+    return failures == 0 ? 0 : 1;
+}
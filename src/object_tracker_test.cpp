@@ -0,0 +1,76 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Checks ObjectTracker::assign against an exhaustive search on random gated cost matrices:
+// the same number of pairs and the same total cost. Returns non-zero on any mismatch.
+//
+
+#include <object_tracker.h>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+/// Best (pairs, cost) over every partial matching of rows from row on
+void bruteForce(const std::vector<std::vector<double>> &cost, double gate, size_t row, std::vector<bool> &used,
+                int pairs, double total, int &best_pairs, double &best_total) {
+    if (row == cost.size()) {
+        if (pairs > best_pairs || (pairs == best_pairs && total < best_total)) {
+            best_pairs = pairs;
+            best_total = total;
+        }
+        return;
+    }
+    bruteForce(cost, gate, row + 1, used, pairs, total, best_pairs, best_total);
+    for (size_t col = 0; col < cost[row].size(); col++) {
+        if (used[col] || cost[row][col] >= gate) { continue; }
+        used[col] = true;
+        bruteForce(cost, gate, row + 1, used, pairs + 1, total + cost[row][col], best_pairs, best_total);
+        used[col] = false;
+    }
+}
+
+int main() {
+    const double gate = 60;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> size(1, 4);
+    std::uniform_real_distribution<double> value(0, gate);
+    std::uniform_real_distribution<double> chance(0, 1);
+
+    const int trials = 200000;
+    int failures = 0;
+    for (int trial = 0; trial < trials; trial++) {
+        const size_t rows = (size_t) size(random), cols = (size_t) size(random);
+        std::vector<std::vector<double>> cost(rows, std::vector<double>(cols));
+        for (auto &row : cost) {
+            for (double &c : row) { c = chance(random) < 1.0 / 3 ? gate : std::floor(value(random)); }
+        }
+
+        std::vector<int> result = ObjectTracker::assign(cost, gate);
+        std::vector<bool> taken(cols, false);
+        int pairs = 0;
+        double total = 0;
+        bool valid = result.size() == rows;
+        for (size_t i = 0; valid && i < rows; i++) {
+            int j = result[i];
+            if (j < 0) { continue; }
+            valid = j < (int) cols && !taken[j] && cost[i][j] < gate;
+            if (!valid) { break; }
+            taken[j] = true;
+            pairs++;
+            total += cost[i][j];
+        }
+
+        std::vector<bool> used(cols, false);
+        int best_pairs = -1;
+        double best_total = 0;
+        bruteForce(cost, gate, 0, used, 0, 0, best_pairs, best_total);
+        if (!valid || pairs != best_pairs || fabs(total - best_total) > 1e-9) {
+            if (failures++ < 5) {
+                printf("trial %i: %zux%zu assigned %i pairs cost %.0f, best %i pairs cost %.0f\n", trial, rows, cols,
+                       pairs, total, best_pairs, best_total);
+            }
+        }
+    }
+    printf("%i of %i assignments differ from the exhaustive search\n", failures, trials);
+    return failures == 0 ? 0 : 1;
+}
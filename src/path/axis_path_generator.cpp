@@ -0,0 +1,224 @@
+#include <axis_path_generator.hh>
+#include <path_generator.hh>
+#include <algorithm>
+#include <cstdio>
+
+AxisPathGenerator::AxisPathGenerator() = default;
+
+AxisPathGenerator::~AxisPathGenerator() = default;
+
+void AxisPathGenerator::setLine(double length, double inclination, double azimuth) {
+    shape_ = AxisShape::LINE;
+    length_ = length;
+    inclination_ = inclination;
+    azimuth_ = azimuth;
+}
+
+void AxisPathGenerator::setCatenary(double span, double height, double azimuth) {
+    shape_ = AxisShape::CATENARY;
+    length_ = span;
+    height_ = height;
+    azimuth_ = azimuth;
+}
+
+void AxisPathGenerator::setInspectionParam(double standoff, double diameter, int ring_points, double ring_step,
+                                           double spacing) {
+    standoff_ = standoff;
+    radius_ = diameter / 2;
+    ring_points_ = ring_points;
+    ring_step_ = ring_step;
+    spacing_ = spacing;
+}
+
+bool AxisPathGenerator::start(double heading) {
+    heading_ = heading;
+    rings_ = 0;
+    if (spacing_ <= 0 || ring_points_ < 1) { return false; }
+
+    if (shape_ == AxisShape::LINE) {
+        climb_ = length_ < 0 ? -1 : 1;
+        axis_length_ = fabs(length_);
+    } else {
+        //! a (cosh(span / a) - 1) = height has one root, the left side falls as a grows
+        const double span = fabs(length_), rise = fabs(height_);
+        if (span <= 0 || rise <= 0) { return false; }
+        climb_ = height_ < 0 ? -1 : 1;
+        double low = span / 700, high = span;
+        while (high * (cosh(span / high) - 1) > rise) { high *= 2; }
+        for (int i = 0; i < 200 && high - low > 1e-12 * high; i++) {
+            double a = 0.5 * (low + high);
+            if (a * (cosh(span / a) - 1) > rise) { low = a; } else { high = a; }
+        }
+        catenary_a_ = 0.5 * (low + high);
+        axis_length_ = catenary_a_ * sinh(span / catenary_a_);
+    }
+    rings_ = (int) floor(axis_length_ / spacing_ + 1e-9) + 1;
+
+    //! Ring angles centred on the start heading, the same for every ring
+    ring_cos_.resize(ring_points_);
+    ring_sin_.resize(ring_points_);
+    for (int j = 0; j < ring_points_; j++) {
+        double angle = DEG2RAD((j - (ring_points_ - 1) / 2.0) * ring_step_);
+        ring_cos_[j] = cos(angle);
+        ring_sin_[j] = sin(angle);
+    }
+    front_[0] = cos(DEG2RAD(heading_));
+    front_[1] = sin(DEG2RAD(heading_));
+    progression_[0] = cos(DEG2RAD(heading_ + azimuth_));
+    progression_[1] = sin(DEG2RAD(heading_ + azimuth_));
+    origin_[0] = (standoff_ + radius_) * front_[0];
+    origin_[1] = (standoff_ + radius_) * front_[1];
+    origin_[2] = 0;
+    rewind();
+    return true;
+}
+
+void AxisPathGenerator::rewind() {
+    next_ = 0;
+    frame_ring_ = -1;
+    last_[0] = last_[1] = last_[2] = 0;
+    last_yaw_ = heading_;
+}
+
+void AxisPathGenerator::axisAt(double s, double point[3], double tangent[3]) const {
+    const double north = progression_[0], east = progression_[1];
+    double horizontal, vertical, d_horizontal, d_vertical;
+    if (shape_ == AxisShape::LINE) {
+        d_horizontal = sin(DEG2RAD(inclination_));
+        d_vertical = climb_ * cos(DEG2RAD(inclination_));
+        horizontal = s * d_horizontal;
+        vertical = s * d_vertical;
+    } else {
+        //! Closed form by arc length u from the low point: x = a asinh(u / a), z = sqrt(a^2 + u^2) - a
+        const double a = catenary_a_;
+        auto x = [a](double u) { return a * asinh(u / a); };
+        auto z = [a](double u) { return sqrt(a * a + u * u) - a; };
+        //! Going down the same riser walks it from its top end, steep first and flattening at the low point
+        const double u = climb_ > 0 ? s : axis_length_ - s, r = sqrt(a * a + u * u);
+        if (climb_ > 0) {
+            horizontal = x(u);
+            vertical = z(u);
+        } else {
+            horizontal = x(axis_length_) - x(u);
+            vertical = z(u) - z(axis_length_);
+        }
+        d_horizontal = a / r;
+        d_vertical = climb_ * u / r;
+    }
+    point[0] = origin_[0] + horizontal * north;
+    point[1] = origin_[1] + horizontal * east;
+    point[2] = origin_[2] + vertical;
+    tangent[0] = d_horizontal * north;
+    tangent[1] = d_horizontal * east;
+    tangent[2] = d_vertical;
+}
+
+void AxisPathGenerator::ringFrame(int ring) {
+    double t[3];
+    axisAt(std::min(ring * spacing_, axis_length_), centre_, t);
+
+    //! n points from the axis to the start side, b = t x n
+    double *n = normal_;
+    n[0] = -front_[0];
+    n[1] = -front_[1];
+    n[2] = 0;
+    double along = n[0] * t[0] + n[1] * t[1];
+    for (int i = 0; i < 3; i++) { n[i] -= along * t[i]; }
+    double norm = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (norm < 1e-6) {
+        //! Axis runs straight at the drone, look at it from above instead
+        n[0] = -t[2] * t[0];
+        n[1] = -t[2] * t[1];
+        n[2] = 1 - t[2] * t[2];
+        norm = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    }
+    for (int i = 0; i < 3; i++) { n[i] /= norm; }
+    binormal_[0] = t[1] * n[2] - t[2] * n[1];
+    binormal_[1] = t[2] * n[0] - t[0] * n[2];
+    binormal_[2] = t[0] * n[1] - t[1] * n[0];
+    frame_ring_ = ring;
+}
+
+AxisWaypoint AxisPathGenerator::pose(size_t k) {
+    AxisWaypoint wp;
+    wp.ring = (int) (k / ring_points_);
+    int j = (int) (k % ring_points_);
+    //! Serpentine, odd rings are swept back so consecutive poses stay one step apart
+    if (wp.ring % 2 == 1) { j = ring_points_ - 1 - j; }
+    wp.s = std::min(wp.ring * spacing_, axis_length_);
+    if (wp.ring != frame_ring_) { ringFrame(wp.ring); }
+
+    const double r = standoff_ + radius_;
+    double o[3];
+    for (int i = 0; i < 3; i++) { o[i] = ring_cos_[j] * normal_[i] + ring_sin_[j] * binormal_[i]; }
+    wp.x = centre_[0] + r * o[0];
+    wp.y = centre_[1] + r * o[1];
+    wp.z = centre_[2] + r * o[2];
+
+    //! The camera looks back along -o, onto the surface
+    const double level = std::hypot(o[0], o[1]);
+    if (level > 1e-3) { last_yaw_ = RAD2DEG(atan2(-o[1], -o[0])); }
+    //! Adding 0 turns -0 into 0, the exported legs then read as plain zeros
+    wp.yaw = last_yaw_ + 0.0;
+    wp.pitch = RAD2DEG(atan2(-o[2], level)) + 0.0;
+    return wp;
+}
+
+size_t AxisPathGenerator::next(size_t max_count, std::vector<AxisWaypoint> &chunk) {
+    size_t count = std::min(max_count, remaining());
+    chunk.reserve(chunk.size() + count);
+    for (size_t i = 0; i < count; i++) { chunk.push_back(pose(next_++)); }
+    if (count > 0) {
+        last_[0] = chunk.back().x;
+        last_[1] = chunk.back().y;
+        last_[2] = chunk.back().z;
+    }
+    return count;
+}
+
+size_t AxisPathGenerator::nextRelative(size_t max_count, std::vector<std::vector<float>> &waypoints) {
+    double previous[3] = {last_[0], last_[1], last_[2]};
+    size_t first = next_;
+    std::vector<AxisWaypoint> chunk;
+    size_t count = next(max_count, chunk);
+    waypoints.reserve(waypoints.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        const AxisWaypoint &wp = chunk[i];
+        waypoints.push_back({(float) (first + i + 1), (float) (wp.x - previous[0]), (float) (wp.y - previous[1]),
+                             (float) (wp.z - previous[2]), (float) wp.yaw, (float) wp.pitch});
+        previous[0] = wp.x;
+        previous[1] = wp.y;
+        previous[2] = wp.z;
+    }
+    return count;
+}
+
+bool AxisPathGenerator::saveRelative(const std::string &file, size_t chunk_size) {
+    FILE *out = fopen(file.c_str(), "w");
+    if (out == nullptr) { return false; }
+    fprintf(out, "WP,X,Y,Z,Yaw,Pitch\n");
+    std::vector<AxisWaypoint> chunk;
+    double previous[3] = {last_[0], last_[1], last_[2]};
+    while (!done()) {
+        size_t first = next_;
+        chunk.clear();
+        next(chunk_size, chunk);
+        for (size_t i = 0; i < chunk.size(); i++) {
+            const AxisWaypoint &wp = chunk[i];
+            fprintf(out, "%zu,%.4f,%.4f,%.4f,%.2f,%.2f\n", first + i + 1, wp.x - previous[0], wp.y - previous[1],
+                    wp.z - previous[2], wp.yaw, wp.pitch);
+            previous[0] = wp.x;
+            previous[1] = wp.y;
+            previous[2] = wp.z;
+        }
+    }
+    return fclose(out) == 0;
+}
+
+AxisShape AxisPathGenerator::parseShape(const std::string &name, bool &valid) {
+    valid = true;
+    if (name == "line") { return AxisShape::LINE; }
+    if (name == "catenary") { return AxisShape::CATENARY; }
+    valid = false;
+    return AxisShape::LINE;
+}
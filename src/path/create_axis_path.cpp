@@ -0,0 +1,55 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Generates an axis path for a long or curved riser, reports the generation time and writes
+// the legs as WP,X,Y,Z,Yaw,Pitch.
+//
+//   axis_path_generator line <length m> <inclination deg> [csv]
+//   axis_path_generator catenary <span m> <height m> [csv]
+//
+
+#include <axis_path_generator.hh>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " line <length> <inclination> [csv] | catenary <span> <height> [csv]\n";
+        return -1;
+    }
+    bool valid;
+    AxisShape shape = AxisPathGenerator::parseShape(argv[1], valid);
+    if (!valid) {
+        std::cerr << "Unknown axis " << argv[1] << "\n";
+        return -1;
+    }
+    AxisPathGenerator riser;
+    if (shape == AxisShape::LINE) { riser.setLine(atof(argv[2]), atof(argv[3]), 90); }
+    else { riser.setCatenary(atof(argv[2]), atof(argv[3]), 90); }
+    riser.setInspectionParam(5, 0.3, 7, 15, 0.3);
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point begin = clock::now();
+    if (!riser.start(0)) {
+        std::cerr << "No path for this axis\n";
+        return -1;
+    }
+    //! Same chunks the executor asks for in flight
+    std::vector<std::vector<float>> legs;
+    size_t chunks = 0;
+    while (riser.nextRelative(200, legs) > 0) { chunks++; }
+    double elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+
+    std::cout << legs.size() << " waypoints along " << riser.getAxisLength() << " m of axis in " << chunks
+              << " chunks, " << elapsed * 1e3 << " ms\n";
+    if (argc > 4) {
+        riser.rewind();
+        if (!riser.saveRelative(argv[4])) {
+            std::cerr << "Cannot write " << argv[4] << "\n";
+            return -1;
+        }
+        std::cout << "Waypoints saved to " << argv[4] << "\n";
+    }
+    return 0;
+}
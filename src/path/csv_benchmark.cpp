@@ -0,0 +1,100 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Reads a delimited file with the former read_csv (getline + boost::algorithm::split + stod
+// on every cell) and with DelimitedReader, and compares time and the sum of every numeric cell.
+//
+//   csv_benchmark [file] [delimiter]    without a file, a 200 MB telemetry-like log is generated
+//
+
+#include <delimited_reader.hh>
+#include <path_generator.hh>
+#include <boost/algorithm/string.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+double legacySum(const std::string &file, const std::string &delimiter, size_t &rows) {
+    std::ifstream input(file);
+    std::vector<std::vector<std::string>> data_list;
+    std::string line;
+    while (getline(input, line)) {
+        std::vector<std::string> vec;
+        boost::algorithm::split(vec, line, boost::is_any_of(delimiter));
+        data_list.push_back(vec);
+    }
+    double sum = 0;
+    rows = 0;
+    for (size_t k = 1; k < data_list.size(); k++) {
+        for (const std::string &cell : data_list[k]) {
+            try {
+                sum += std::stod(cell);
+            } catch (std::exception &) {}
+        }
+        rows++;
+    }
+    return sum;
+}
+
+double readerSum(const std::string &file, const std::string &delimiter, size_t &rows) {
+    DelimitedReader reader;
+    if (!reader.open(file, delimiter)) { return 0; }
+    double sum = 0, value;
+    rows = 0;
+    while (reader.next()) {
+        for (size_t i = 0; i < reader.size(); i++) {
+            if (reader.getDouble(i, value)) { sum += value; }
+        }
+        rows++;
+    }
+    return sum;
+}
+
+void generate(const std::string &file, size_t bytes) {
+    FILE *out = fopen(file.c_str(), "w");
+    fprintf(out, "stamp\tlatitude\tlongitude\taltitude\tx\ty\tz\troll\tpitch\tyaw\n");
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> noise(-1, 1);
+    double stamp = 1697700000.0;
+    size_t written = 0;
+    while (written < bytes) {
+        stamp += 0.02;
+        int n = fprintf(out, "%.6f\t%.10f\t%.10f\t%.3f\t%.4f\t%.4f\t%.4f\t%.3f\t%.3f\t%.3f\n", stamp,
+                        -27.5958 + noise(random) * 1e-4, -48.5184 + noise(random) * 1e-4, 30 + noise(random),
+                        noise(random) * 10, noise(random) * 10, 30 + noise(random), noise(random) * 5,
+                        noise(random) * 5, noise(random) * 180);
+        written += (size_t) n;
+    }
+    fclose(out);
+}
+
+int main(int argc, char **argv) {
+    std::string file = argc > 1 ? argv[1] : "/tmp/csv_benchmark.txt";
+    std::string delimiter = argc > 2 ? argv[2] : "\t";
+    if (argc < 2) {
+        std::cout << "Generating " << file << std::endl;
+        generate(file, 200u << 20);
+    }
+    struct stat info;
+    if (stat(file.c_str(), &info) != 0) {
+        std::cerr << "Cannot read " << file << std::endl;
+        return -1;
+    }
+    const double mb = info.st_size / 1048576.0;
+
+    typedef std::chrono::steady_clock clock;
+    size_t legacy_rows, reader_rows;
+    clock::time_point start = clock::now();
+    double legacy = legacySum(file, delimiter, legacy_rows);
+    double legacy_time = std::chrono::duration<double>(clock::now() - start).count();
+    start = clock::now();
+    double fast = readerSum(file, delimiter, reader_rows);
+    double reader_time = std::chrono::duration<double>(clock::now() - start).count();
+
+    printf("%.1f MB, %zu rows\n", mb, reader_rows);
+    printf("read_csv + stod  %7.3f s  %8.1f MB/s  sum %.6f\n", legacy_time, mb / legacy_time, legacy);
+    printf("DelimitedReader  %7.3f s  %8.1f MB/s  sum %.6f\n", reader_time, mb / reader_time, fast);
+    printf("speed-up %.1fx, %s\n", legacy_time / reader_time,
+           legacy_rows == reader_rows && fabs(legacy - fast) <= 1e-9 * fabs(legacy) ? "same result" : "MISMATCH");
+    return 0;
+}
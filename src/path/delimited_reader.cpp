@@ -0,0 +1,242 @@
+#include <delimited_reader.hh>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    //! Exact powers of ten of a double, the fast path only multiplies or divides by these
+    const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    void trim(const char *&begin, const char *&end) {
+        while (begin < end && (*begin == ' ' || *begin == '"')) { begin++; }
+        while (end > begin && (end[-1] == ' ' || end[-1] == '"')) { end--; }
+    }
+}
+
+bool DelimitedReader::Field::operator==(const char *text) const {
+    size_t length = strlen(text);
+    return length == size() && memcmp(begin, text, length) == 0;
+}
+
+DelimitedReader::DelimitedReader() {
+    memset(is_delimiter_, 0, sizeof(is_delimiter_));
+}
+
+DelimitedReader::~DelimitedReader() {
+    close();
+}
+
+bool DelimitedReader::open(const std::string &filepath, const std::string &delimiters, bool header) {
+    close();
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = (size_t) info.st_size;
+    if (size_ > 0) {
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+#ifdef __linux__
+        madvise(map, size_, MADV_SEQUENTIAL);
+#endif
+        data_ = (const char *) map;
+    }
+    ::close(fd);
+    cursor_ = data_;
+    line_ = 0;
+
+    memset(is_delimiter_, 0, sizeof(is_delimiter_));
+    if (delimiters.empty()) {
+        const char *line_end = data_ ? (const char *) memchr(data_, '\n', size_) : nullptr;
+        size_t first_line = line_end ? (size_t) (line_end - data_) : size_;
+        is_delimiter_[data_ && memchr(data_, '\t', first_line) ? (unsigned char) '\t' : (unsigned char) ','] = true;
+    } else {
+        for (char c : delimiters) { is_delimiter_[(unsigned char) c] = true; }
+    }
+
+    names_.clear();
+    if (header && next()) {
+        for (const Field &f : fields_) {
+            const char *begin = f.begin, *end = f.end;
+            trim(begin, end);
+            names_.emplace_back(begin, end);
+        }
+    }
+    return true;
+}
+
+void DelimitedReader::close() {
+    if (data_) { munmap((void *) data_, size_); }
+    data_ = cursor_ = nullptr;
+    size_ = 0;
+    fields_.clear();
+}
+
+void DelimitedReader::split(const char *begin, const char *end) {
+    fields_.clear();
+    const char *start = begin;
+    for (const char *c = begin; c < end; c++) {
+        if (is_delimiter_[(unsigned char) *c]) {
+            fields_.push_back({start, c});
+            start = c + 1;
+        }
+    }
+    fields_.push_back({start, end});
+}
+
+bool DelimitedReader::next() {
+    const char *file_end = data_ + size_;
+    while (cursor_ && cursor_ < file_end) {
+        const char *line_end = (const char *) memchr(cursor_, '\n', (size_t) (file_end - cursor_));
+        if (line_end == nullptr) { line_end = file_end; }
+        const char *begin = cursor_, *end = line_end;
+        cursor_ = line_end < file_end ? line_end + 1 : file_end;
+        line_++;
+        if (end > begin && end[-1] == '\r') { end--; }
+        if (end == begin) { continue; }
+        split(begin, end);
+        return true;
+    }
+    fields_.clear();
+    return false;
+}
+
+bool DelimitedReader::seek(size_t offset) {
+    if (data_ == nullptr || offset > size_) { return false; }
+    cursor_ = data_ + offset;
+    return true;
+}
+
+int DelimitedReader::column(const std::string &name) const {
+    for (size_t i = 0; i < names_.size(); i++) {
+        if (names_[i] == name) { return (int) i; }
+    }
+    return -1;
+}
+
+bool DelimitedReader::getDouble(size_t i, double &value) const {
+    return i < fields_.size() && parseDouble(fields_[i].begin, fields_[i].end, value);
+}
+
+bool DelimitedReader::getFloat(size_t i, float &value) const {
+    double parsed;
+    if (!getDouble(i, parsed)) { return false; }
+    value = (float) parsed;
+    return true;
+}
+
+bool DelimitedReader::getInt(size_t i, long &value) const {
+    return i < fields_.size() && parseInt(fields_[i].begin, fields_[i].end, value);
+}
+
+double DelimitedReader::asDouble(size_t i, double fallback) const {
+    double value;
+    return getDouble(i, value) ? value : fallback;
+}
+
+long DelimitedReader::asInt(size_t i, long fallback) const {
+    long value;
+    return getInt(i, value) ? value : fallback;
+}
+
+/** Up to 19 significant digits are gathered in an integer. When it fits the 53 bit mantissa
+ *  and the decimal exponent is within the exact powers of ten, one multiplication or division
+ *  gives the correctly rounded result (Clinger's fast path). Anything else goes to strtod. */
+bool DelimitedReader::parseDouble(const char *begin, const char *end, double &value) {
+    trim(begin, end);
+    if (begin == end) { return false; }
+    const char *c = begin;
+    bool negative = false;
+    if (*c == '-' || *c == '+') {
+        negative = *c == '-';
+        c++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any_digit = false;
+    for (; c < end && *c >= '0' && *c <= '9'; c++) {
+        any_digit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t) (*c - '0');
+            if (mantissa != 0) { digits++; }
+        } else {
+            exponent++;
+            digits++;
+        }
+    }
+    if (c < end && *c == '.') {
+        for (c++; c < end && *c >= '0' && *c <= '9'; c++) {
+            any_digit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t) (*c - '0');
+                if (mantissa != 0) { digits++; }
+                exponent--;
+            } else {
+                digits++;
+            }
+        }
+    }
+    if (!any_digit) { return false; }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        c++;
+        bool exp_negative = false;
+        if (c < end && (*c == '-' || *c == '+')) {
+            exp_negative = *c == '-';
+            c++;
+        }
+        if (c == end || *c < '0' || *c > '9') { return false; }
+        int exp_value = 0;
+        for (; c < end && *c >= '0' && *c <= '9'; c++) {
+            if (exp_value < 10000) { exp_value = exp_value * 10 + (*c - '0'); }
+        }
+        exponent += exp_negative ? -exp_value : exp_value;
+    }
+    if (c != end) { return false; }
+
+    if (digits <= 19 && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        double result = (double) mantissa;
+        result = exponent < 0 ? result / POW10[-exponent] : result * POW10[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+    char buffer[64];
+    size_t length = (size_t) (end - begin);
+    if (length >= sizeof(buffer)) { return false; }
+    memcpy(buffer, begin, length);
+    buffer[length] = 0;
+    value = strtod(buffer, nullptr);
+    return true;
+}
+
+bool DelimitedReader::parseInt(const char *begin, const char *end, long &value) {
+    trim(begin, end);
+    if (begin == end) { return false; }
+    const char *c = begin;
+    bool negative = false;
+    if (*c == '-' || *c == '+') {
+        negative = *c == '-';
+        c++;
+    }
+    //! 18 digits always fit a 64 bit long, longer strings are rejected instead of overflowing
+    if (c == end || end - c > 18) { return false; }
+    long result = 0;
+    for (; c < end; c++) {
+        if (*c < '0' || *c > '9') { return false; }
+        result = result * 10 + (*c - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
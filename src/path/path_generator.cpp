@@ -29,10 +29,10 @@ void PathGenerate::setInspectionParam(double dist, float d_cyl, int n_h, int n_v
 
 void PathGenerate::setInitCoord(double lat, double lon, float alt, int head) {
     gnss_initial.clear();
-    gnss_initial.push_back((float) lat);
-    gnss_initial.push_back((float) lon);
-    gnss_initial.push_back((float) alt);
-    gnss_initial.push_back((float) head);
+    gnss_initial.push_back(lat);
+    gnss_initial.push_back(lon);
+    gnss_initial.push_back(alt);
+    gnss_initial.push_back(head);
 }
 
 void PathGenerate::setInitCoord_XY(double x, double y, double alt, int head) {
@@ -88,19 +88,17 @@ void PathGenerate::setCartesianPoints() {
 }
 
 void PathGenerate::setGNSSpoints() {
-    int R = 6371000; // Earth radius
-    double x0 = R * DEG2RAD(gnss_initial.at(1)) * cos(DEG2RAD(gnss_initial.at(1))); // Initial Position X
-    double y0 = R * DEG2RAD(gnss_initial.at(0)); // Initial Position Y
+    const double R = 6371000; // Earth radius
+    //! x is the north offset and y the east one, a degree of longitude shrinks with cos(latitude)
+    const double cos_lat = cos(DEG2RAD(gnss_initial.at(0)));
     for (int i = 0; i < (int) h_xy_points_.size(); i++) {
-        double x = h_xy_points_[i][0] + x0;
-        double y = h_xy_points_[i][0] + y0;
+        double lat = gnss_initial.at(0) + RAD2DEG(h_xy_points_[i][0] / R);
+        double lon = gnss_initial.at(1) + RAD2DEG(h_xy_points_[i][1] / (R * cos_lat));
         for (int j = 0; j < vertical_pts_; j++) {
             int vertical;
             if (i % 2 == 1) { vertical = 1; } else { vertical = -1; }
-            float altitude = gnss_initial.at(2) + j * vertical * delta_altitude_;
-            gnss_points_.push_back(
-                    {(float) RAD2DEG(y / R), (float) RAD2DEG(x / (R * cos(DEG2RAD(gnss_initial.at(1))))), altitude,
-                     polar_points_[i][1]});
+            double altitude = gnss_initial.at(2) + j * vertical * delta_altitude_;
+            gnss_points_.push_back({lat, lon, altitude, polar_points_[i][1]});
         }
     }
 }
@@ -228,16 +226,17 @@ void PathGenerate::setFolderName(const std::string &file_name) {
 
 std::vector<std::vector<std::string>>
 PathGenerate::read_csv(const std::string &filepath, const std::string &delimeter) {
-    std::ifstream file(filepath);
     std::vector<std::vector<std::string>> dataList;
-    std::string line;
-    // Iterate through each line and split the content using delimeter
-    while (getline(file, line)) {
-        std::vector<std::string> vec;
-        boost::algorithm::split(vec, line, boost::is_any_of(delimeter));
-        dataList.push_back(vec);
+    DelimitedReader reader;
+    if (!reader.open(filepath, delimeter, false)) { return dataList; }
+    // Every row split in place by the reader, only the returned strings are allocated
+    while (reader.next()) {
+        dataList.emplace_back();
+        std::vector<std::string> &vec = dataList.back();
+        vec.reserve(reader.size());
+        for (size_t i = 0; i < reader.size(); i++) {
+            vec.emplace_back(reader.field(i).begin, reader.field(i).end);
+        }
     }
-    // Close the File
-    file.close();
     return dataList;
 }
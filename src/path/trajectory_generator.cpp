@@ -0,0 +1,247 @@
+#include <trajectory_generator.hh>
+#include <algorithm>
+
+namespace {
+    struct Vec3 {
+        double x, y, z;
+    };
+
+    Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+
+    Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+
+    Vec3 operator*(double k, const Vec3 &a) { return {k * a.x, k * a.y, k * a.z}; }
+
+    double norm(const Vec3 &a) { return sqrt(a.x * a.x + a.y * a.y + a.z * a.z); }
+
+    /// Barry-Goldman evaluation of a centripetal Catmull-Rom segment between p1 and p2
+    Vec3 catmull_rom(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2, const Vec3 &p3, double u) {
+        double t0 = 0;
+        double t1 = t0 + std::max(sqrt(norm(p1 - p0)), 1e-6);
+        double t2 = t1 + std::max(sqrt(norm(p2 - p1)), 1e-6);
+        double t3 = t2 + std::max(sqrt(norm(p3 - p2)), 1e-6);
+        double t = t1 + u * (t2 - t1);
+
+        Vec3 a1 = ((t1 - t) / (t1 - t0)) * p0 + ((t - t0) / (t1 - t0)) * p1;
+        Vec3 a2 = ((t2 - t) / (t2 - t1)) * p1 + ((t - t1) / (t2 - t1)) * p2;
+        Vec3 a3 = ((t3 - t) / (t3 - t2)) * p2 + ((t - t2) / (t3 - t2)) * p3;
+        Vec3 b1 = ((t2 - t) / (t2 - t0)) * a1 + ((t - t0) / (t2 - t0)) * a2;
+        Vec3 b2 = ((t3 - t) / (t3 - t1)) * a2 + ((t - t1) / (t3 - t1)) * a3;
+        return ((t2 - t) / (t2 - t1)) * b1 + ((t - t1) / (t2 - t1)) * b2;
+    }
+
+    double wrap_angle(double angle) {
+        while (angle > 180) { angle -= 360; }
+        while (angle < -180) { angle += 360; }
+        return angle;
+    }
+}
+
+TrajectoryGenerator::TrajectoryGenerator() = default;
+
+TrajectoryGenerator::~TrajectoryGenerator() = default;
+
+void TrajectoryGenerator::setLimits(double max_speed, double max_accel, double max_lateral_accel) {
+    max_speed_ = max_speed;
+    max_accel_ = max_accel;
+    max_lateral_accel_ = max_lateral_accel;
+}
+
+void TrajectoryGenerator::setResolution(double resolution) {
+    resolution_ = resolution;
+}
+
+bool TrajectoryGenerator::generate(const std::vector<std::vector<float>> &waypoints) {
+    table_.clear();
+    waypoint_s_.clear();
+    waypoint_yaw_.clear();
+
+    //! Drop repeated points, every waypoint keeps the index of its spline knot
+    std::vector<Vec3> knots;
+    std::vector<int> knot_of_wp;
+    for (const auto &wp : waypoints) {
+        Vec3 p = {wp[0], wp[1], wp[2]};
+        if (knots.empty() || norm(p - knots.back()) > 1e-3) { knots.push_back(p); }
+        knot_of_wp.push_back((int) knots.size() - 1);
+    }
+    if (knots.size() < 2) { return false; }
+
+    //! Dense table of positions and arc length
+    std::vector<Vec3> points;
+    std::vector<double> arc;
+    std::vector<double> knot_s(knots.size(), 0);
+    int n = (int) knots.size();
+    for (int k = 0; k < n - 1; k++) {
+        Vec3 p0 = k == 0 ? 2.0 * knots[0] - knots[1] : knots[k - 1];
+        Vec3 p3 = k + 2 >= n ? 2.0 * knots[n - 1] - knots[n - 2] : knots[k + 2];
+        int steps = std::max(8, (int) ceil(norm(knots[k + 1] - knots[k]) / resolution_));
+        if (points.empty()) {
+            points.push_back(knots[0]);
+            arc.push_back(0);
+        }
+        for (int i = 1; i <= steps; i++) {
+            Vec3 p = catmull_rom(p0, knots[k], knots[k + 1], p3, (double) i / steps);
+            arc.push_back(arc.back() + norm(p - points.back()));
+            points.push_back(p);
+        }
+        knot_s[k + 1] = arc.back();
+    }
+
+    //! Speed limits from curvature, then forward/backward acceleration passes
+    int m = (int) points.size();
+    std::vector<double> v(m, max_speed_);
+    for (int i = 1; i < m - 1; i++) {
+        double ds0 = std::max(arc[i] - arc[i - 1], 1e-6), ds1 = std::max(arc[i + 1] - arc[i], 1e-6);
+        Vec3 d2 = (2.0 / (ds0 + ds1)) * ((1.0 / ds1) * (points[i + 1] - points[i]) -
+                                         (1.0 / ds0) * (points[i] - points[i - 1]));
+        double curvature = norm(d2);
+        if (curvature > 1e-6) { v[i] = std::min(v[i], sqrt(max_lateral_accel_ / curvature)); }
+    }
+    v[0] = 0;
+    v[m - 1] = 0;
+    for (int i = 1; i < m; i++) {
+        v[i] = std::min(v[i], sqrt(v[i - 1] * v[i - 1] + 2 * max_accel_ * (arc[i] - arc[i - 1])));
+    }
+    for (int i = m - 2; i >= 0; i--) {
+        v[i] = std::min(v[i], sqrt(v[i + 1] * v[i + 1] + 2 * max_accel_ * (arc[i + 1] - arc[i])));
+    }
+
+    //! Yaw keyed by arc length, unwrapped so interpolation takes the short way round
+    for (int k = 0; k < (int) waypoints.size(); k++) {
+        double yaw = waypoints[k][3];
+        if (!waypoint_yaw_.empty()) { yaw = waypoint_yaw_.back() + wrap_angle(yaw - waypoint_yaw_.back()); }
+        waypoint_s_.push_back(knot_s[knot_of_wp[k]]);
+        waypoint_yaw_.push_back(yaw);
+    }
+
+    table_.resize(m);
+    double t = 0;
+    for (int i = 0; i < m; i++) {
+        if (i > 0) {
+            double ds = arc[i] - arc[i - 1];
+            double v_mean = 0.5 * (v[i] + v[i - 1]);
+            t += v_mean > 1e-6 ? ds / v_mean : sqrt(2 * ds / max_accel_);
+        }
+        Vec3 tangent = points[std::min(i + 1, m - 1)] - points[std::max(i - 1, 0)];
+        double tangent_norm = norm(tangent);
+        if (tangent_norm > 1e-9) { tangent = (1.0 / tangent_norm) * tangent; }
+
+        TrajectoryPoint &pt = table_[i];
+        pt.t = t;
+        pt.s = arc[i];
+        pt.x = points[i].x;
+        pt.y = points[i].y;
+        pt.z = points[i].z;
+        pt.vx = tangent.x * v[i];
+        pt.vy = tangent.y * v[i];
+        pt.vz = tangent.z * v[i];
+        pt.yaw = yawAt(arc[i]);
+    }
+    return true;
+}
+
+double TrajectoryGenerator::yawAt(double s) const {
+    if (waypoint_s_.empty()) { return 0; }
+    auto upper = std::upper_bound(waypoint_s_.begin(), waypoint_s_.end(), s);
+    if (upper == waypoint_s_.begin()) { return waypoint_yaw_.front(); }
+    if (upper == waypoint_s_.end()) { return wrap_angle(waypoint_yaw_.back()); }
+    int k = (int) (upper - waypoint_s_.begin());
+    double span = waypoint_s_[k] - waypoint_s_[k - 1];
+    double u = span > 1e-9 ? (s - waypoint_s_[k - 1]) / span : 1;
+    return wrap_angle(waypoint_yaw_[k - 1] + u * (waypoint_yaw_[k] - waypoint_yaw_[k - 1]));
+}
+
+TrajectoryPoint TrajectoryGenerator::sample(double t) const {
+    if (table_.empty()) { return TrajectoryPoint(); }
+    if (t <= table_.front().t) { return table_.front(); }
+    if (t >= table_.back().t) { return table_.back(); }
+
+    auto upper = std::upper_bound(table_.begin(), table_.end(), t,
+                                  [](double time, const TrajectoryPoint &pt) { return time < pt.t; });
+    const TrajectoryPoint &b = *upper;
+    const TrajectoryPoint &a = *(upper - 1);
+    double u = (t - a.t) / std::max(b.t - a.t, 1e-9);
+
+    TrajectoryPoint pt;
+    pt.t = t;
+    pt.s = a.s + u * (b.s - a.s);
+    pt.x = a.x + u * (b.x - a.x);
+    pt.y = a.y + u * (b.y - a.y);
+    pt.z = a.z + u * (b.z - a.z);
+    pt.vx = a.vx + u * (b.vx - a.vx);
+    pt.vy = a.vy + u * (b.vy - a.vy);
+    pt.vz = a.vz + u * (b.vz - a.vz);
+    pt.yaw = yawAt(pt.s);
+    return pt;
+}
+
+double TrajectoryGenerator::getDuration() const {
+    return table_.empty() ? 0 : table_.back().t;
+}
+
+double TrajectoryGenerator::getLength() const {
+    return table_.empty() ? 0 : table_.back().s;
+}
+
+double TrajectoryGenerator::getWaypointTime(int k) const {
+    double s = waypoint_s_.at(k);
+    auto upper = std::lower_bound(table_.begin(), table_.end(), s,
+                                  [](const TrajectoryPoint &pt, double arc) { return pt.s < arc; });
+    if (upper == table_.end()) { return getDuration(); }
+    if (upper == table_.begin()) { return 0; }
+    const TrajectoryPoint &b = *upper;
+    const TrajectoryPoint &a = *(upper - 1);
+    double u = (s - a.s) / std::max(b.s - a.s, 1e-9);
+    return a.t + u * (b.t - a.t);
+}
+
+TrajectoryPoint TrajectoryGenerator::project(double x, double y, double z, double s_hint, double window) const {
+    if (table_.empty()) { return TrajectoryPoint(); }
+    auto first = std::lower_bound(table_.begin(), table_.end(), s_hint - window,
+                                  [](const TrajectoryPoint &pt, double arc) { return pt.s < arc; });
+    size_t i = first == table_.begin() ? 0 : (size_t) (first - table_.begin()) - 1;
+
+    //! Closest point over the table segments inside the window
+    size_t best = i;
+    double best_u = 0, best_distance = 1e300;
+    for (; i + 1 < table_.size() && table_[i].s <= s_hint + window; i++) {
+        const TrajectoryPoint &a = table_[i], &b = table_[i + 1];
+        double dx = b.x - a.x, dy = b.y - a.y, dz = b.z - a.z;
+        double length2 = dx * dx + dy * dy + dz * dz;
+        double u = length2 > 1e-12 ? ((x - a.x) * dx + (y - a.y) * dy + (z - a.z) * dz) / length2 : 0;
+        u = std::max(0.0, std::min(1.0, u));
+        double ex = a.x + u * dx - x, ey = a.y + u * dy - y, ez = a.z + u * dz - z;
+        double distance = ex * ex + ey * ey + ez * ez;
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = i;
+            best_u = u;
+        }
+    }
+    if (best + 1 >= table_.size()) { return table_.back(); }
+    const TrajectoryPoint &a = table_[best], &b = table_[best + 1];
+    TrajectoryPoint pt;
+    pt.t = a.t + best_u * (b.t - a.t);
+    pt.s = a.s + best_u * (b.s - a.s);
+    pt.x = a.x + best_u * (b.x - a.x);
+    pt.y = a.y + best_u * (b.y - a.y);
+    pt.z = a.z + best_u * (b.z - a.z);
+    pt.vx = a.vx + best_u * (b.vx - a.vx);
+    pt.vy = a.vy + best_u * (b.vy - a.vy);
+    pt.vz = a.vz + best_u * (b.vz - a.vz);
+    pt.yaw = yawAt(pt.s);
+    return pt;
+}
+
+std::vector<std::vector<float>>
+TrajectoryGenerator::toAbsolute(const std::vector<std::vector<float>> &delta_waypoints) {
+    std::vector<std::vector<float>> absolute;
+    float x = 0, y = 0, z = 0;
+    for (const auto &wp : delta_waypoints) {
+        x += wp[1];
+        y += wp[2];
+        z += wp[3];
+        absolute.push_back({x, y, z, wp[4]});
+    }
+    return absolute;
+}
@@ -0,0 +1,51 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Checks PathGenerate::setGNSSpoints: every waypoint lies at its local (north, east) offset
+// from the start fix, measured on the sphere with the haversine distance and initial bearing.
+//
+
+#include <path_generator.hh>
+#include <cstdio>
+
+int main() {
+    const double R = 6371000;
+    const double starts[][3] = {{-22.9, -43.2, 90}, {60.0, 5.3, 0}, {0.0, 179.9, -135}};
+    int failures = 0;
+    double worst = 0;
+    for (const auto &start : starts) {
+        PathGenerate path;
+        path.setInspectionParam(8, 150, 7, 3, 15, -300);
+        path.setInitCoord(start[0], start[1], 10, (int) start[2]);
+        path.setInitCoord_XY(0, 0, 10, (int) start[2]);
+        path.setCartesianPoints();
+        path.setGNSSpoints();
+        const auto &local = path.getCartesianPoints();
+        const auto &gnss = path.getGNSSpoints();
+        if (local.size() != gnss.size() || local.empty()) {
+            printf("%zu local and %zu GNSS waypoints\n", local.size(), gnss.size());
+            return 1;
+        }
+        const double lat0 = DEG2RAD(start[0]), lon0 = DEG2RAD(start[1]);
+        for (size_t k = 0; k < gnss.size(); k++) {
+            const double north = local[k][0], east = local[k][1];
+            const double lat = DEG2RAD(gnss[k][0]), dlon = DEG2RAD(gnss[k][1]) - lon0;
+            const double a = pow(sin((lat - lat0) / 2), 2) + cos(lat0) * cos(lat) * pow(sin(dlon / 2), 2);
+            const double distance = 2 * R * asin(sqrt(a));
+            const double bearing = atan2(sin(dlon) * cos(lat), cos(lat0) * sin(lat) - sin(lat0) * cos(lat) * cos(dlon));
+            const double expected = std::hypot(north, east);
+            //! Position on the ground of the bearing error, the bearing is meaningless at the start fix
+            const double error = std::max(fabs(distance - expected),
+                                          expected * fabs(std::remainder(bearing - atan2(east, north), 2 * M_PI)));
+            worst = std::max(worst, error);
+            if (error > 1e-3) {
+                if (failures++ < 5) {
+                    printf("Start %.1f, %.1f WP %zu: %.3f m at %.1f deg, expected %.3f m at %.1f deg\n", start[0],
+                           start[1], k + 1, distance, RAD2DEG(bearing), expected, RAD2DEG(atan2(east, north)));
+                }
+            }
+        }
+    }
+    printf("Worst GNSS offset error %.3g m, %d failures\n", worst, failures);
+    return failures == 0 ? 0 : 1;
+}
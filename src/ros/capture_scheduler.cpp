@@ -0,0 +1,172 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <capture_scheduler.h>
+
+CaptureScheduler::CaptureScheduler() {
+    confirm_thread = std::thread(&CaptureScheduler::confirm_captures, this);
+}
+
+CaptureScheduler::~CaptureScheduler() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(confirm_mutex);
+        running = false;
+    }
+    confirm_cv.notify_all();
+    if (confirm_thread.joinable()) { confirm_thread.join(); }
+}
+
+void CaptureScheduler::init(ros::NodeHandle &nh, const TelemetryStore *telemetry_store) {
+    telemetry = telemetry_store;
+    nh.param<std::string>("/riser_inspection/capture_log_dir", capture_log_dir, ".");
+
+    gimbal_control_client = nh.serviceClient<dji_osdk_ros::GimbalAction>("/gimbal_task_control");
+    camera_photo_client = nh.serviceClient<dji_osdk_ros::CameraStartShootSinglePhoto>(
+            "camera_start_shoot_single_photo");
+    sv3d_client = nh.serviceClient<stereo_vant::PointGray>("/stereo_point_grey/take_picture");
+}
+
+void CaptureScheduler::configure(bool gimbal_camera, bool stereo, const std::string &stereo_folder,
+                                 bool reset_gimbal_photo) {
+    flush();
+    use_gimbal = gimbal_camera;
+    use_stereo = stereo;
+    reset_gimbal = reset_gimbal_photo;
+    stereo_path = stereo_folder;
+    camera_count = 1;
+    stereo_count = 1;
+    //! The confirmation thread is idle after flush, the log can be swapped
+    char log_name[64];
+    snprintf(log_name, sizeof(log_name), "/captures_%.0f.txt", ros::Time::now().toSec());
+    if (!capture_log.open(capture_log_dir + log_name, {"wp", "file"}, 1)) {
+        ROS_WARN("Capture log %s%s not created, photos will not be geotagged", capture_log_dir.c_str(), log_name);
+    }
+    std::lock_guard<std::mutex> lock(confirm_mutex);
+    total_saved = 0;
+}
+
+CaptureScheduler::CaptureResult CaptureScheduler::gimbal_photo(std::shared_future<CaptureResult> previous) {
+    //! Camera is still writing the last picture
+    if (previous.valid()) { previous.wait(); }
+    Clock::time_point start = Clock::now();
+
+    if (reset_gimbal) {
+        //! An incremental 0/0/0 move leaves the gimbal where it is, the reset action re-centres it
+        dji_osdk_ros::GimbalAction gimbalAction;
+        gimbalAction.request.is_reset = true;
+        gimbalAction.request.payload_index = static_cast<uint8_t>(dji_osdk_ros::PayloadIndex::PAYLOAD_INDEX_0);
+        gimbal_control_client.call(gimbalAction);
+    }
+
+    dji_osdk_ros::CameraStartShootSinglePhoto cameraAction;
+    cameraAction.request.payload_index = 0;
+    TelemetrySnapshot pose = telemetry ? telemetry->snapshot() : TelemetrySnapshot();
+    double stamp = ros::Time::now().toSec();
+    camera_photo_client.call(cameraAction);
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return {"gimbal", (bool) cameraAction.response.result, elapsed.count(), pose, stamp};
+}
+
+CaptureScheduler::CaptureResult CaptureScheduler::stereo_photo(std::shared_future<CaptureResult> previous) {
+    if (previous.valid()) { previous.wait(); }
+    Clock::time_point start = Clock::now();
+
+    stereo_vant::PointGray stereoAction;
+    stereoAction.request.reset_counter = false;
+    stereoAction.request.file_path = stereo_path;
+    stereoAction.request.file_name = "stereo_vant";
+    TelemetrySnapshot pose = telemetry ? telemetry->snapshot() : TelemetrySnapshot();
+    double stamp = ros::Time::now().toSec();
+    sv3d_client.call(stereoAction);
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return {"stereo", (bool) stereoAction.response.result, elapsed.count(), pose, stamp};
+}
+
+/** Dispatch every enabled trigger at once. With wait_result the call returns when every shutter
+ *  service has answered and tells whether all of them took their picture, the two devices still
+ *  expose together. Without it (continuous flight) the call returns right after dispatch.
+ *  Either way the results are logged by confirm_captures(). */
+bool CaptureScheduler::capture(int wp, bool wait_result) {
+    Clock::time_point start = Clock::now();
+    CaptureRecord record;
+    record.wp = wp;
+
+    if (use_gimbal) {
+        gimbal_pending = std::async(std::launch::async, &CaptureScheduler::gimbal_photo, this,
+                                    gimbal_pending).share();
+        record.tasks.push_back(gimbal_pending);
+    }
+    if (use_stereo) {
+        stereo_pending = std::async(std::launch::async, &CaptureScheduler::stereo_photo, this,
+                                    stereo_pending).share();
+        record.tasks.push_back(stereo_pending);
+    }
+    if (record.tasks.empty()) { return false; }
+
+    bool captured = true;
+    if (wait_result) {
+        for (auto &task : record.tasks) { captured = task.get().result && captured; }
+    }
+
+    std::chrono::duration<double> blocked = Clock::now() - start;
+    record.blocked = blocked.count();
+    {
+        std::lock_guard<std::mutex> lock(confirm_mutex);
+        confirm_queue.push_back(record);
+    }
+    confirm_cv.notify_all();
+    return captured;
+}
+
+void CaptureScheduler::confirm_captures() {
+    std::unique_lock<std::mutex> lock(confirm_mutex);
+    while (running || !confirm_queue.empty()) {
+        confirm_cv.wait(lock, [this] { return !running || !confirm_queue.empty(); });
+        if (confirm_queue.empty()) { continue; }
+        CaptureRecord record = confirm_queue.front();
+        lock.unlock();
+
+        //! Time the executor would have waited calling every service one after the other
+        double serial = 0;
+        for (auto &task : record.tasks) {
+            CaptureResult result = task.get();
+            serial += result.duration;
+            if (!result.result) {
+                ROS_ERROR("WP %i %s capture failed", record.wp + 1, result.name.c_str());
+            } else if (result.name == "gimbal") {
+                capture_log.append(result.stamp, {(double) record.wp + 1}, "gimbal_" + std::to_string(camera_count));
+                ROS_INFO("Picture %i at Lat: %f, Lon: %f, Height: %f m @ %f deg", camera_count++,
+                         result.pose.latitude, result.pose.longitude, result.pose.height, result.pose.heading);
+            } else {
+                capture_log.append(result.stamp, {(double) record.wp + 1},
+                                   stereo_path + "/stereo_vant_" + std::to_string(stereo_count));
+                ROS_INFO("Stereo image %i at Lat: %f, Lon: %f, Height: %f m @ %f deg", stereo_count++,
+                         result.pose.latitude, result.pose.longitude, result.pose.height, result.pose.heading);
+            }
+            capture_log.flush();
+        }
+        double saved = std::max(0.0, serial - record.blocked);
+        ROS_INFO("WP %i capture: %.0f ms blocked, %.0f ms serial, %.0f ms saved", record.wp + 1,
+                 record.blocked * 1000, serial * 1000, saved * 1000);
+
+        lock.lock();
+        total_saved += saved;
+        confirm_queue.pop_front();
+        confirm_cv.notify_all();
+    }
+}
+
+/// Block until every dispatched trigger has been acknowledged
+void CaptureScheduler::flush() {
+    std::unique_lock<std::mutex> lock(confirm_mutex);
+    confirm_cv.wait(lock, [this] { return confirm_queue.empty(); });
+}
+
+double CaptureScheduler::get_total_saved() {
+    std::lock_guard<std::mutex> lock(confirm_mutex);
+    return total_saved;
+}
@@ -0,0 +1,183 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <compressed_preview.h>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+CompressedPreview::CompressedPreview() : running(false) {
+}
+
+CompressedPreview::~CompressedPreview() {
+    stop();
+}
+
+void CompressedPreview::setBudget(double bitrate_bps, double max_rate_hz, double scale_min, int quality_min,
+                                  int quality_max) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    bitrate = std::max(bitrate_bps, 1e3);
+    max_rate = std::max(max_rate_hz, 0.1);
+    min_scale = std::min(1.0, std::max(scale_min, 0.05));
+    min_quality = std::max(5, std::min(quality_min, 100));
+    max_quality = std::max(min_quality, std::min(quality_max, 100));
+}
+
+int CompressedPreview::addStream(ros::NodeHandle &nh, const std::string &topic, Codec codec, double share) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    std::unique_ptr<Stream> stream(new Stream);
+    stream->publisher = nh.advertise<sensor_msgs::CompressedImage>(topic, 1);
+    stream->codec = codec;
+    stream->share = std::max(share, 0.01);
+    stream->scale = std::max(min_scale, 0.5);
+    stream->quality = (min_quality + max_quality) / 2;
+    streams.push_back(std::move(stream));
+    return (int) streams.size() - 1;
+}
+
+void CompressedPreview::start() {
+    if (running) { return; }
+    running = true;
+    worker = std::thread(&CompressedPreview::run, this);
+}
+
+void CompressedPreview::stop() {
+    if (!running) { return; }
+    running = false;
+    frame_ready.notify_all();
+    if (worker.joinable()) { worker.join(); }
+}
+
+bool CompressedPreview::submit(int index, const std_msgs::Header &header, const cv::Mat &image) {
+    if (!running || index < 0 || index >= (int) streams.size() || image.empty()) { return false; }
+    const double now = ros::WallTime::now().toSec();
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    Stream &stream = *streams[index];
+
+    //! Token bucket, one second of the stream budget at most
+    const double byte_rate = stream.share * bitrate / 8;
+    if (stream.last_refill > 0) {
+        stream.tokens = std::min(byte_rate, stream.tokens + (now - stream.last_refill) * byte_rate);
+    }
+    stream.last_refill = now;
+    if (stream.tokens < 0 || now - stream.last_submit < 1.0 / max_rate) {
+        stream.dropped++;
+        return false;
+    }
+    //! Overwrites a frame the worker has not taken yet, only the newest one is worth sending
+    stream.frame = image.clone();
+    stream.header = header;
+    stream.fresh = true;
+    stream.last_submit = now;
+    frame_ready.notify_one();
+    return true;
+}
+
+void CompressedPreview::run() {
+#ifdef __linux__
+    //! The stereo pipeline always wins the CPU over the preview
+    setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), 19);
+#endif
+    while (running) {
+        Stream *next = nullptr;
+        cv::Mat frame;
+        std_msgs::Header header;
+        {
+            std::unique_lock<std::mutex> lock(stream_mutex);
+            frame_ready.wait(lock, [this]() {
+                if (!running) { return true; }
+                for (const std::unique_ptr<Stream> &stream : streams) {
+                    if (stream->fresh) { return true; }
+                }
+                return false;
+            });
+            if (!running) { break; }
+            //! Oldest submission first, so one busy stream cannot starve the other
+            for (const std::unique_ptr<Stream> &stream : streams) {
+                if (stream->fresh && (next == nullptr || stream->last_submit < next->last_submit)) {
+                    next = stream.get();
+                }
+            }
+            frame = next->frame;
+            next->frame = cv::Mat();
+            header = next->header;
+            next->fresh = false;
+        }
+        encode(*next, frame, header);
+    }
+}
+
+void CompressedPreview::encode(Stream &stream, cv::Mat &frame, const std_msgs::Header &header) {
+    double scale;
+    int quality;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        scale = stream.scale;
+        quality = stream.quality;
+    }
+
+    sensor_msgs::CompressedImage msg;
+    msg.header = header;
+    cv::Mat small;
+    if (stream.codec == JPEG) {
+        if (scale < 1.0) {
+            cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+        } else {
+            small = frame;
+        }
+        cv::imencode(".jpg", small, msg.data, {cv::IMWRITE_JPEG_QUALITY, quality});
+        msg.format = small.channels() == 1 ? "mono8; jpeg compressed mono8" : "bgr8; jpeg compressed bgr8";
+    } else {
+        //! Nearest neighbour keeps real disparities, unmatched pixels (negative) saturate to 0
+        if (scale < 1.0) {
+            cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_NEAREST);
+        } else {
+            small = frame;
+        }
+        small.convertTo(small, CV_16U);
+        cv::imencode(".png", small, msg.data, {cv::IMWRITE_PNG_COMPRESSION, 1});
+        msg.format = "mono16; png compressed mono16";
+    }
+    stream.publisher.publish(msg);
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    stream.tokens -= (double) msg.data.size();
+    stream.frame_bytes = stream.samples++ > 0 ? 0.7 * stream.frame_bytes + 0.3 * msg.data.size()
+                                              : (double) msg.data.size();
+    stream.sent++;
+    adapt(stream);
+}
+
+void CompressedPreview::adapt(Stream &stream) {
+    //! Frame size that lets the stream run at max_rate inside its share
+    const double target = stream.share * bitrate / 8 / max_rate;
+    if (stream.samples < 3) { return; }
+    bool changed = false;
+    if (stream.frame_bytes > 1.2 * target) {
+        if (stream.codec == JPEG && stream.quality > min_quality) {
+            stream.quality = std::max(min_quality, stream.quality - 10);
+            changed = true;
+        } else if (stream.scale > min_scale) {
+            stream.scale = std::max(min_scale, stream.scale * 0.8);
+            changed = true;
+        }
+    } else if (stream.frame_bytes < 0.6 * target) {
+        if (stream.scale < 1.0) {
+            stream.scale = std::min(1.0, stream.scale * 1.25);
+            changed = true;
+        } else if (stream.codec == JPEG && stream.quality < max_quality) {
+            stream.quality = std::min(max_quality, stream.quality + 5);
+            changed = true;
+        }
+    }
+    if (changed) {
+        //! Measure the new setting from scratch
+        stream.samples = 0;
+        ROS_DEBUG("Preview %s: scale %.2f, quality %i, %zu sent, %zu dropped",
+                  stream.publisher.getTopic().c_str(), stream.scale, stream.quality, stream.sent, stream.dropped);
+    }
+}
@@ -7,79 +7,214 @@ DarknetDisparity::DarknetDisparity() {
 DarknetDisparity::~DarknetDisparity() {}
 
 void DarknetDisparity::subscribing(ros::NodeHandle &nh) {
-    std::string darknet_topic, image_topic, object_count_topic;
+    std::string darknet_topic, image_topic, distance_topic, objects_topic;
+    std::vector<std::string> class_list;
 
     nh.param("/darknet_distance/darknet_topic", darknet_topic, std::string("/darknet_ros/bounding_boxes"));
-    nh.param("/darknet_distance/darknet_objet", object_count_topic, std::string("/darknet_ros/found_object"));
     nh.param("/darknet_distance/disparity_topic", image_topic, std::string("/stereo_depth_perception/disparity_front_left_image"));
     nh.param("/darknet_distance/object_track", object_to_track, std::string("simulacro"));
+    nh.param("/darknet_distance/distance_topic", distance_topic, std::string("/darknet_distance/object_position"));
+    nh.param("/darknet_distance/objects_topic", objects_topic, std::string("/darknet_distance/objects"));
+    //! Classes to locate, "all" keeps every detection, default is the tracked object only
+    nh.param("/darknet_distance/classes", class_list, std::vector<std::string>{object_to_track});
+    classes.insert(class_list.begin(), class_list.end());
+    if (classes.count("all")) { classes.clear(); }
+    int ring_size;
+    nh.param("/darknet_distance/ring_size", ring_size, 30);
+    nh.param("/darknet_distance/match_tolerance", match_tolerance, 0.005);
+    disparity_ring = DisparityRing((size_t) ring_size);
+
+    std::string tracks_topic;
+    double gate, max_coast;
+    int min_hits;
+    nh.param("/darknet_distance/track", use_tracker, true);
+    nh.param("/darknet_distance/tracks_topic", tracks_topic, std::string("/darknet_distance/tracks"));
+    nh.param("/darknet_distance/track_gate", gate, 60.0);
+    nh.param("/darknet_distance/track_max_coast", max_coast, 1.0);
+    nh.param("/darknet_distance/track_min_hits", min_hits, 2);
+    tracker.setParameters(gate, max_coast, min_hits);
+
+    //! No preview on the aircraft, the default follows the availability of a display
+    bool headless;
+    double preview_rate, preview_scale;
+    nh.param("/darknet_distance/headless", headless, M210_STEREO::PreviewWorker::noDisplay());
+    nh.param("/darknet_distance/preview_rate", preview_rate, 5.0);
+    nh.param("/darknet_distance/preview_scale", preview_scale, 0.5);
+    if (!headless) {
+        preview = M210_STEREO::PreviewWorker::createPreviewWorker(preview_rate, preview_scale);
+        preview->start();
+    }
+
+    distance_pub = nh.advertise<geometry_msgs::PointStamped>(distance_topic, 10);
+    objects_pub = nh.advertise<riser_inspection::ObjectDistances>(objects_topic, 10);
+    tracks_pub = nh.advertise<riser_inspection::ObjectTracks>(tracks_topic, 10);
 
 
     darknet_bb_sub = nh.subscribe<darknet_ros_msgs::BoundingBoxes>(darknet_topic, 1, &DarknetDisparity::darknet_cb,
                                                                    this);
     m210_disparity_sub = nh.subscribe<sensor_msgs::Image>(image_topic, 1, &DarknetDisparity::disparity_cb, this);
+}
 
-    darknet_obj_sub = nh.subscribe<darknet_ros_msgs::ObjectCount>(object_count_topic, 1, &DarknetDisparity::darknet_obj_count_cb, this);
+/** Locate every box of the message against one set of prefix sums, so the cost of a
+ *  frame is one pass over the disparity plus four lookups per detection. */
+void DarknetDisparity::darknet_cb(const darknet_ros_msgs::BoundingBoxes::ConstPtr &bb_msg){
+    //! Darknet runs on the rectified left image, which carries the stamp of its disparity
+    DisparityRing::Frame *disparity = disparity_ring.find(bb_msg->image_header.stamp, match_tolerance);
+    if (disparity == nullptr) {
+        ROS_WARN_THROTTLE(1, "No disparity frame for detections at %.3f, %i frames buffered",
+                          bb_msg->image_header.stamp.toSec(), (int) disparity_ring.size());
+        return;
+    }
+    disparity_ring.buildIntegral(*disparity);
 
+    riser_inspection::ObjectDistances objects;
+    objects.header = disparity->msg->header;
+    objects.image_header = bb_msg->image_header;
+    const cv::Rect frame(0, 0, disparity->image->image.cols, disparity->image->image.rows);
+    boxes_to_show.clear();
 
-}
-void DarknetDisparity::darknet_obj_count_cb(const darknet_ros_msgs::ObjectCount::ConstPtr &obj_msg) {
-    found_obj_darknet = obj_msg->count;
-}
-void DarknetDisparity::darknet_cb(const darknet_ros_msgs::BoundingBoxes::ConstPtr &bb_msg){
-//    ROS_INFO("%s", bb_msg->bounding_boxes[n_detected_obj].Class.c_str());
-    if(bb_msg->bounding_boxes[n_detected_obj].Class == object_to_track && cv_disp != NULL){
-        top_left.x =  bb_msg->bounding_boxes[n_detected_obj].xmin;
-        top_left.y = bb_msg->bounding_boxes[n_detected_obj].ymin;
-        bot_right.x =  bb_msg->bounding_boxes[n_detected_obj].xmax;
-        bot_right.y = bb_msg->bounding_boxes[n_detected_obj].ymax;
-//        ROS_INFO("Got position of %s at (%d, %d) x (%d, %d)", bb_msg->bounding_boxes[n_detected_obj].Class.c_str() ,
-//                                                            top_left.x, top_left.y, bot_right.x, bot_right.y);
-        float distance  = calculate_distance();
-        ROS_INFO("Aproximate distance: %f m", distance);
+    bool tracked = false;
+    geometry_msgs::PointStamped tracked_position;
+    float tracked_distance = 0;
+    std::vector<Detection> detections;
+    for (const darknet_ros_msgs::BoundingBox &bb : bb_msg->bounding_boxes) {
+        if (!classes.empty() && !classes.count(bb.Class)) { continue; }
+        //! Darknet corners are inclusive and may fall outside the frame
+        cv::Rect box = cv::Rect(cv::Point((int) bb.xmin, (int) bb.ymin),
+                                cv::Point((int) bb.xmax + 1, (int) bb.ymax + 1)) & frame;
+        cv::Point3f position;
+        int valid_pixels;
+        if (box.area() == 0) { continue; }
+        bool located = calculate_position(*disparity, box, position, valid_pixels);
+        detections.push_back({bb.Class, bb.probability, (float) box.x, (float) box.y, (float) box.width,
+                              (float) box.height, located ? position.z : 0.f});
+        if (!located) { continue; }
 
-    }
-    else{
-        n_detected_obj++;
-        if(n_detected_obj > found_obj_darknet){
-            n_detected_obj = 0;
+        riser_inspection::ObjectDistance object;
+        object.Class = bb.Class;
+        object.probability = bb.probability;
+        object.id = bb.id;
+        object.xmin = box.x;
+        object.ymin = box.y;
+        object.xmax = box.x + box.width - 1;
+        object.ymax = box.y + box.height - 1;
+        object.position.x = position.x;
+        object.position.y = position.y;
+        object.position.z = position.z;
+        object.distance = (float) cv::norm(position);
+        object.valid_pixels = (uint32_t) valid_pixels;
+        objects.objects.push_back(object);
+        boxes_to_show.push_back(box);
+
+        //! Nearest instance of the tracked class feeds the standoff correction
+        if (bb.Class == object_to_track && (!tracked || object.distance < tracked_distance)) {
+            tracked = true;
+            tracked_distance = object.distance;
+            tracked_position.point = object.position;
         }
     }
+
+    if (tracked) {
+        ROS_INFO("Aproximate distance: %f m", tracked_distance);
+        tracked_position.header = disparity->msg->header;
+        distance_pub.publish(tracked_position);
+    }
+    objects_pub.publish(objects);
+    if (use_tracker) { tracker.update(disparity->msg->header.stamp.toSec(), detections); }
 }
 
 void DarknetDisparity::disparity_cb(const sensor_msgs::Image::ConstPtr &disp_msgs) {
-    cv_disp = cv_bridge::toCvCopy(disp_msgs, sensor_msgs::image_encodings::MONO8);
-//    float distance = 0;
-    show_disp_image();
+    if (!disparity_ring.push(disp_msgs)) {
+        ROS_WARN("Disparity frame out of order, dropped");
+        return;
+    }
+    if (use_tracker) { track_frame(*disparity_ring.latest()); }
+    if (preview) { show_disp_image(); }
 }
 
-float DarknetDisparity::calculate_distance() {
-    std::vector<cv::Mat> channels;
-    cv::Rect crop(top_left,bot_right);
-    cv::Mat img_crop = cv_disp->image(crop);
-    cv::split(img_crop, channels);
-    cv::Scalar m = mean(channels[0]);
-
-    float baseline_x_fx_ = -45.3569;
-    float principal_x_ = 450.6202;
-    float principal_y_ = 231.8208;
-    float fx_ = 444.3998;
-    float fy_ = 444.3998;
-    float u = (float) (crop.x + crop.width) / 2;
-    float v = (float) (crop.y + crop.height) / 2;
-
-    float disparity = (float) m[0];
-    float dist_x, dist_y, dist_z;
-    dist_z = baseline_x_fx_ / disparity;
-    dist_x = (u - principal_x_) * (dist_z) / fx_;
-    dist_y = (v - principal_y_) * (dist_z) / fy_;
-    float distance = sqrt(dist_z * dist_z + dist_y * dist_y + dist_x * dist_x);
-    return distance*10;
+bool DarknetDisparity::calculate_position(const DisparityRing::Frame &frame, const cv::Rect &box,
+                                          cv::Point3f &position, int &valid_pixels) {
+    auto box_sum = [&box](const cv::Mat &integral) {
+        return integral.at<int>(box.y, box.x) + integral.at<int>(box.y + box.height, box.x + box.width) -
+               integral.at<int>(box.y, box.x + box.width) - integral.at<int>(box.y + box.height, box.x);
+    };
+    valid_pixels = box_sum(frame.valid_count);
+    if (valid_pixels == 0) { return false; }
+
+    float disparity = (float) box_sum(frame.disp_sum) / (float) valid_pixels;
+    float u = (float) box.x + (float) box.width / 2;
+    float v = (float) box.y + (float) box.height / 2;
+
+    //! Scale of the 8 bit disparity image published by m210_stereo_rect_depth
+    position = depth_to_point(u, v, fabs(baseline_x_fx_ / disparity) * 10);
+    return true;
+}
+
+cv::Point3f DarknetDisparity::depth_to_point(float u, float v, float depth) {
+    //! baseline_x_fx_ is negative in the M210 calibration, the depth is positive forward all the same
+    float dist_z = fabs(depth);
+    float dist_x = (u - principal_x_) * (dist_z) / fx_;
+    float dist_y = (v - principal_y_) * (dist_z) / fy_;
+    return cv::Point3f(dist_x, dist_y, dist_z);
+}
+
+/** Between detections, predict every track to this frame and measure its depth inside the
+ *  predicted box only, then publish the confirmed tracks at the stereo rate. */
+void DarknetDisparity::track_frame(const DisparityRing::Frame &frame) {
+    const double stamp = frame.msg->header.stamp.toSec();
+    tracker.predict(stamp);
+    const cv::Mat &image = frame.image->image;
+    const cv::Rect bounds(0, 0, image.cols, image.rows);
+
+    riser_inspection::ObjectTracks tracks;
+    tracks.header = frame.msg->header;
+    for (const TrackedObject &track : tracker.getTracks()) {
+        cv::Rect box = cv::Rect((int) (track.u.p - track.width / 2), (int) (track.v.p - track.height / 2),
+                                (int) track.width, (int) track.height) & bounds;
+        if (box.area() > 0) {
+            cv::Mat roi = image(box);
+            int valid = cv::countNonZero(roi);
+            if (valid > box.area() / 4) {
+                float disparity = (float) (cv::sum(roi)[0] / valid);
+                tracker.updateDepth(track.id, fabs(baseline_x_fx_ / disparity) * 10);
+            }
+        }
+        if (!track.confirmed) { continue; }
+
+        riser_inspection::ObjectTrack object;
+        object.id = (uint32_t) track.id;
+        object.Class = track.label;
+        object.probability = track.probability;
+        object.xmin = box.x;
+        object.ymin = box.y;
+        object.xmax = box.x + box.width - 1;
+        object.ymax = box.y + box.height - 1;
+        cv::Point3f position = depth_to_point((float) track.u.p, (float) track.v.p, (float) track.z.p);
+        object.position.x = position.x;
+        object.position.y = position.y;
+        object.position.z = position.z;
+        //! d/dt of the pinhole projection
+        double z = position.z, dz = track.z.v;
+        object.velocity.x = (track.u.v * z + (track.u.p - principal_x_) * dz) / fx_;
+        object.velocity.y = (track.v.v * z + (track.v.p - principal_y_) * dz) / fy_;
+        object.velocity.z = dz;
+        object.distance = (float) cv::norm(position);
+        object.since_detection = (float) (stamp - track.last_detection);
+        tracks.tracks.push_back(object);
+    }
+    tracks_pub.publish(tracks);
 }
 
 void DarknetDisparity::show_disp_image() {
-    disp_img = cv_disp->image;
-    cv::rectangle(disp_img, top_left, bot_right, cv::Scalar(0, 255, 0), 1, CV_AA);
-    cv::imshow("Disparity", disp_img);
-    cv::waitKey(1);
+    if (!preview->wantsFrame("Disparity")) { return; }
+    //! The boxes are drawn by the preview thread on its own downscaled copy
+    std::vector<cv::Rect> boxes = boxes_to_show;
+    preview->show("Disparity", disparity_ring.latest()->image->image, [boxes](cv::Mat &image, double scale) {
+        for (const cv::Rect &box : boxes) {
+            cv::rectangle(image, cv::Rect(cv::Point((int) (box.x * scale), (int) (box.y * scale)),
+                                          cv::Size((int) (box.width * scale), (int) (box.height * scale))),
+                          cv::Scalar(0, 255, 0), 1, CV_AA);
+        }
+        return image;
+    });
 }
@@ -0,0 +1,165 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <dataset_exporter.h>
+#include <cv_bridge/cv_bridge.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+namespace {
+    struct MessageOwner {
+        sensor_msgs::ImageConstPtr image, disparity;
+    };
+}
+
+bool DatasetExporter::open(const std::string &dir, size_t chunk_mb, size_t max_queue, double wait) {
+    box_wait = wait;
+    return writer.open(dir, chunk_mb, max_queue);
+}
+
+void DatasetExporter::subscribe(ros::NodeHandle &nh) {
+    subscribers.push_back(nh.subscribe(topics.image, 5, &DatasetExporter::imageCallback, this));
+    subscribers.push_back(nh.subscribe(topics.disparity, 5, &DatasetExporter::disparityCallback, this));
+    subscribers.push_back(nh.subscribe(topics.boxes, 10, &DatasetExporter::boxesCallback, this));
+    subscribers.push_back(nh.subscribe(topics.gps, 10, &DatasetExporter::gpsCallback, this));
+    subscribers.push_back(nh.subscribe(topics.attitude, 10, &DatasetExporter::attitudeCallback, this));
+    subscribers.push_back(nh.subscribe(topics.local, 10, &DatasetExporter::localCallback, this));
+}
+
+bool DatasetExporter::processBag(const std::string &file) {
+    rosbag::Bag bag;
+    try {
+        bag.open(file, rosbag::bagmode::Read);
+    } catch (rosbag::BagException &e) {
+        ROS_ERROR("Cannot read %s: %s", file.c_str(), e.what());
+        return false;
+    }
+    offline = true;
+    std::vector<std::string> names = {topics.image, topics.disparity, topics.boxes, topics.gps, topics.attitude,
+                                      topics.local};
+    rosbag::View view(bag, rosbag::TopicQuery(names));
+    //! Message time is the time the recorder received it, the same order the live node sees
+    for (const rosbag::MessageInstance &m : view) {
+        bag_time = m.getTime();
+        const std::string &topic = m.getTopic();
+        if (topic == topics.image || topic == topics.disparity) {
+            sensor_msgs::ImageConstPtr image = m.instantiate<sensor_msgs::Image>();
+            if (!image) { continue; }
+            if (topic == topics.image) { imageCallback(image); } else { disparityCallback(image); }
+        } else if (topic == topics.boxes) {
+            darknet_ros_msgs::BoundingBoxesConstPtr boxes = m.instantiate<darknet_ros_msgs::BoundingBoxes>();
+            if (boxes) { boxesCallback(boxes); }
+        } else if (topic == topics.gps) {
+            sensor_msgs::NavSatFixConstPtr gps = m.instantiate<sensor_msgs::NavSatFix>();
+            if (gps) { gpsCallback(gps); }
+        } else if (topic == topics.attitude) {
+            geometry_msgs::QuaternionStampedConstPtr attitude = m.instantiate<geometry_msgs::QuaternionStamped>();
+            if (attitude) { attitudeCallback(attitude); }
+        } else if (topic == topics.local) {
+            geometry_msgs::PointStampedConstPtr local = m.instantiate<geometry_msgs::PointStamped>();
+            if (local) { localCallback(local); }
+        }
+    }
+    bag.close();
+    return true;
+}
+
+void DatasetExporter::close() {
+    flush(true);
+    writer.close();
+    ROS_INFO("Dataset: %lu frames written, %lu dropped, %lu late detections", (unsigned long) writer.getWritten(),
+             (unsigned long) writer.getDropped(), (unsigned long) late_boxes);
+}
+
+bool DatasetExporter::toMat(const sensor_msgs::ImageConstPtr &msg, cv::Mat &mat) {
+    try {
+        //! Shares the message buffer, the record keeps the message alive until written
+        mat = cv_bridge::toCvShare(msg)->image;
+    } catch (cv_bridge::Exception &e) {
+        ROS_ERROR("cv_bridge exception: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+DatasetExporter::Pending &DatasetExporter::frameAt(const ros::Time &stamp) {
+    auto it = pending.find(stamp.toSec());
+    if (it == pending.end()) {
+        it = pending.emplace(stamp.toSec(), Pending()).first;
+        it->second.frame.header = pose;
+        it->second.frame.header.stamp = stamp.toSec();
+        it->second.created = now();
+    }
+    return it->second;
+}
+
+void DatasetExporter::flush(bool everything) {
+    const ros::Time time = now();
+    //! Strictly in stamp order, so the index stays sorted for DatasetReader::findStamp
+    while (!pending.empty()) {
+        Pending &front = pending.begin()->second;
+        bool complete = front.image_msg && front.disparity_msg;
+        bool ready = everything || pending.size() > max_pending || (time - front.created).toSec() > box_wait ||
+                     (complete && (front.frame.header.flags & DATASET_DETECTED));
+        if (!ready) { break; }
+        if (front.image_msg) {
+            front.frame.owner = std::make_shared<MessageOwner>(MessageOwner{front.image_msg, front.disparity_msg});
+            writer.push(std::move(front.frame), offline);
+        }
+        pending.erase(pending.begin());
+    }
+}
+
+void DatasetExporter::imageCallback(const sensor_msgs::ImageConstPtr &msg) {
+    Pending &frame = frameAt(msg->header.stamp);
+    if (toMat(msg, frame.frame.image)) { frame.image_msg = msg; }
+    flush(false);
+}
+
+void DatasetExporter::disparityCallback(const sensor_msgs::ImageConstPtr &msg) {
+    Pending &frame = frameAt(msg->header.stamp);
+    if (toMat(msg, frame.frame.disparity)) { frame.disparity_msg = msg; }
+    flush(false);
+}
+
+/** Darknet sets image_header to the header of the image it ran on, which is the header
+ *  of the rectified pair, so boxes join their frame by exact stamp. */
+void DatasetExporter::boxesCallback(const darknet_ros_msgs::BoundingBoxesConstPtr &msg) {
+    const double stamp = msg->image_header.stamp.toSec();
+    if (!pending.empty() && stamp < pending.begin()->first) {
+        late_boxes++;
+        ROS_WARN_THROTTLE(5, "Detections at %.3f arrived after their frame was written, raise box_wait", stamp);
+        return;
+    }
+    Pending &frame = frameAt(msg->image_header.stamp);
+    frame.frame.header.flags |= DATASET_DETECTED;
+    for (const darknet_ros_msgs::BoundingBox &bb : msg->bounding_boxes) {
+        frame.frame.boxes.push_back({(int32_t) bb.id, (float) bb.probability, (float) bb.xmin, (float) bb.ymin,
+                                     (float) bb.xmax, (float) bb.ymax});
+        writer.setClassName(bb.id, bb.Class);
+    }
+    flush(false);
+}
+
+void DatasetExporter::gpsCallback(const sensor_msgs::NavSatFixConstPtr &msg) {
+    pose.gps_stamp = msg->header.stamp.toSec();
+    pose.latitude = msg->latitude;
+    pose.longitude = msg->longitude;
+    pose.altitude = msg->altitude;
+}
+
+void DatasetExporter::attitudeCallback(const geometry_msgs::QuaternionStampedConstPtr &msg) {
+    pose.attitude_stamp = msg->header.stamp.toSec();
+    pose.qw = msg->quaternion.w;
+    pose.qx = msg->quaternion.x;
+    pose.qy = msg->quaternion.y;
+    pose.qz = msg->quaternion.z;
+}
+
+void DatasetExporter::localCallback(const geometry_msgs::PointStampedConstPtr &msg) {
+    pose.local_stamp = msg->header.stamp.toSec();
+    pose.x = msg->point.x;
+    pose.y = msg->point.y;
+    pose.z = msg->point.z;
+}
@@ -0,0 +1,61 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Training dataset export, see dataset_exporter.h
+//
+//   rosrun riser_inspection dataset_exporter                          live, /dataset_exporter/* params
+//   rosrun riser_inspection dataset_exporter --bag <file.bag> <dir>   offline from a flight bag
+//
+
+#include <dataset_exporter.h>
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "dataset_exporter");
+    DatasetExporter exporter;
+
+    if (argc > 1 && std::string(argv[1]) == "--bag") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --bag <file.bag> <output dir> [chunk MB]\n";
+            return -1;
+        }
+        int chunk_mb = argc > 4 ? atoi(argv[4]) : 256;
+        if (!exporter.open(argv[3], (size_t) std::max(chunk_mb, 1), 60, 1.0)) { return -1; }
+        bool ok = exporter.processBag(argv[2]);
+        exporter.close();
+        return ok ? 0 : -1;
+    }
+
+    ros::NodeHandle nh;
+    char default_dir[64];
+    time_t now = time(nullptr);
+    strftime(default_dir, sizeof(default_dir), "dataset_%Y%m%d_%H%M%S", localtime(&now));
+
+    std::string output_dir;
+    int chunk_mb, max_queue;
+    double box_wait;
+    DatasetExporter::Topics topics;
+    nh.param("/dataset_exporter/output_dir", output_dir, std::string(default_dir));
+    nh.param("/dataset_exporter/chunk_mb", chunk_mb, 256);
+    nh.param("/dataset_exporter/max_queue", max_queue, 60);
+    nh.param("/dataset_exporter/box_wait", box_wait, 1.0);
+    nh.param("/dataset_exporter/image_topic", topics.image, topics.image);
+    nh.param("/dataset_exporter/disparity_topic", topics.disparity, topics.disparity);
+    nh.param("/dataset_exporter/boxes_topic", topics.boxes, topics.boxes);
+    nh.param("/dataset_exporter/gps_topic", topics.gps, topics.gps);
+    nh.param("/dataset_exporter/attitude_topic", topics.attitude, topics.attitude);
+    nh.param("/dataset_exporter/local_topic", topics.local, topics.local);
+
+    if (!exporter.open(output_dir, (size_t) std::max(chunk_mb, 1), (size_t) std::max(max_queue, 1), box_wait)) {
+        ROS_ERROR("Cannot write the dataset to %s", output_dir.c_str());
+        return -1;
+    }
+    ROS_INFO("Recording dataset to %s", output_dir.c_str());
+    exporter.setTopics(topics);
+    exporter.subscribe(nh);
+    ros::spin();
+    exporter.close();
+    return 0;
+}
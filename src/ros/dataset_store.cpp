@@ -0,0 +1,271 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <dataset_store.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    std::string chunkName(const std::string &dir, uint32_t chunk) {
+        char name[32];
+        snprintf(name, sizeof(name), "/chunk_%05u.rds", chunk);
+        return dir + name;
+    }
+
+    size_t matBytes(const cv::Mat &mat) {
+        return mat.empty() ? 0 : mat.total() * mat.elemSize();
+    }
+
+    /// A record's image shape agrees with its byte count, checked before anything is allocated
+    bool shapeMatches(int32_t rows, int32_t cols, int32_t type, uint64_t bytes) {
+        if (bytes == 0) { return true; }
+        if (rows <= 0 || cols <= 0 || rows > DATASET_MAX_SIDE || cols > DATASET_MAX_SIDE ||
+            type != CV_MAT_TYPE(type)) {
+            return false;
+        }
+        return (uint64_t) rows * (uint64_t) cols * (uint64_t) CV_ELEM_SIZE(type) == bytes;
+    }
+}
+
+DatasetWriter::DatasetWriter() : chunk_bytes(0), max_queue(0), running(false), written(0), dropped(0) {
+}
+
+DatasetWriter::~DatasetWriter() {
+    close();
+}
+
+bool DatasetWriter::open(const std::string &dir, size_t chunk_mb, size_t queue_size) {
+    if (running) { return false; }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Cannot create " << dir << "\n";
+        return false;
+    }
+    directory = dir;
+    failed = false;
+    chunk_bytes = (uint64_t) std::max<size_t>(chunk_mb, 1) << 20;
+    max_queue = std::max<size_t>(queue_size, 1);
+    index = fopen((dir + "/index.rds").c_str(), "wb");
+    if (index == nullptr || !openChunk()) {
+        std::cerr << "Cannot write to " << dir << "\n";
+        return false;
+    }
+    running = true;
+    worker = std::thread(&DatasetWriter::run, this);
+    return true;
+}
+
+bool DatasetWriter::openChunk() {
+    chunk = fopen(chunkName(directory, chunk_number).c_str(), "wb");
+    chunk_offset = 0;
+    return chunk != nullptr;
+}
+
+bool DatasetWriter::push(DatasetFrame &&frame, bool wait) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (wait) {
+        queue_space.wait(lock, [this]() { return !running || queue.size() < max_queue; });
+    }
+    if (!running || queue.size() >= max_queue) {
+        dropped++;
+        return false;
+    }
+    queue.push_back(std::move(frame));
+    queue_ready.notify_one();
+    return true;
+}
+
+void DatasetWriter::setClassName(int id, const std::string &name) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    classes[id] = name;
+}
+
+void DatasetWriter::run() {
+    while (true) {
+        DatasetFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [this]() { return !running || !queue.empty(); });
+            //! Drain what is queued before leaving, a stopped recording keeps every accepted frame
+            if (queue.empty()) { break; }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        queue_space.notify_one();
+        if (write(frame)) {
+            written++;
+        } else {
+            dropped++;
+        }
+    }
+}
+
+bool DatasetWriter::write(DatasetFrame &frame) {
+    if (failed) { return false; }
+    if (!frame.image.empty() && !frame.image.isContinuous()) { frame.image = frame.image.clone(); }
+    if (!frame.disparity.empty() && !frame.disparity.isContinuous()) { frame.disparity = frame.disparity.clone(); }
+
+    DatasetHeader &header = frame.header;
+    header.magic = DATASET_MAGIC;
+    header.header_size = sizeof(DatasetHeader);
+    header.frame = frames;
+    header.n_boxes = (uint32_t) frame.boxes.size();
+    header.image_rows = frame.image.rows;
+    header.image_cols = frame.image.cols;
+    header.image_type = frame.image.type();
+    header.image_bytes = matBytes(frame.image);
+    header.disparity_rows = frame.disparity.rows;
+    header.disparity_cols = frame.disparity.cols;
+    header.disparity_type = frame.disparity.type();
+    header.disparity_bytes = matBytes(frame.disparity);
+    const uint64_t size = sizeof(DatasetHeader) + frame.boxes.size() * sizeof(DatasetBox) +
+                          header.image_bytes + header.disparity_bytes;
+
+    if (chunk_offset > 0 && chunk_offset + size > chunk_bytes) {
+        fclose(chunk);
+        chunk_number++;
+        if (!openChunk()) {
+            std::cerr << "Cannot create " << chunkName(directory, chunk_number) << ", recording stopped\n";
+            failed = true;
+            return false;
+        }
+    }
+
+    bool ok = fwrite(&header, sizeof(DatasetHeader), 1, chunk) == 1;
+    if (ok && !frame.boxes.empty()) {
+        ok = fwrite(frame.boxes.data(), sizeof(DatasetBox), frame.boxes.size(), chunk) == frame.boxes.size();
+    }
+    if (ok && header.image_bytes > 0) { ok = fwrite(frame.image.data, header.image_bytes, 1, chunk) == 1; }
+    if (ok && header.disparity_bytes > 0) {
+        ok = fwrite(frame.disparity.data, header.disparity_bytes, 1, chunk) == 1;
+    }
+    //! The record is on disk before the index points to it, a cut recording stays readable
+    ok = ok && fflush(chunk) == 0;
+    if (!ok) { return discardRecord(); }
+
+    DatasetIndexEntry entry = {frames, header.stamp, chunk_number, 0, chunk_offset, size};
+    if (fwrite(&entry, sizeof(entry), 1, index) != 1 || fflush(index) != 0) { return discardRecord(); }
+    chunk_offset += size;
+    frames++;
+    return true;
+}
+
+/** Cut a partly written record and its index entry off, so the next record starts where the
+ *  index expects it. Seeking flushes what is still buffered, the truncation then drops it.
+ *  If the files cannot be restored the writer stops, later records would be unreachable. */
+bool DatasetWriter::discardRecord() {
+    const off_t index_end = (off_t) (frames * sizeof(DatasetIndexEntry));
+    bool restored = fseeko(chunk, (off_t) chunk_offset, SEEK_SET) == 0 &&
+                    ftruncate(fileno(chunk), (off_t) chunk_offset) == 0;
+    restored = fseeko(index, index_end, SEEK_SET) == 0 && ftruncate(fileno(index), index_end) == 0 && restored;
+    clearerr(chunk);
+    clearerr(index);
+    if (!restored) {
+        std::cerr << "Cannot restore " << chunkName(directory, chunk_number) << " after a failed write, "
+                  << "recording stopped\n";
+        failed = true;
+    }
+    return false;
+}
+
+void DatasetWriter::close() {
+    if (!running) { return; }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        running = false;
+    }
+    queue_ready.notify_all();
+    queue_space.notify_all();
+    if (worker.joinable()) { worker.join(); }
+    if (chunk) { fclose(chunk); }
+    if (index) { fclose(index); }
+    chunk = index = nullptr;
+
+    std::ofstream names(directory + "/classes.txt");
+    for (const auto &name : classes) {
+        names << name.first << " " << name.second << "\n";
+    }
+}
+
+DatasetReader::~DatasetReader() {
+    for (FILE *file : chunks) {
+        if (file) { fclose(file); }
+    }
+}
+
+bool DatasetReader::open(const std::string &dir) {
+    directory = dir;
+    FILE *index = fopen((dir + "/index.rds").c_str(), "rb");
+    if (index == nullptr) { return false; }
+    fseeko(index, 0, SEEK_END);
+    off_t bytes = ftello(index);
+    fseeko(index, 0, SEEK_SET);
+    //! A partial entry at the end is a recording cut while writing it
+    entries.resize((size_t) bytes / sizeof(DatasetIndexEntry));
+    size_t read = entries.empty() ? 0 : fread(entries.data(), sizeof(DatasetIndexEntry), entries.size(), index);
+    entries.resize(read);
+    fclose(index);
+    return true;
+}
+
+bool DatasetReader::read(size_t frame, DatasetFrame &out) {
+    if (frame >= entries.size()) { return false; }
+    const DatasetIndexEntry &entry = entries[frame];
+    if (entry.chunk >= chunks.size()) { chunks.resize(entry.chunk + 1, nullptr); }
+    FILE *&file = chunks[entry.chunk];
+    if (file == nullptr) { file = fopen(chunkName(directory, entry.chunk).c_str(), "rb"); }
+    if (file == nullptr || fseeko(file, (off_t) entry.offset, SEEK_SET) != 0) { return false; }
+
+    DatasetHeader &header = out.header;
+    if (fread(&header, sizeof(DatasetHeader), 1, file) != 1 || header.magic != DATASET_MAGIC ||
+        header.header_size != sizeof(DatasetHeader)) {
+        return false;
+    }
+    //! A corrupt or foreign record is rejected before its sizes are trusted
+    if (header.n_boxes > DATASET_MAX_BOXES ||
+        !shapeMatches(header.image_rows, header.image_cols, header.image_type, header.image_bytes) ||
+        !shapeMatches(header.disparity_rows, header.disparity_cols, header.disparity_type, header.disparity_bytes) ||
+        sizeof(DatasetHeader) + header.n_boxes * sizeof(DatasetBox) + header.image_bytes + header.disparity_bytes !=
+        entry.size) {
+        std::cerr << "Corrupt dataset record " << entry.frame << " in " << chunkName(directory, entry.chunk) << "\n";
+        return false;
+    }
+    out.boxes.resize(header.n_boxes);
+    if (header.n_boxes > 0 &&
+        fread(out.boxes.data(), sizeof(DatasetBox), header.n_boxes, file) != header.n_boxes) {
+        return false;
+    }
+    out.image = cv::Mat();
+    out.disparity = cv::Mat();
+    out.owner.reset();
+    if (header.image_bytes > 0) {
+        out.image.create(header.image_rows, header.image_cols, header.image_type);
+        if (matBytes(out.image) != header.image_bytes ||
+            fread(out.image.data, header.image_bytes, 1, file) != 1) {
+            return false;
+        }
+    }
+    if (header.disparity_bytes > 0) {
+        out.disparity.create(header.disparity_rows, header.disparity_cols, header.disparity_type);
+        if (matBytes(out.disparity) != header.disparity_bytes ||
+            fread(out.disparity.data, header.disparity_bytes, 1, file) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t DatasetReader::findStamp(double stamp) const {
+    if (entries.empty()) { return 0; }
+    auto it = std::lower_bound(entries.begin(), entries.end(), stamp,
+                               [](const DatasetIndexEntry &entry, double t) { return entry.stamp < t; });
+    size_t i = (size_t) (it - entries.begin());
+    if (i == entries.size()) { return i - 1; }
+    if (i > 0 && fabs(entries[i - 1].stamp - stamp) < fabs(entries[i].stamp - stamp)) { return i - 1; }
+    return i;
+}
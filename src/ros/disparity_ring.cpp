@@ -0,0 +1,57 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <disparity_ring.h>
+
+DisparityRing::DisparityRing(size_t capacity) : slots(std::max<size_t>(capacity, 1)) {
+}
+
+DisparityRing::Frame &DisparityRing::at(size_t i) {
+    return slots[(head + slots.size() - count + i) % slots.size()];
+}
+
+bool DisparityRing::push(const sensor_msgs::ImageConstPtr &msg) {
+    if (count > 0 && msg->header.stamp < latest()->msg->header.stamp) { return false; }
+    Frame &frame = slots[head];
+    frame.msg = msg;
+    frame.image = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::MONO8);
+    frame.integral_ready = false;
+    head = (head + 1) % slots.size();
+    count = std::min(count + 1, slots.size());
+    return true;
+}
+
+DisparityRing::Frame *DisparityRing::find(const ros::Time &stamp, double tolerance) {
+    if (count == 0) { return nullptr; }
+    //! First frame not older than stamp
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (at(mid).msg->header.stamp < stamp) { low = mid + 1; } else { high = mid; }
+    }
+    Frame *best = nullptr;
+    double best_dt = tolerance;
+    for (size_t i = low > 0 ? low - 1 : 0; i <= low && i < count; i++) {
+        double dt = fabs((at(i).msg->header.stamp - stamp).toSec());
+        if (dt <= best_dt) {
+            best_dt = dt;
+            best = &at(i);
+        }
+    }
+    return best;
+}
+
+DisparityRing::Frame *DisparityRing::latest() {
+    return count == 0 ? nullptr : &at(count - 1);
+}
+
+void DisparityRing::buildIntegral(Frame &frame) {
+    if (frame.integral_ready) { return; }
+    //! Same size every lap, so cv::integral writes into the buffers already allocated
+    cv::compare(frame.image->image, 0, frame.valid_mask, cv::CMP_GT);
+    cv::integral(frame.image->image, frame.disp_sum, CV_32S);
+    frame.valid_mask.setTo(1, frame.valid_mask);
+    cv::integral(frame.valid_mask, frame.valid_count, CV_32S);
+    frame.integral_ready = true;
+}
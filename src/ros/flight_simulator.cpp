@@ -0,0 +1,430 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <flight_simulator.h>
+#include <dji_mission_type.hpp>
+#include <cmath>
+
+namespace {
+    const double EARTH_RADIUS = 6371000;
+
+    double deg2rad(double deg) { return deg * M_PI / 180; }
+
+    double wrap_angle(double angle) {
+        while (angle > 180) { angle -= 360; }
+        while (angle < -180) { angle += 360; }
+        return angle;
+    }
+}
+
+FlightSimulator::FlightSimulator() {
+    FlightSimulator::advertising(nh_);
+}
+
+FlightSimulator::~FlightSimulator() {
+    mission_running = false;
+    if (mission_thread.joinable()) { mission_thread.join(); }
+}
+
+void FlightSimulator::advertising(ros::NodeHandle &nh) {
+    double initial_height, attitude_rate, telemetry_rate;
+    nh.param("/flight_simulator/max_speed", max_speed, 2.0);
+    nh.param("/flight_simulator/max_accel", max_accel, 1.0);
+    nh.param("/flight_simulator/max_yaw_rate", max_yaw_rate, 60.0);
+    nh.param("/flight_simulator/settle_time", settle_time, 1.0);
+    nh.param("/flight_simulator/task_timeout", task_timeout, 60.0);
+    nh.param("/flight_simulator/photo_latency", photo_latency, 0.8);
+    nh.param("/flight_simulator/stereo_latency", stereo_latency, 0.3);
+    nh.param("/flight_simulator/physics_rate", physics_rate, 200.0);
+    nh.param("/flight_simulator/attitude_rate", attitude_rate, 100.0);
+    nh.param("/flight_simulator/telemetry_rate", telemetry_rate, 50.0);
+    nh.param("/flight_simulator/home_latitude", home_lat, -27.6);
+    nh.param("/flight_simulator/home_longitude", home_lon, -48.5);
+    nh.param("/flight_simulator/initial_height", initial_height, 5.0);
+    nh.param("/flight_simulator/initial_heading", state.heading, 0.0);
+
+    state.z = state.target_z = initial_height;
+    state.target_heading = state.heading;
+    state.in_air = initial_height > 0;
+
+    //! Telemetry, same topics as dji_vehicle_node
+    gps_pub = nh.advertise<sensor_msgs::NavSatFix>("/dji_osdk_ros/gps_position", 10);
+    attitude_pub = nh.advertise<geometry_msgs::QuaternionStamped>("/dji_osdk_ros/attitude", 10);
+    local_pos_pub = nh.advertise<geometry_msgs::PointStamped>("/dji_osdk_ros/local_position", 10);
+    height_pub = nh.advertise<std_msgs::Float32>("/dji_osdk_ros/height_above_takeoff", 10);
+    velocity_pub = nh.advertise<geometry_msgs::Vector3Stamped>("/dji_osdk_ros/velocity", 10);
+    flight_status_pub = nh.advertise<std_msgs::UInt8>("/dji_osdk_ros/flight_status", 10);
+
+    std::string setpoint_topic;
+    nh.param("/flight_simulator/setpoint_topic", setpoint_topic,
+             std::string("/dji_osdk_ros/flight_control_setpoint_ENUvelocity_yawrate"));
+    setpoint_sub = nh.subscribe<sensor_msgs::Joy>(setpoint_topic, 10, &FlightSimulator::setpoint_callback, this);
+
+    //! Services
+    task_control_service = nh.advertiseService("/flight_task_control", &FlightSimulator::task_control_cb, this);
+    control_authority_service = nh.advertiseService("/obtain_release_control_authority",
+                                                    &FlightSimulator::control_authority_cb, this);
+    local_ref_service = nh.advertiseService("/set_local_pos_reference", &FlightSimulator::local_ref_cb, this);
+    gimbal_service = nh.advertiseService("/gimbal_task_control", &FlightSimulator::gimbal_cb, this);
+    camera_photo_service = nh.advertiseService("camera_start_shoot_single_photo",
+                                               &FlightSimulator::camera_photo_cb, this);
+    camera_video_service = nh.advertiseService("camera_record_video_action", &FlightSimulator::camera_video_cb, this);
+    sv3d_service = nh.advertiseService("/stereo_point_grey/take_picture", &FlightSimulator::sv3d_cb, this);
+    waypoint_upload_service = nh.advertiseService("dji_osdk_ros/mission_waypoint_upload",
+                                                  &FlightSimulator::waypoint_upload_cb, this);
+    waypoint_action_service = nh.advertiseService("dji_osdk_ros/mission_waypoint_action",
+                                                  &FlightSimulator::waypoint_action_cb, this);
+    emergency_brake_service = nh.advertiseService("emergency_brake", &FlightSimulator::emergency_brake_cb, this);
+
+    physics_timer = nh.createTimer(ros::Duration(1.0 / physics_rate), &FlightSimulator::physics_callback, this);
+    attitude_timer = nh.createTimer(ros::Duration(1.0 / attitude_rate), &FlightSimulator::attitude_callback, this);
+    telemetry_timer = nh.createTimer(ros::Duration(1.0 / telemetry_rate), &FlightSimulator::telemetry_callback,
+                                     this);
+
+    ROS_INFO("Flight simulator ready: %.1f m/s, %.1f m/s^2, %.1f s settle", max_speed, max_accel, settle_time);
+}
+
+/** Point-mass model: speed toward the target follows a trapezoidal profile limited
+ *  by max_speed and max_accel, heading turns at max_yaw_rate. A fresh velocity
+ *  setpoint replaces the target and the aircraft holds where the stream stops. */
+void FlightSimulator::step(double dt) {
+    double dx = state.target_x - state.x;
+    double dy = state.target_y - state.y;
+    double dz = state.target_z - state.z;
+    double dist = sqrt(dx * dx + dy * dy + dz * dz);
+    bool velocity_mode = !state.setpoint_stamp.isZero() &&
+                         (ros::Time::now() - state.setpoint_stamp).toSec() < setpoint_timeout;
+
+    double desired_vx = 0, desired_vy = 0, desired_vz = 0;
+    if (velocity_mode) {
+        double speed = sqrt(state.cmd_vx * state.cmd_vx + state.cmd_vy * state.cmd_vy + state.cmd_vz * state.cmd_vz);
+        double scale = speed > max_speed ? max_speed / speed : 1;
+        desired_vx = state.cmd_vx * scale;
+        desired_vy = state.cmd_vy * scale;
+        desired_vz = state.cmd_vz * scale;
+    } else if (dist > 1e-3) {
+        double speed = std::min(max_speed, sqrt(2 * max_accel * dist));
+        desired_vx = dx / dist * speed;
+        desired_vy = dy / dist * speed;
+        desired_vz = dz / dist * speed;
+    }
+    double dvx = desired_vx - state.vx, dvy = desired_vy - state.vy, dvz = desired_vz - state.vz;
+    double dv = sqrt(dvx * dvx + dvy * dvy + dvz * dvz);
+    double dv_max = max_accel * dt;
+    if (dv > dv_max) {
+        dvx *= dv_max / dv;
+        dvy *= dv_max / dv;
+        dvz *= dv_max / dv;
+    }
+    state.vx += dvx;
+    state.vy += dvy;
+    state.vz += dvz;
+    state.x += state.vx * dt;
+    state.y += state.vy * dt;
+    state.z = std::max(0.0, state.z + state.vz * dt);
+
+    double yaw_error = wrap_angle(state.target_heading - state.heading);
+    if (velocity_mode) { yaw_error = -state.cmd_yaw_rate * 180 / M_PI * dt; }
+    double yaw_step = max_yaw_rate * dt;
+    state.heading = wrap_angle(state.heading + std::max(-yaw_step, std::min(yaw_step, yaw_error)));
+
+    if (velocity_mode) {
+        state.target_x = state.x;
+        state.target_y = state.y;
+        state.target_z = state.z;
+        state.target_heading = state.heading;
+    }
+}
+
+void FlightSimulator::setpoint_callback(const sensor_msgs::Joy::ConstPtr &msg) {
+    if (msg->axes.size() < 4) { return; }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (!state.authority || !state.in_air) { return; }
+    state.cmd_vx = msg->axes[0];
+    state.cmd_vy = msg->axes[1];
+    state.cmd_vz = msg->axes[2];
+    state.cmd_yaw_rate = msg->axes[3];
+    state.setpoint_stamp = ros::Time::now();
+}
+
+void FlightSimulator::physics_callback(const ros::TimerEvent &event) {
+    double dt = 1.0 / physics_rate;
+    if (!event.last_real.isZero()) { dt = (event.current_real - event.last_real).toSec(); }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (state.in_air) { step(dt); }
+}
+
+void FlightSimulator::attitude_callback(const ros::TimerEvent &event) {
+    geometry_msgs::QuaternionStamped atti;
+    atti.header.stamp = ros::Time::now();
+    atti.header.frame_id = "body_FLU";
+    double enu_yaw;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        enu_yaw = (90 - state.heading) * M_PI / 180;
+    }
+    //! Level attitude, FLU body w.r.t. ENU ground as published by dji_vehicle_node
+    atti.quaternion.w = cos(enu_yaw / 2);
+    atti.quaternion.x = 0;
+    atti.quaternion.y = 0;
+    atti.quaternion.z = sin(enu_yaw / 2);
+    attitude_pub.publish(atti);
+}
+
+void FlightSimulator::telemetry_callback(const ros::TimerEvent &event) {
+    SimulatedState s;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        s = state;
+    }
+    ros::Time stamp = ros::Time::now();
+
+    sensor_msgs::NavSatFix gps;
+    gps.header.stamp = stamp;
+    gps.header.frame_id = "gps";
+    gps.latitude = home_lat + (s.y / EARTH_RADIUS) * 180 / M_PI;
+    gps.longitude = home_lon + (s.x / (EARTH_RADIUS * cos(home_lat * M_PI / 180))) * 180 / M_PI;
+    gps.altitude = s.z;
+    gps.status.status = sensor_msgs::NavSatStatus::STATUS_FIX;
+    gps_pub.publish(gps);
+
+    geometry_msgs::PointStamped local_pos;
+    local_pos.header.stamp = stamp;
+    local_pos.header.frame_id = "local_ENU";
+    local_pos.point.x = s.x - s.origin_x;
+    local_pos.point.y = s.y - s.origin_y;
+    local_pos.point.z = s.z - s.origin_z;
+    local_pos_pub.publish(local_pos);
+
+    std_msgs::Float32 height;
+    height.data = (float) s.z;
+    height_pub.publish(height);
+
+    geometry_msgs::Vector3Stamped velocity;
+    velocity.header.stamp = stamp;
+    velocity.header.frame_id = "ground_ENU";
+    velocity.vector.x = s.vx;
+    velocity.vector.y = s.vy;
+    velocity.vector.z = s.vz;
+    velocity_pub.publish(velocity);
+
+    std_msgs::UInt8 flight_status;
+    flight_status.data = s.in_air ? 2 : 1;
+    flight_status_pub.publish(flight_status);
+}
+
+/// Block like the onboard task until the aircraft holds the target for settle_time
+bool FlightSimulator::wait_target(double pos_thresh, double yaw_thresh) {
+    ros::Rate rate(50);
+    ros::Time start = ros::Time::now();
+    ros::Time inside_since;
+    bool inside = false;
+    while (ros::ok()) {
+        bool reached;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            double dx = state.target_x - state.x, dy = state.target_y - state.y, dz = state.target_z - state.z;
+            reached = sqrt(dx * dx + dy * dy + dz * dz) <= pos_thresh &&
+                      fabs(wrap_angle(state.target_heading - state.heading)) <= yaw_thresh;
+        }
+        ros::Time now = ros::Time::now();
+        if (reached && !inside) { inside_since = now; }
+        inside = reached;
+        if (inside && (now - inside_since).toSec() >= settle_time) { return true; }
+        if ((now - start).toSec() > task_timeout) {
+            ROS_ERROR("Flight task timeout");
+            return false;
+        }
+        rate.sleep();
+    }
+    return false;
+}
+
+bool FlightSimulator::task_control_cb(dji_osdk_ros::FlightTaskControl::Request &req,
+                                      dji_osdk_ros::FlightTaskControl::Response &res) {
+    double pos_thresh = 0.1, yaw_thresh = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (!state.authority) {
+            ROS_ERROR("Flight task rejected, no control authority");
+            res.result = false;
+            return true;
+        }
+        switch (req.task) {
+            case dji_osdk_ros::FlightTaskControl::Request::TASK_POSITION_AND_YAW_CONTROL:
+                //! Offsets are north, east, up
+                state.target_x = state.x + req.joystickCommand.y;
+                state.target_y = state.y + req.joystickCommand.x;
+                state.target_z = state.z + req.joystickCommand.z;
+                state.target_heading = wrap_angle(req.joystickCommand.yaw);
+                pos_thresh = req.posThresholdInM;
+                yaw_thresh = req.yawThresholdInDeg;
+                break;
+            case dji_osdk_ros::FlightTaskControl::Request::TASK_TAKEOFF:
+                state.in_air = true;
+                state.target_z = 1.2;
+                break;
+            case dji_osdk_ros::FlightTaskControl::Request::TASK_GOHOME:
+            case dji_osdk_ros::FlightTaskControl::Request::TASK_GOHOME_AND_CONFIRM_LANDING:
+                state.target_x = 0;
+                state.target_y = 0;
+                state.target_z = 0;
+                break;
+            case dji_osdk_ros::FlightTaskControl::Request::TASK_LAND:
+                state.target_x = state.x;
+                state.target_y = state.y;
+                state.target_z = 0;
+                break;
+            default:
+                ROS_WARN("Flight task %d not simulated", (int) req.task);
+                res.result = false;
+                return true;
+        }
+    }
+    res.result = wait_target(std::max(pos_thresh, 0.05), std::max(yaw_thresh, 0.5));
+    if (res.result && req.task != dji_osdk_ros::FlightTaskControl::Request::TASK_POSITION_AND_YAW_CONTROL &&
+        req.task != dji_osdk_ros::FlightTaskControl::Request::TASK_TAKEOFF) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        state.in_air = false;
+    }
+    return true;
+}
+
+bool FlightSimulator::control_authority_cb(dji_osdk_ros::ObtainControlAuthority::Request &req,
+                                           dji_osdk_ros::ObtainControlAuthority::Response &res) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    state.authority = req.enable_obtain;
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::local_ref_cb(dji_osdk_ros::SetLocalPosRef::Request &req,
+                                   dji_osdk_ros::SetLocalPosRef::Response &res) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    state.origin_x = state.x;
+    state.origin_y = state.y;
+    state.origin_z = state.z;
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::camera_photo_cb(dji_osdk_ros::CameraStartShootSinglePhoto::Request &req,
+                                      dji_osdk_ros::CameraStartShootSinglePhoto::Response &res) {
+    ros::Duration(photo_latency).sleep();
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::camera_video_cb(dji_osdk_ros::CameraRecordVideoAction::Request &req,
+                                      dji_osdk_ros::CameraRecordVideoAction::Response &res) {
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::gimbal_cb(dji_osdk_ros::GimbalAction::Request &req,
+                                dji_osdk_ros::GimbalAction::Response &res) {
+    ros::Duration(req.time).sleep();
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::sv3d_cb(stereo_vant::PointGray::Request &req, stereo_vant::PointGray::Response &res) {
+    ros::Duration(stereo_latency).sleep();
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::waypoint_upload_cb(dji_osdk_ros::MissionWpUpload::Request &req,
+                                         dji_osdk_ros::MissionWpUpload::Response &res) {
+    if (mission_running || req.waypoint_task.mission_waypoint.size() < 2) {
+        res.result = false;
+        return true;
+    }
+    mission = req.waypoint_task.mission_waypoint;
+    ROS_INFO("Waypoint mission uploaded: %i waypoints", (int) mission.size());
+    res.result = true;
+    return true;
+}
+
+bool FlightSimulator::waypoint_action_cb(dji_osdk_ros::MissionWpAction::Request &req,
+                                         dji_osdk_ros::MissionWpAction::Response &res) {
+    res.result = true;
+    switch (req.action) {
+        case DJI::OSDK::MISSION_ACTION::START:
+            if (mission_running || mission.empty()) {
+                res.result = false;
+                break;
+            }
+            if (mission_thread.joinable()) { mission_thread.join(); }
+            mission_running = true;
+            mission_thread = std::thread(&FlightSimulator::fly_mission, this);
+            break;
+        case DJI::OSDK::MISSION_ACTION::STOP:
+            mission_running = false;
+            mission_paused = false;
+            break;
+        case DJI::OSDK::MISSION_ACTION::PAUSE: {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            mission_paused = true;
+            leg_interrupted = true;
+            state.target_x = state.x;
+            state.target_y = state.y;
+            state.target_z = state.z;
+            break;
+        }
+        case DJI::OSDK::MISSION_ACTION::RESUME:
+            mission_paused = false;
+            break;
+        default:
+            ROS_WARN("Mission action %d not simulated", (int) req.action);
+            res.result = false;
+    }
+    return true;
+}
+
+/// Fly the uploaded waypoints in order, executing stay and shot actions at each one
+void FlightSimulator::fly_mission() {
+    for (int k = 0; k < (int) mission.size() && mission_running && ros::ok(); k++) {
+        const dji_osdk_ros::MissionWaypoint &wp = mission[k];
+        bool reached = false;
+        do {
+            while (mission_paused && mission_running && ros::ok()) { ros::Duration(0.05).sleep(); }
+            leg_interrupted = false;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                state.target_x = deg2rad(wp.longitude - home_lon) * EARTH_RADIUS * cos(deg2rad(home_lat));
+                state.target_y = deg2rad(wp.latitude - home_lat) * EARTH_RADIUS;
+                state.target_z = wp.altitude;
+                state.target_heading = wrap_angle(wp.target_yaw);
+            }
+            reached = wait_target(0.2, 2.0);
+            //! A pause or brake moves the target, fly the leg again once released
+        } while (reached && leg_interrupted && mission_running && ros::ok());
+        if (!reached) { break; }
+        int n_actions = wp.waypoint_action.action_repeat & 0x0F;
+        for (int a = 0; a < n_actions && a < (int) wp.waypoint_action.command_list.size(); a++) {
+            if (wp.waypoint_action.command_list[a] == DJI::OSDK::WP_ACTION_STAY) {
+                ros::Duration(wp.waypoint_action.command_parameter[a] / 1000.0).sleep();
+            } else if (wp.waypoint_action.command_list[a] == DJI::OSDK::WP_ACTION_SIMPLE_SHOT) {
+                ros::Duration(photo_latency).sleep();
+            }
+        }
+    }
+    ROS_INFO("Waypoint mission %s", mission_running ? "finished" : "stopped");
+    mission_running = false;
+}
+
+/// Stop where the aircraft is, a running task or mission leg ends as interrupted
+bool FlightSimulator::emergency_brake_cb(dji_osdk_ros::EmergencyBrake::Request &req,
+                                         dji_osdk_ros::EmergencyBrake::Response &res) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    leg_interrupted = true;
+    state.vx = state.vy = state.vz = 0;
+    state.target_x = state.x;
+    state.target_y = state.y;
+    state.target_z = state.z;
+    state.setpoint_stamp = ros::Time();
+    res.result = true;
+    return true;
+}
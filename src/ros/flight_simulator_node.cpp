@@ -0,0 +1,12 @@
+#include <flight_simulator.h>
+
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "flight_simulator");
+    FlightSimulator simulator;
+    //! Flight tasks block until the target is reached, keep the telemetry timers on other threads
+    ros::AsyncSpinner spinner(4);
+    spinner.start();
+    ros::waitForShutdown();
+    return 0;
+}
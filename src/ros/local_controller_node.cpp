@@ -5,9 +5,9 @@
 int main(int argc, char **argv) {
     ros::init(argc, argv, "local_controller_node");
     LocalController local_controller;
-//    ros::spin();
-    while(ros::ok()) {
-        ros::spinOnce();
-    }
+    //! Telemetry and service callbacks run on the spinner threads, the mission runs on its own executor thread
+    ros::AsyncSpinner spinner(4);
+    spinner.start();
+    ros::waitForShutdown();
     return 0;
 }
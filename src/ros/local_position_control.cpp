@@ -4,12 +4,18 @@
 
 #include <local_position_control.h>
 #include <dji_control.hpp>
+#include <dji_mission_type.hpp>
 
 LocalController::LocalController() {
     subscribing(nh_);
+    mission_thread = std::thread(&LocalController::mission_executor, this);
 }
 
-LocalController::~LocalController() = default;
+LocalController::~LocalController() {
+    executor_running = false;
+    mission_cv.notify_all();
+    if (mission_thread.joinable()) { mission_thread.join(); }
+}
 
 void LocalController::subscribing(ros::NodeHandle &nh) {
     std::string gps_topic, rtk_topic, attitude_topic, height_topic, local_pos_topic;
@@ -29,18 +35,68 @@ void LocalController::subscribing(ros::NodeHandle &nh) {
     height_sub = nh.subscribe<std_msgs::Float32>(height_topic, 1, &LocalController::height_callback, this);
 
 
+    std::string setpoint_topic;
+    nh.param("/riser_inspection/setpoint_topic", setpoint_topic,
+             std::string("/dji_osdk_ros/flight_control_setpoint_ENUvelocity_yawrate"));
+    setpoint_pub = nh.advertise<sensor_msgs::Joy>(setpoint_topic, 10);
+
     //! Service topics
     obtain_crl_authority_client = nh.serviceClient<dji_osdk_ros::ObtainControlAuthority>(
             "/obtain_release_control_authority");
     set_local_ref_client = nh.serviceClient<dji_osdk_ros::SetLocalPosRef>("/set_local_pos_reference");
     task_control_client = nh.serviceClient<dji_osdk_ros::FlightTaskControl>("/flight_task_control");
     gimbal_control_client = nh.serviceClient<dji_osdk_ros::GimbalAction>("/gimbal_task_control");
+    //! Stereo riser position from darknet_disparity, drives the standoff correction
+    std::string standoff_topic;
+    int standoff_window;
+    double standoff_alpha, standoff_gate;
+    nh.param("/riser_inspection/standoff_correction", standoff_correction, false);
+    nh.param("/riser_inspection/standoff_topic", standoff_topic, std::string("/darknet_distance/object_position"));
+    nh.param("/riser_inspection/standoff_window", standoff_window, 9);
+    nh.param("/riser_inspection/standoff_alpha", standoff_alpha, 0.3);
+    nh.param("/riser_inspection/standoff_outlier_gate", standoff_gate, 0.5);
+    nh.param("/riser_inspection/standoff_deadband", standoff_deadband, 0.1);
+    nh.param("/riser_inspection/standoff_max_step", standoff_max_step, 0.5);
+    nh.param("/riser_inspection/standoff_max_total", standoff_max_total, 2.0);
+    standoff.setParameters(standoff_window, (standoff_window + 1) / 2, standoff_alpha, standoff_gate, 1.0);
+    if (standoff_correction) {
+        standoff_sub = nh.subscribe<geometry_msgs::PointStamped>(standoff_topic, 10,
+                                                                 &LocalController::standoff_callback, this);
+    }
+
+    std::string cylinder_topic;
+    nh.param("/riser_inspection/riser_from_stereo", riser_from_stereo, false);
+    nh.param("/riser_inspection/cylinder_topic", cylinder_topic, std::string("/stereo_depth_perception/riser_cylinder"));
+    if (riser_from_stereo) {
+        cylinder_sub = nh.subscribe<riser_inspection::RiserCylinder>(cylinder_topic, 1,
+                                                                     &LocalController::cylinder_callback, this);
+    }
+
+    //! Proximity guard, brakes on the sector distances of m210_stereo_rect_depth
+    std::string sector_topic, brake_service;
+    nh.param("/riser_inspection/proximity_guard", proximity_guard, false);
+    nh.param("/riser_inspection/sector_topic", sector_topic, std::string("/stereo_depth_perception/sector_distances"));
+    nh.param("/riser_inspection/emergency_brake_service", brake_service, std::string("emergency_brake"));
+    nh.param("/riser_inspection/proximity_stop_distance", proximity_stop, 2.0);
+    nh.param("/riser_inspection/proximity_clear_distance", proximity_clear, 2.5);
+    nh.param("/riser_inspection/proximity_timeout", proximity_timeout, 0.5);
+    nh.param("/riser_inspection/proximity_max_latency", proximity_max_latency, 0.15);
+    emergency_brake_client = nh.serviceClient<dji_osdk_ros::EmergencyBrake>(brake_service);
+    if (proximity_guard) {
+        sector_sub = nh.subscribe<riser_inspection::SectorDistances>(sector_topic, 1,
+                                                                     &LocalController::sector_callback, this,
+                                                                     ros::TransportHints().tcpNoDelay());
+        proximity_timer = nh.createWallTimer(ros::WallDuration(0.1), &LocalController::proximity_timer_callback,
+                                             this);
+    }
+
+    waypoint_upload_client = nh.serviceClient<dji_osdk_ros::MissionWpUpload>("dji_osdk_ros/mission_waypoint_upload");
+    waypoint_action_client = nh.serviceClient<dji_osdk_ros::MissionWpAction>("dji_osdk_ros/mission_waypoint_action");
 
     //! Camera services
-    camera_photo_client = nh.serviceClient<dji_osdk_ros::CameraStartShootSinglePhoto>(
-            "camera_start_shoot_single_photo");
     camera_record_video_client = nh.serviceClient<dji_osdk_ros::CameraRecordVideoAction>("camera_record_video_action");
     sv3d_client = nh.serviceClient<stereo_vant::PointGray>("/stereo_point_grey/take_picture");
+    capture_scheduler.init(nh, &telemetry);
 
     local_position_service = nh.advertiseService("/riser_inspection/set_position",
                                                  &LocalController::local_pos_service_cb, this);
@@ -88,16 +144,21 @@ bool LocalController::local_pos_service_cb(riser_inspection::LocalPosition::Requ
 
 bool LocalController::start_mission_service_cb(riser_inspection::StartMission::Request &req,
                                                riser_inspection::StartMission::Response &res) {
-
-    doing_mission = true;
+    //! Claimed at once, the spinner threads may serve two start requests together
+    if (doing_mission.exchange(true)) {
+        ROS_WARN("Mission already running");
+        res.result = false;
+        return res.result;
+    }
     if (req.use_gimbal) {
         use_gimbal = true;
         camera_gimbal = !req.video;
         video_gimbal = req.video;
     }
     use_stereo = req.use_stereo;
-    camera_count = 1;
-    init_heading = -RAD2DEG(current_atti_euler.Yaw());
+    continuous_mode = req.continuous;
+    onboard_mission = req.onboard_mission;
+    init_heading = telemetry.snapshot().heading;
     if (LocalController::set_local_position()) {
         if (use_stereo) {
             stereo_vant::PointGray stereoAction;
@@ -111,60 +172,237 @@ bool LocalController::start_mission_service_cb(riser_inspection::StartMission::R
             ROS_INFO("Set Gimbal to follow aircraft heading");
             LocalController::set_gimbal_angles(0, 0, 0);
         }
-        generate_WP(2);
+        if (!generate_WP(2)) {
+            ROS_ERROR("No waypoints generated, mission not started");
+            doing_mission = false;
+            res.result = false;
+            return res.result;
+        }
+        //! A leg the flight controller would reject is reported before taking control
+        if (onboard_mission && !plan_waypoint_mission()) {
+            doing_mission = false;
+            res.result = false;
+            return res.result;
+        }
+        gimbal_pitch = 0;
+        //! In an onboard mission the flight controller shoots the gimbal camera itself
+        //! The gimbal is re-centred before each shot, except in continuous flight where the move would delay it
+        //! and along an axis, where each pose sets its own pitch
+        capture_scheduler.configure(use_gimbal && camera_gimbal && !onboard_mission, use_stereo,
+                                    pathGenerator.getFileName() + "/stereo_voo" + std::to_string(stereo_count),
+                                    !continuous_mode && !axis_path);
         res.result = LocalController::obtain_control(true);
-    } else { res.result = false; }
+        if (res.result) {
+            //! Only the guard of this mission may hold it
+            proximity_hold = false;
+            leg_interrupted = false;
+            mission_start = ros::WallTime::now();
+            mission_cpu_start = process_cpu_time();
+            if (onboard_mission) {
+                set_mission_state(MissionState::ONBOARD_MISSION);
+            } else {
+                set_mission_state(continuous_mode ? MissionState::TRACK_TRAJECTORY : MissionState::MOVE_TO_WP);
+            }
+        } else { doing_mission = false; }
+    } else {
+        doing_mission = false;
+        res.result = false;
+    }
     return res.result;
 }
 
 
 void LocalController::height_callback(const std_msgs::Float32::ConstPtr &msg) {
-    rpa_height = msg->data;
+    telemetry.setHeight(msg->data);
 }
 
 
-void LocalController::attitude_callback(const geometry_msgs::QuaternionStamped::ConstPtr &msg) {
-    current_atti = *msg;
-    atti_matrix.setRotation(tf::Quaternion(current_atti.quaternion.x, current_atti.quaternion.y,
-                                           current_atti.quaternion.z, current_atti.quaternion.w));
-    tf::Matrix3x3 ROT = {0, -1, 0, -1, 0, 0, 0, 0, -1};
-    atti_matrix *= ROT;
-    atti_matrix.getRotation(q_atti_matrix);
-    //! current_atti_euler after rotations returns [roll=pitch, pitch=roll, yaw = -yaw]
-    //TODO: rotation matrix's to return properly yaw
-    current_atti_euler.Set(q_atti_matrix.getW(), q_atti_matrix.getX(), q_atti_matrix.getY(), q_atti_matrix.getZ());
+void LocalController::standoff_callback(const geometry_msgs::PointStamped::ConstPtr &msg) {
+    //! Horizontal range in the camera frame (x right, z forward)
+    standoff.update(msg->header.stamp.toSec(), std::hypot(msg->point.x, msg->point.z));
+}
+
+void LocalController::cylinder_callback(const riser_inspection::RiserCylinder::ConstPtr &msg) {
+    std::lock_guard<std::mutex> lock(cylinder_mutex);
+    riser_cylinder = *msg;
+}
+
+void LocalController::sector_callback(const riser_inspection::SectorDistances::ConstPtr &msg) {
+    double latency = (ros::Time::now() - msg->header.stamp).toSec();
+    if (latency > proximity_max_latency) {
+        //! Too old to trust, the timer holds the aircraft if no fresh frame follows
+        ROS_WARN_THROTTLE(1, "Sector distances %.0f ms old, limit %.0f ms", latency * 1000,
+                          proximity_max_latency * 1000);
+        return;
+    }
+    last_sector_time = ros::WallTime::now().toSec();
+    if (!proximity_hold && msg->min_distance < proximity_stop) {
+        hold_position();
+        //! Image stamp to brake command, the figure the guard is sized on
+        double hold_latency = (ros::Time::now() - msg->header.stamp).toSec();
+        ROS_WARN("Obstacle at %.2f m in sector %i, holding (%.0f ms from image, %.0f ms stereo)",
+                 msg->min_distance, (int) msg->closest_sector, hold_latency * 1000, msg->processing_time * 1000);
+    } else if (proximity_hold && msg->min_distance > proximity_clear) {
+        proximity_hold = false;
+        ROS_INFO("Proximity clear at %.2f m, resuming", msg->min_distance);
+    }
+}
 
+void LocalController::proximity_timer_callback(const ros::WallTimerEvent &event) {
+    if (!doing_mission || proximity_hold) { return; }
+    if (ros::WallTime::now().toSec() - last_sector_time > proximity_timeout) {
+        ROS_ERROR("No fresh sector distances for %.1f s, holding", proximity_timeout);
+        hold_position();
+    }
+}
+
+void LocalController::hold_position() {
+    //! Nothing to hold while idle, a latched hold would stall the next mission
+    if (!doing_mission) { return; }
+    proximity_hold = true;
+    leg_interrupted = true;
+    dji_osdk_ros::EmergencyBrake brake;
+    if (!emergency_brake_client.call(brake) || !brake.response.result) { ROS_ERROR("Emergency brake failed"); }
+}
+
+void LocalController::attitude_callback(const geometry_msgs::QuaternionStamped::ConstPtr &msg) {
+    //! Body-frame angles after the axis swap are [roll=pitch, pitch=roll, yaw = -heading]
+    telemetry.setAttitude(msg->header.stamp.toSec(), msg->quaternion.w, msg->quaternion.x, msg->quaternion.y,
+                          msg->quaternion.z);
 }
 
 void LocalController::local_position_callback(const geometry_msgs::PointStamped::ConstPtr &msg) {
-    current_local_pos = *msg;
+    telemetry.setLocalPosition(msg->header.stamp.toSec(), msg->point.x, msg->point.y, msg->point.z);
 }
 
 void LocalController::gps_callback(const sensor_msgs::NavSatFix::ConstPtr &msg) {
-    current_gps = *msg;
-    if (doing_mission) {
-        if (wp_n < (int) waypoint_list.size()) {
-            if (local_position_ctrl_mission()) {
-                if (use_gimbal) {
+    telemetry.setGPS(msg->header.stamp.toSec(), msg->latitude, msg->longitude, msg->altitude);
+}
+
+void LocalController::set_mission_state(MissionState state) {
+    {
+        std::lock_guard<std::mutex> lock(mission_mutex);
+        mission_state = state;
+    }
+    mission_cv.notify_all();
+}
+
+MissionState LocalController::get_mission_state() {
+    std::lock_guard<std::mutex> lock(mission_mutex);
+    return mission_state;
+}
+
+/// User plus system CPU time of the whole controller process, in seconds
+double LocalController::process_cpu_time() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           (double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/** Mission state machine. Runs on its own thread so the blocking DJI service calls
+ *  never hold the spinner and the telemetry callbacks keep updating during a leg. */
+void LocalController::mission_executor() {
+    ros::Duration retry_delay(0.2);
+    while (executor_running) {
+        {
+            std::unique_lock<std::mutex> lock(mission_mutex);
+            mission_cv.wait(lock, [this] { return !executor_running || mission_state != MissionState::IDLE; });
+        }
+        if (!executor_running || !ros::ok()) { break; }
+
+        switch (get_mission_state()) {
+            case MissionState::MOVE_TO_WP:
+                //! Next chunk of an axis path while half of the current one is still ahead
+                if (axis_path && !axisPath.done() && wp_n + axis_chunk / 2 >= (int) waypoint_list.size()) {
+                    axisPath.nextRelative((size_t) axis_chunk, waypoint_list);
+                }
+                if (wp_n >= (int) waypoint_list.size()) {
+                    set_mission_state(MissionState::RETURN_HOME);
+                    break;
+                }
+                //! Cleared before the hold is checked, an interrupt raised after the check is seen after the leg
+                leg_interrupted.exchange(false);
+                if (proximity_hold) {
+                    retry_delay.sleep();
+                    break;
+                }
+                apply_standoff_correction();
+                {
+                    TelemetrySnapshot leg_start = telemetry.snapshot();
+                    if (local_position_ctrl_mission() && !leg_interrupted.exchange(false)) {
+                        set_mission_state(MissionState::CAPTURE);
+                    } else {
+                        //! Legs are relative, the retry only flies what is left of this one
+                        TelemetrySnapshot pose = telemetry.snapshot();
+                        waypoint_list[wp_n][1] -= (float) (pose.y - leg_start.y);
+                        waypoint_list[wp_n][2] -= (float) (pose.x - leg_start.x);
+                        waypoint_list[wp_n][3] -= (float) (pose.z - leg_start.z);
+                        ROS_WARN("WP %i not reached, retrying", wp_n + 1);
+                        retry_delay.sleep();
+                    }
+                }
+                break;
+
+            case MissionState::CAPTURE:
+                if (use_gimbal && video_gimbal) {
                     LocalController::set_gimbal_angles(0, 0, 0);
-                    if (camera_gimbal) { LocalController::gimbal_camera(false); }
-                    if( video_gimbal && wp_n == 0){ LocalController::gimbal_camera(true); }
+                    if (wp_n == 0) { LocalController::gimbal_camera(true); }
+                }
+                //! Axis poses look up or down at the riser, the gimbal moves by increments from the last pose
+                if (use_gimbal && waypoint_list[wp_n].size() > 5 && fabs(waypoint_list[wp_n][5] - gimbal_pitch) > 0.1) {
+                    LocalController::set_gimbal_angles(0, waypoint_list[wp_n][5] - gimbal_pitch, 0);
+                    gimbal_pitch = waypoint_list[wp_n][5];
                 }
-                if (use_stereo) {
-                    ROS_INFO("SV3D IMG");
-                    LocalController::stereo_photo();
+                //! Gimbal camera and SV3D fire together, the next leg starts once both shutters have answered
+                if (((use_gimbal && camera_gimbal) || use_stereo) && !capture_scheduler.capture(wp_n)) {
+                    ROS_WARN("WP %i not fully captured, moving on", wp_n + 1);
                 }
                 wp_n++;
+                set_mission_state(MissionState::MOVE_TO_WP);
+                break;
+
+            case MissionState::TRACK_TRAJECTORY:
+                if (use_gimbal && video_gimbal) { LocalController::gimbal_camera(true); }
+                if (!track_trajectory()) { ROS_ERROR("Continuous pass aborted"); }
+                set_mission_state(MissionState::RETURN_HOME);
+                break;
+
+            case MissionState::ONBOARD_MISSION:
+                if (video_gimbal) { LocalController::gimbal_camera(true); }
+                if (!fly_waypoint_mission()) {
+                    ROS_ERROR("Onboard waypoint mission aborted");
+                }
+                set_mission_state(MissionState::RETURN_HOME);
+                break;
+
+            case MissionState::RETURN_HOME: {
+                ROS_WARN("BACK TO INITIAL POSITION");
+                if (video_gimbal) { LocalController::gimbal_camera(false); }
+                capture_scheduler.flush();
+                if (gimbal_pitch != 0) {
+                    LocalController::set_gimbal_angles(0, -gimbal_pitch, 0);
+                    gimbal_pitch = 0;
+                }
+                ROS_INFO("Capture overlap saved %.1f s", capture_scheduler.get_total_saved());
+                TelemetrySnapshot pose = telemetry.snapshot();
+                if (local_position_ctrl((float) -pose.y, (float) -pose.x, (float) -pose.z,
+                                        (float) init_heading, (float) pos_error, (float) yaw_error)) {
+                    double duration = (ros::WallTime::now() - mission_start).toSec();
+                    double cpu = process_cpu_time() - mission_cpu_start;
+                    ROS_INFO("MISSION FINISHED in %.1f s, controller CPU %.2f s (%.1f %%)", duration, cpu,
+                             100 * cpu / std::max(duration, 1e-3));
+                    doing_mission = false;
+                    set_mission_state(MissionState::IDLE);
+                } else {
+                    ROS_ERROR("UNKOWN ERROR");
+                    retry_delay.sleep();
+                }
+                break;
             }
-        } else {
-            ROS_WARN("BACK TO INITIAL POSITION");
-            if( video_gimbal){ LocalController::gimbal_camera(false); }
-            if (local_position_ctrl((float) -current_local_pos.point.y, (float) -current_local_pos.point.x,
-                                    (float) -current_local_pos.point.z,
-                                    (float) init_heading, (float) pos_error, (float) yaw_error)) {
-                ROS_INFO("MISSION FINISHED");
-                doing_mission = false;
-            } else { ROS_ERROR("UNKOWN ERROR"); }
+
+            case MissionState::IDLE:
+                break;
         }
     }
 }
@@ -203,12 +441,10 @@ bool LocalController::local_position_ctrl(float xCmd, float yCmd, float zCmd, fl
     task_control_client.call(control_task_point);
 
     if (control_task_point.response.result) {
-        ROS_INFO("(%f, %f, %f) m @ %f deg target complete",
-                 current_local_pos.point.x, current_local_pos.point.y, rpa_height,
-                 -RAD2DEG(current_atti_euler.Yaw()));
+        TelemetrySnapshot pose = telemetry.snapshot();
+        ROS_INFO("(%f, %f, %f) m @ %f deg target complete", pose.x, pose.y, pose.height, pose.heading);
         ROS_INFO("Lat: %f, Lon: %f, Height: %f m @ %f deg target complete",
-                 current_gps.latitude, current_gps.longitude, rpa_height,
-                 -RAD2DEG(current_atti_euler.Yaw()));
+                 pose.latitude, pose.longitude, pose.height, pose.heading);
         LocalController::obtain_control(false);
         return control_task_point.response.result;
     } else { return control_task_point.response.result; }
@@ -228,29 +464,314 @@ LocalController::local_position_ctrl_mission() {
     task_control_client.call(control_task_mission);
 
     if (control_task_mission.response.result) {
-        ROS_INFO("WP %i @ %f deg target complete", wp_n + 1, rpa_height,
-                 -RAD2DEG(current_atti_euler.Yaw()));
+        TelemetrySnapshot pose = telemetry.snapshot();
+        ROS_INFO("WP %i @ %f m %f deg target complete", wp_n + 1, pose.height, pose.heading);
         ROS_INFO("Lat: %f, Lon: %f, Height: %f m @ %f deg target complete",
-                 current_gps.latitude, current_gps.longitude, rpa_height,
-                 -RAD2DEG(current_atti_euler.Yaw()));
+                 pose.latitude, pose.longitude, pose.height, pose.heading);
     }
     return control_task_mission.response.result;
 }
 
-bool LocalController::gimbal_camera(bool record_video) {
+/** Shift the remaining waypoints along the line of sight so the filtered stereo range
+ *  matches the commanded standoff. The waypoints are relative moves, so offsetting the
+ *  next one translates the rest of the arc with it. */
+void LocalController::apply_standoff_correction() {
+    if (!standoff_correction || wp_n >= (int) waypoint_list.size() ||
+        !standoff.valid(ros::Time::now().toSec())) { return; }
+
+    double range = standoff.getEstimate();
+    double error = range - standoff_target;
+    if (fabs(error) < standoff_deadband) { return; }
+    error = std::max(-standoff_max_step, std::min(standoff_max_step, error));
+    if (fabs(standoff_offset + error) > standoff_max_total) {
+        ROS_WARN("Standoff correction limited to %.1f m, riser measured at %.2f m", standoff_max_total, range);
+        return;
+    }
+    double heading = DEG2RAD(telemetry.snapshot().heading);
+    waypoint_list[wp_n][1] += (float) (error * cos(heading));
+    waypoint_list[wp_n][2] += (float) (error * sin(heading));
+    standoff_offset += error;
+    //! Samples taken before the shift would apply the same error again
+    standoff.reset();
+    ROS_INFO("Riser at %.2f m, standoff corrected %+.2f m (total %+.2f m)", range, error, standoff_offset);
+}
+
+/** Continuous pass: stream velocity setpoints along a smooth trajectory through the
+ *  waypoints and fire the captures by distance along the path: the measured position is
+ *  projected on the trajectory and a shot fires once it is within the trigger latency of a waypoint. */
+bool LocalController::track_trajectory() {
+    double max_speed, max_accel, lateral_accel, setpoint_rate, trigger_latency, pos_gain, yaw_gain, settle_time;
+    nh_.param("/riser_inspection/continuous_speed", max_speed, 1.0);
+    nh_.param("/riser_inspection/continuous_accel", max_accel, 0.5);
+    nh_.param("/riser_inspection/continuous_lateral_accel", lateral_accel, 0.5);
+    nh_.param("/riser_inspection/setpoint_rate", setpoint_rate, 50.0);
+    nh_.param("/riser_inspection/trigger_latency", trigger_latency, 0.2);
+    nh_.param("/riser_inspection/position_gain", pos_gain, 0.8);
+    nh_.param("/riser_inspection/yaw_gain", yaw_gain, 1.0);
+    nh_.param("/riser_inspection/continuous_settle_time", settle_time, 5.0);
+
+    //! Trajectory frame is (north, east, up) from the position where the mission started
+    std::vector<std::vector<float>> waypoints = TrajectoryGenerator::toAbsolute(waypoint_list);
+    waypoints.insert(waypoints.begin(), {0, 0, 0, (float) init_heading});
+    trajectory.setLimits(max_speed, max_accel, lateral_accel);
+    if (!trajectory.generate(waypoints)) { return false; }
+    const std::vector<double> &triggers = trajectory.getWaypointArcs();
+    ROS_INFO("Continuous pass: %.1f m in %.1f s", trajectory.getLength(), trajectory.getDuration());
+
+    TelemetrySnapshot start_pos = telemetry.snapshot();
+
+    sensor_msgs::Joy setpoint;
+    setpoint.axes.resize(4, 0);
+    ros::Rate rate(setpoint_rate);
+    ros::WallTime last = ros::WallTime::now();
+    double t = 0, s_actual = 0;
+    size_t next_trigger = 1; // first point is the start position
+    while (executor_running && ros::ok()) {
+        ros::WallTime now = ros::WallTime::now();
+        //! The trajectory clock stops while the proximity guard holds the aircraft
+        if (proximity_hold) {
+            setpoint.header.stamp = ros::Time::now();
+            setpoint.axes.assign(4, 0);
+            setpoint_pub.publish(setpoint);
+            last = now;
+            rate.sleep();
+            continue;
+        }
+        t += (now - last).toSec();
+        last = now;
+        TrajectoryPoint ref = trajectory.sample(t);
+        TelemetrySnapshot pose = telemetry.snapshot();
+        double north = pose.y - start_pos.y, east = pose.x - start_pos.x, up = pose.z - start_pos.z;
+        double heading_error = ref.yaw - pose.heading;
+        while (heading_error > 180) { heading_error -= 360; }
+        while (heading_error < -180) { heading_error += 360; }
+
+        //! Feed-forward velocity plus position correction, ENU velocity and CCW yaw rate
+        setpoint.header.stamp = ros::Time::now();
+        setpoint.axes[0] = (float) (ref.vy + pos_gain * (ref.y - east));
+        setpoint.axes[1] = (float) (ref.vx + pos_gain * (ref.x - north));
+        setpoint.axes[2] = (float) (ref.vz + pos_gain * (ref.z - up));
+        setpoint.axes[3] = (float) -DEG2RAD(yaw_gain * heading_error);
+        setpoint_pub.publish(setpoint);
+
+        //! Where the aircraft is, not where the reference is: any tracking lag delays the shot with it
+        TrajectoryPoint actual = trajectory.project(north, east, up, s_actual, 0.5);
+        s_actual = std::max(s_actual, actual.s);
+        double speed = sqrt(actual.vx * actual.vx + actual.vy * actual.vy + actual.vz * actual.vz);
+        //! At rest the position threshold still counts as reached, the aircraft may settle a few cm short
+        double lead = std::max(speed * trigger_latency, pos_error);
+        while (next_trigger < triggers.size() && s_actual + lead >= triggers[next_trigger]) {
+            wp_n = (int) next_trigger - 1;
+            if ((use_gimbal && camera_gimbal) || use_stereo) { capture_scheduler.capture(wp_n, false); }
+            next_trigger++;
+        }
+        if (t >= trajectory.getDuration() && next_trigger >= triggers.size()) { break; }
+        if (t >= trajectory.getDuration() + settle_time) {
+            ROS_WARN("Continuous pass ended %.2f m short, %i captures not fired", trajectory.getLength() - s_actual,
+                     (int) (triggers.size() - next_trigger));
+            break;
+        }
+        rate.sleep();
+    }
+
+    setpoint.axes.assign(4, 0);
+    setpoint_pub.publish(setpoint);
+    wp_n = (int) waypoint_list.size();
+    return next_trigger >= triggers.size();
+}
+
+/** Place the waypoints in GNSS from the start pose and check every leg against the 0.5 m
+ *  the flight controller accepts, naming the parameter that sets the short leg. */
+bool LocalController::plan_waypoint_mission() {
+    const double R = 6371000; // Earth radius
+    int ring_points;
+    nh_.param("/riser_inspection/horizontal_points", ring_points, 5);
+
+    TelemetrySnapshot start = telemetry.snapshot();
+    std::vector<std::vector<float>> waypoints = TrajectoryGenerator::toAbsolute(waypoint_list);
+    mission_gnss.clear();
+    if (waypoints.size() < 2) {
+        ROS_ERROR("Onboard mission needs at least 2 waypoints");
+        return false;
+    }
+    for (int k = 0; k < (int) waypoints.size(); k++) {
+        if (k > 0) {
+            double horizontal = std::hypot(waypoints[k][0] - waypoints[k - 1][0],
+                                           waypoints[k][1] - waypoints[k - 1][1]);
+            double vertical = fabs(waypoints[k][2] - waypoints[k - 1][2]);
+            double leg = std::hypot(horizontal, vertical);
+            if (leg < 0.5) {
+                //! Along an axis a new ring starts every horizontal_points poses, on the grid a row climbs vertically
+                bool between_rows = axis_path ? k % std::max(ring_points, 1) == 0 : vertical >= horizontal;
+                ROS_ERROR("Leg to WP %i is %.2f m, the flight controller rejects legs under 0.5 m. Increase %s "
+                          "for an onboard mission", k + 1, leg, between_rows ? "|delta_V|" : "delta_H");
+                mission_gnss.clear();
+                return false;
+            }
+        }
+        //! Local (north, east, up) offsets from the start pose, kept in double precision
+        mission_gnss.push_back({start.latitude + RAD2DEG(waypoints[k][0] / R),
+                                start.longitude + RAD2DEG(waypoints[k][1] / (R * cos(DEG2RAD(start.latitude)))),
+                                start.height + waypoints[k][2], waypoints[k][3]});
+    }
+    return true;
+}
+
+/** Fly the planned waypoints as consecutive onboard missions of at most mission_max_waypoints,
+ *  the flight controller indexes the waypoints of a task in a byte and caps their number.
+ *  The parts are balanced, so none is left with a single waypoint. */
+bool LocalController::fly_waypoint_mission() {
+    int max_waypoints;
+    nh_.param("/riser_inspection/mission_max_waypoints", max_waypoints, 99);
+    max_waypoints = std::min(std::max(max_waypoints, 4), 255);
+    const int total = (int) mission_gnss.size();
+    if (total < 2) {
+        ROS_ERROR("Onboard mission was not planned");
+        return false;
+    }
+    int parts = (total + max_waypoints - 1) / max_waypoints;
+    if (parts > 1) { ROS_WARN("%i waypoints flown as %i onboard missions", total, parts); }
+    for (int first = 0; parts > 0; parts--) {
+        int end = first + (total - first + parts - 1) / parts;
+        if (!upload_waypoint_mission(first, end) || !monitor_waypoint_mission(first, end)) { return false; }
+        first = end;
+    }
+    return true;
+}
 
+/** Convert the planned waypoints [first, end) to one onboard waypoint mission (GNSS, heading, stay and shot
+ *  actions) and upload it in a single request, the flight controller then flies it natively. */
+bool LocalController::upload_waypoint_mission(int first, int end) {
+    double speed;
+    int stay_ms;
+    nh_.param("/riser_inspection/mission_speed", speed, 1.0);
+    nh_.param("/riser_inspection/mission_stay_ms", stay_ms, 500);
+
+    dji_osdk_ros::MissionWpUpload upload;
+    dji_osdk_ros::MissionWaypointTask &task = upload.request.waypoint_task;
+    task.velocity_range = 10;
+    task.idle_velocity = speed;
+    task.action_on_finish = dji_osdk_ros::MissionWaypointTask::FINISH_NO_ACTION;
+    task.mission_exec_times = 1;
+    task.yaw_mode = dji_osdk_ros::MissionWaypointTask::YAW_MODE_WAYPOINT;
+    task.trace_mode = dji_osdk_ros::MissionWaypointTask::TRACE_POINT;
+    task.action_on_rc_lost = dji_osdk_ros::MissionWaypointTask::ACTION_AUTO;
+    //! Axis legs carry the camera pitch of each pose, the flight controller then sets it on the way
+    const bool pose_pitch = use_gimbal && waypoint_list.front().size() > 5;
+    task.gimbal_pitch_mode = pose_pitch ? dji_osdk_ros::MissionWaypointTask::GIMBAL_PITCH_AUTO
+                                        : dji_osdk_ros::MissionWaypointTask::GIMBAL_PITCH_FREE;
+
+    for (int k = first; k < end; k++) {
+        dji_osdk_ros::MissionWaypoint wp;
+        wp.latitude = mission_gnss[k][0];
+        wp.longitude = mission_gnss[k][1];
+        wp.altitude = (float) mission_gnss[k][2];
+        wp.damping_distance = 0;
+        wp.target_yaw = (int16_t) round(mission_gnss[k][3]);
+        wp.target_gimbal_pitch = pose_pitch ? (int16_t) round(waypoint_list[k][5]) : (int16_t) 0;
+        wp.turn_mode = 0;
+        wp.has_action = 1;
+        wp.action_time_limit = 10000;
+        int n_actions = 0;
+        wp.waypoint_action.command_list[n_actions] = DJI::OSDK::WP_ACTION_STAY;
+        wp.waypoint_action.command_parameter[n_actions++] = (int16_t) stay_ms;
+        if (use_gimbal && camera_gimbal) {
+            wp.waypoint_action.command_list[n_actions] = DJI::OSDK::WP_ACTION_SIMPLE_SHOT;
+            wp.waypoint_action.command_parameter[n_actions++] = 1;
+        }
+        //! upper nibble repeat times, lower nibble number of actions
+        wp.waypoint_action.action_repeat = (uint8_t) ((1 << 4) | n_actions);
+        task.mission_waypoint.push_back(wp);
+    }
 
-    if (camera_gimbal) {
-        dji_osdk_ros::CameraStartShootSinglePhoto cameraAction;
-        cameraAction.request.payload_index = 0;
-        camera_photo_client.call(cameraAction);
-        if (cameraAction.response.result) {
-            ROS_INFO("Picture %i", camera_count);
-            camera_count++;
-            return cameraAction.response.result;
-        } else { return cameraAction.response.result; }
+    waypoint_upload_client.call(upload);
+    if (!upload.response.result) {
+        ROS_ERROR("Waypoint mission upload failed");
+        return false;
     }
+    ROS_INFO("Uploaded WP %i to %i in one mission", first + 1, end);
 
+    dji_osdk_ros::MissionWpAction action;
+    action.request.action = DJI::OSDK::MISSION_ACTION::START;
+    waypoint_action_client.call(action);
+    if (!action.response.result) { ROS_ERROR("Waypoint mission did not start"); }
+    return action.response.result;
+}
+
+/** Follow the onboard mission of waypoints [first, end) from telemetry only, fire the stereo trigger
+ *  at each waypoint and stop the mission if it makes no progress. The aircraft is matched to the
+ *  nearest of the next few waypoints, so a waypoint passed outside the radius is skipped
+ *  instead of stalling the count while the flight controller flies on. */
+bool LocalController::monitor_waypoint_mission(int first, int end) {
+    double reached_radius, leg_timeout;
+    int lookahead;
+    nh_.param("/riser_inspection/mission_reached_radius", reached_radius, 0.5);
+    nh_.param("/riser_inspection/mission_leg_timeout", leg_timeout, 120.0);
+    nh_.param("/riser_inspection/mission_lookahead", lookahead, 3);
+    const double R = 6371000;
+    auto distance = [R](const std::vector<double> &a, const std::vector<double> &b) {
+        double north = DEG2RAD(a[0] - b[0]) * R;
+        double east = DEG2RAD(a[1] - b[1]) * R * cos(DEG2RAD(b[0]));
+        return sqrt(north * north + east * east + (a[2] - b[2]) * (a[2] - b[2]));
+    };
+
+    //! Below half the shortest leg only one waypoint can ever be inside the radius
+    double min_leg = 1e9;
+    for (size_t k = 1; k < mission_gnss.size(); k++) {
+        min_leg = std::min(min_leg, distance(mission_gnss[k], mission_gnss[k - 1]));
+    }
+    reached_radius = std::min(reached_radius, 0.45 * min_leg);
+
+    ros::Rate rate(10);
+    ros::WallTime leg_start = ros::WallTime::now();
+    bool paused = false;
+    wp_n = first;
+    while (executor_running && ros::ok() && wp_n < end) {
+        if (proximity_hold != paused) {
+            dji_osdk_ros::MissionWpAction action;
+            action.request.action = paused ? DJI::OSDK::MISSION_ACTION::RESUME : DJI::OSDK::MISSION_ACTION::PAUSE;
+            waypoint_action_client.call(action);
+            paused = !paused;
+            ROS_WARN("Waypoint mission %s", paused ? "paused by proximity guard" : "resumed");
+        }
+        if (paused) {
+            leg_start = ros::WallTime::now();
+            rate.sleep();
+            continue;
+        }
+        TelemetrySnapshot pose = telemetry.snapshot();
+        const std::vector<double> aircraft = {pose.latitude, pose.longitude, pose.height};
+        int reached = -1;
+        double nearest = reached_radius;
+        for (int k = wp_n; k < std::min(wp_n + std::max(lookahead, 1), end); k++) {
+            double d = distance(aircraft, mission_gnss[k]);
+            if (d < nearest) {
+                nearest = d;
+                reached = k;
+            }
+        }
+        if (reached >= 0) {
+            if (reached > wp_n) {
+                ROS_WARN("WP %i to %i passed outside %.2f m, skipped", wp_n + 1, reached, reached_radius);
+            }
+            wp_n = reached;
+            ROS_INFO("WP %i reached", wp_n + 1);
+            if (use_stereo) { capture_scheduler.capture(wp_n, false); }
+            wp_n++;
+            leg_start = ros::WallTime::now();
+        } else if ((ros::WallTime::now() - leg_start).toSec() > leg_timeout) {
+            ROS_ERROR("No progress to WP %i, stopping mission", wp_n + 1);
+            dji_osdk_ros::MissionWpAction action;
+            action.request.action = DJI::OSDK::MISSION_ACTION::STOP;
+            waypoint_action_client.call(action);
+            return false;
+        }
+        rate.sleep();
+    }
+    return wp_n >= end;
+}
+
+bool LocalController::gimbal_camera(bool record_video) {
     if (video_gimbal) {
         dji_osdk_ros::CameraRecordVideoAction cameraRecordVideoAction;
         cameraRecordVideoAction.request.start_stop = record_video;
@@ -265,24 +786,6 @@ bool LocalController::gimbal_camera(bool record_video) {
     return false;
 }
 
-bool LocalController::stereo_photo() {
-    stereo_vant::PointGray stereoAction;
-    ROS_INFO("Got on function");
-
-    if (use_stereo) {
-        stereoAction.request.reset_counter = false;
-        stereoAction.request.file_path = pathGenerator.getFileName() + "/stereo_voo" + std::to_string(stereo_count);
-        stereoAction.request.file_name = "stereo_vant";
-        sv3d_client.call(stereoAction);
-        if (stereoAction.response.result) {
-            ROS_INFO("Stereo image %i", camera_count);
-            camera_count++;
-            return stereoAction.response.result;
-        } else { return stereoAction.response.result; }
-    } else { return false; }
-
-}
-
 bool LocalController::generate_WP(int csv_type) {
     /** Initial setting and parameters to generate trajectory*/
     pathGenerator.reset(); // clear pathGen
@@ -300,26 +803,58 @@ bool LocalController::generate_WP(int csv_type) {
     nh_.param("/riser_inspection/pos_thresh", pos_error, 0.1);
     nh_.param("/riser_inspection/angle_thresh", yaw_error, 1.0);
     nh_.param("/riser_inspection/root_directory", root_directory, std::string("/home/vant3d/Documents"));
+    std::string axis_shape;
+    nh_.param("/riser_inspection/axis_shape", axis_shape, std::string(""));
+    axis_path = !axis_shape.empty();
+
+    double distance = riser_distance, diameter = riser_diameter;
+    if (riser_from_stereo) {
+        std::lock_guard<std::mutex> lock(cylinder_mutex);
+        if (!riser_cylinder.header.stamp.isZero() && (ros::Time::now() - riser_cylinder.header.stamp).toSec() < 2.0) {
+            distance = riser_cylinder.distance;
+            diameter = 2000 * riser_cylinder.radius;
+            ROS_INFO("Riser from stereo: %.2f m away, %.0f mm diameter", distance, diameter);
+        } else {
+            ROS_WARN("No recent riser cylinder fit, using riser_distance and riser_diameter");
+        }
+    }
 
     /** Setting intial parameters to create waypoints */
     pathGenerator.setFolderName(root_directory);
-    pathGenerator.setInspectionParam(riser_distance, (float) riser_diameter, h_points, v_points, delta_h,
-                                     (float) delta_v);
+    pathGenerator.setInspectionParam(distance, (float) diameter, h_points, v_points, delta_h, (float) delta_v);
+    standoff_target = distance;
+    standoff_offset = 0;
+    standoff.reset();
     /** Define start positions to create waypoints */
-    pathGenerator.setInitCoord(current_gps.latitude, current_gps.longitude, rpa_height, (int) init_heading);
-    pathGenerator.setInitCoord_XY(current_local_pos.point.x, current_local_pos.point.y, rpa_height,
-                                  (int) init_heading);
+    TelemetrySnapshot pose = telemetry.snapshot();
+    pathGenerator.setInitCoord(pose.latitude, pose.longitude, pose.height, (int) init_heading);
+    pathGenerator.setInitCoord_XY(pose.x, pose.y, pose.height, (int) init_heading);
+    if (axis_path) { return generate_axis_WP(distance, diameter / 1000, h_points, delta_h, delta_v / 1000.0); }
     try {
         pathGenerator.createInspectionPoints(csv_type); // type 4 refers to XYZ YAW waypoints
         ROS_WARN("Waypoints created at %s/%s", pathGenerator.getFolderName().c_str(),
                  pathGenerator.getFileName().c_str());
-        std::vector<std::vector<std::string>> csv_file = PathGenerate::read_csv(
-                pathGenerator.getFolderName() + "/" + pathGenerator.getFileName(), ",");
-
-        for (int k = 1; k < (int) csv_file.size(); k++) {
-            waypoint_list.push_back(
-                    {(float) std::stoi(csv_file[k][0]), std::stof(csv_file[k][1]), std::stof(csv_file[k][2]),
-                     std::stof(csv_file[k][3]), std::stof(csv_file[k][4])});
+        DelimitedReader csv_file;
+        if (!csv_file.open(pathGenerator.getFolderName() + "/" + pathGenerator.getFileName(), ",")) {
+            ROS_ERROR("Cannot read the waypoint file");
+            return false;
+        }
+        //! Columns by header name, WP,X,Y,Z,Yaw
+        const int wp = csv_file.column("WP"), x = csv_file.column("X"), y = csv_file.column("Y"),
+                z = csv_file.column("Z"), yaw = csv_file.column("Yaw");
+        if (wp < 0 || x < 0 || y < 0 || z < 0 || yaw < 0) {
+            ROS_ERROR("Waypoint file without WP,X,Y,Z,Yaw columns");
+            return false;
+        }
+        while (csv_file.next()) {
+            std::vector<float> waypoint(5);
+            if (!csv_file.getFloat(wp, waypoint[0]) || !csv_file.getFloat(x, waypoint[1]) ||
+                !csv_file.getFloat(y, waypoint[2]) || !csv_file.getFloat(z, waypoint[3]) ||
+                !csv_file.getFloat(yaw, waypoint[4])) {
+                ROS_ERROR("Malformed waypoint at line %zu", csv_file.getLine());
+                return false;
+            }
+            waypoint_list.push_back(waypoint);
         }
         return true;
     } catch (ros::Exception &e) {
@@ -328,4 +863,41 @@ bool LocalController::generate_WP(int csv_type) {
     }
 }
 
-
+/** Waypoints along the riser axis instead of the semicircle grid. Rings of horizontal_points
+ *  poses every |delta_V| of axis, delta_V < 0 goes down the riser. Only the first chunk is
+ *  generated here, the executor asks for the next one as it flies. */
+bool LocalController::generate_axis_WP(double distance, double diameter, int ring_points, int ring_step,
+                                       double spacing) {
+    std::string axis_shape;
+    double length, inclination, rise, azimuth;
+    nh_.param("/riser_inspection/axis_shape", axis_shape, std::string("line"));
+    nh_.param("/riser_inspection/axis_length", length, 30.0);
+    nh_.param("/riser_inspection/axis_inclination", inclination, 0.0);
+    nh_.param("/riser_inspection/axis_rise", rise, 20.0);
+    nh_.param("/riser_inspection/axis_azimuth", azimuth, 90.0);
+    nh_.param("/riser_inspection/axis_chunk", axis_chunk, 200);
+    axis_chunk = std::max(axis_chunk, 2);
+
+    bool valid;
+    AxisShape shape = AxisPathGenerator::parseShape(axis_shape, valid);
+    if (!valid) {
+        ROS_ERROR("Unknown axis_shape %s, use line or catenary", axis_shape.c_str());
+        return false;
+    }
+    const double climb = spacing < 0 ? -1 : 1;
+    if (shape == AxisShape::LINE) { axisPath.setLine(climb * length, inclination, azimuth); }
+    else { axisPath.setCatenary(length, climb * rise, azimuth); }
+    axisPath.setInspectionParam(distance, diameter, ring_points, ring_step, fabs(spacing));
+    if (!axisPath.start(init_heading)) {
+        ROS_ERROR("No %s axis path for these parameters", axis_shape.c_str());
+        return false;
+    }
+    //! Continuous and onboard modes plan the whole pass at once
+    size_t first = continuous_mode || onboard_mission ? axisPath.size() : (size_t) axis_chunk;
+    ros::WallTime start = ros::WallTime::now();
+    axisPath.nextRelative(first, waypoint_list);
+    ROS_WARN("%s axis of %.1f m, %zu waypoints, first %zu in %.2f ms", axis_shape.c_str(),
+             axisPath.getAxisLength(), axisPath.size(), waypoint_list.size(),
+             (ros::WallTime::now() - start).toSec() * 1e3);
+    return !waypoint_list.empty();
+}
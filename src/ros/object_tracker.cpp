@@ -0,0 +1,222 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <object_tracker.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void AxisFilter::init(double position, double position_var, double velocity_var) {
+    p = position;
+    v = 0;
+    P[0][0] = position_var;
+    P[0][1] = P[1][0] = 0;
+    P[1][1] = velocity_var;
+}
+
+void AxisFilter::predict(double dt, double accel_var) {
+    if (dt <= 0) { return; }
+    p += v * dt;
+    //! P = F P F' + G G' q, F = [1 dt; 0 1], G = [dt^2/2; dt]
+    double p00 = P[0][0] + dt * (P[1][0] + P[0][1]) + dt * dt * P[1][1];
+    double p01 = P[0][1] + dt * P[1][1];
+    double p11 = P[1][1];
+    P[0][0] = p00 + accel_var * dt * dt * dt * dt / 4;
+    P[0][1] = P[1][0] = p01 + accel_var * dt * dt * dt / 2;
+    P[1][1] = p11 + accel_var * dt * dt;
+}
+
+void AxisFilter::update(double measurement, double measurement_var) {
+    double s = P[0][0] + measurement_var;
+    double k0 = P[0][0] / s, k1 = P[1][0] / s;
+    double innovation = measurement - p;
+    p += k0 * innovation;
+    v += k1 * innovation;
+    double p00 = (1 - k0) * P[0][0];
+    double p01 = (1 - k0) * P[0][1];
+    double p11 = P[1][1] - k1 * P[0][1];
+    P[0][0] = p00;
+    P[0][1] = P[1][0] = p01;
+    P[1][1] = p11;
+}
+
+void ObjectTracker::setParameters(double gate_px, double max_coast_s, int confirm_hits) {
+    gate = gate_px;
+    max_coast = max_coast_s;
+    min_hits = std::max(1, confirm_hits);
+}
+
+void ObjectTracker::setNoise(double pixel_acc, double depth_acc, double pixel_meas, double depth_meas) {
+    pixel_accel = pixel_acc;
+    depth_accel = depth_acc;
+    pixel_noise = pixel_meas;
+    depth_noise = depth_meas;
+}
+
+void ObjectTracker::predict(double stamp) {
+    if (stamp <= time) { return; }
+    double dt = time > 0 ? stamp - time : 0;
+    for (TrackedObject &track : tracks) {
+        track.u.predict(dt, pixel_accel * pixel_accel);
+        track.v.predict(dt, pixel_accel * pixel_accel);
+        track.z.predict(dt, depth_accel * depth_accel);
+    }
+    time = stamp;
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this](const TrackedObject &track) {
+        return time - track.last_detection > max_coast;
+    }), tracks.end());
+}
+
+void ObjectTracker::update(double stamp, const std::vector<Detection> &detections) {
+    predict(stamp);
+    //! Detections older than the tracks are compared with the track rolled back to their stamp
+    const double late = std::max(0.0, time - stamp);
+
+    std::vector<std::vector<double>> cost(tracks.size(), std::vector<double>(detections.size(), gate));
+    for (size_t t = 0; t < tracks.size(); t++) {
+        const TrackedObject &track = tracks[t];
+        double u = track.u.p - track.u.v * late, v = track.v.p - track.v.v * late;
+        double z = track.z.p - track.z.v * late;
+        for (size_t d = 0; d < detections.size(); d++) {
+            const Detection &det = detections[d];
+            if (det.label != track.label) { continue; }
+            double du = det.x + det.width / 2 - u, dv = det.y + det.height / 2 - v;
+            double distance = sqrt(du * du + dv * dv);
+            if (det.depth > 0) { distance += depth_weight * fabs(det.depth - z); }
+            if (distance < gate) { cost[t][d] = distance; }
+        }
+    }
+    std::vector<int> assignment = assign(cost, gate);
+
+    std::vector<bool> used(detections.size(), false);
+    for (size_t t = 0; t < tracks.size(); t++) {
+        int d = assignment[t];
+        if (d < 0) { continue; }
+        used[d] = true;
+        TrackedObject &track = tracks[t];
+        const Detection &det = detections[d];
+        //! Advance the late measurement with the track velocity, its uncertainty grows with the delay
+        double late2 = late * late;
+        track.u.update(det.x + det.width / 2 + track.u.v * late, pixel_noise * pixel_noise + track.u.P[1][1] * late2);
+        track.v.update(det.y + det.height / 2 + track.v.v * late, pixel_noise * pixel_noise + track.v.P[1][1] * late2);
+        if (det.depth > 0) {
+            track.z.update(det.depth + track.z.v * late, depth_noise * depth_noise + track.z.P[1][1] * late2);
+        }
+        track.width = 0.7f * track.width + 0.3f * det.width;
+        track.height = 0.7f * track.height + 0.3f * det.height;
+        track.probability = det.probability;
+        track.last_detection = time;
+        track.hits++;
+        track.confirmed = track.confirmed || track.hits >= min_hits;
+    }
+
+    for (size_t d = 0; d < detections.size(); d++) {
+        if (used[d] || detections[d].depth <= 0) { continue; }
+        const Detection &det = detections[d];
+        TrackedObject track;
+        track.id = next_id++;
+        track.label = det.label;
+        track.u.init(det.x + det.width / 2, pixel_noise * pixel_noise, pixel_accel * pixel_accel);
+        track.v.init(det.y + det.height / 2, pixel_noise * pixel_noise, pixel_accel * pixel_accel);
+        track.z.init(det.depth, depth_noise * depth_noise, depth_accel * depth_accel);
+        track.width = det.width;
+        track.height = det.height;
+        track.probability = det.probability;
+        track.last_detection = time;
+        track.hits = 1;
+        track.confirmed = min_hits <= 1;
+        tracks.push_back(track);
+    }
+}
+
+void ObjectTracker::updateDepth(int id, double depth) {
+    for (TrackedObject &track : tracks) {
+        if (track.id == id && depth > 0) {
+            track.z.update(depth, depth_noise * depth_noise);
+            return;
+        }
+    }
+}
+
+/** The sentinel of a gated-out pair is finite and above any total of real pairs, so the
+ *  solver first maximises the number of real pairs and the potentials stay small enough
+ *  for the real costs to count. An infinite or huge sentinel rounds them away. */
+std::vector<int> ObjectTracker::assign(const std::vector<std::vector<double>> &cost, double gate) {
+    const size_t rows = cost.size();
+    const size_t cols = rows > 0 ? cost[0].size() : 0;
+    const double sentinel = gate * (double) (rows + cols + 1);
+    std::vector<std::vector<double>> bounded(cost);
+    for (std::vector<double> &row : bounded) {
+        for (double &c : row) { c = c < gate ? c : sentinel; }
+    }
+    std::vector<int> result = hungarian(bounded);
+    for (size_t i = 0; i < rows; i++) {
+        if (result[i] >= 0 && !(cost[i][result[i]] < gate)) { result[i] = -1; }
+    }
+    return result;
+}
+
+/** Hungarian method with row and column potentials, O(n^3). The matrix is padded to
+ *  square with a cost above every real entry, padded matches come back as -1. */
+std::vector<int> ObjectTracker::hungarian(const std::vector<std::vector<double>> &cost) {
+    const size_t rows = cost.size();
+    const size_t cols = rows > 0 ? cost[0].size() : 0;
+    std::vector<int> result(rows, -1);
+    if (rows == 0 || cols == 0) { return result; }
+
+    const size_t n = std::max(rows, cols);
+    double pad = 0;
+    for (const std::vector<double> &row : cost) {
+        for (double c : row) { pad = std::max(pad, c); }
+    }
+    pad = pad * 2 + 1;
+    auto a = [&](size_t i, size_t j) { return i < rows && j < cols ? cost[i][j] : pad; };
+
+    const double INF = std::numeric_limits<double>::infinity();
+    //! 1-based arrays, p[j] is the row matched to column j
+    std::vector<double> u(n + 1, 0), v(n + 1, 0), minv(n + 1);
+    std::vector<size_t> p(n + 1, 0), way(n + 1, 0);
+    std::vector<bool> visited(n + 1);
+    for (size_t i = 1; i <= n; i++) {
+        p[0] = i;
+        size_t j0 = 0;
+        std::fill(minv.begin(), minv.end(), INF);
+        std::fill(visited.begin(), visited.end(), false);
+        do {
+            visited[j0] = true;
+            size_t i0 = p[j0], j1 = 0;
+            double delta = INF;
+            for (size_t j = 1; j <= n; j++) {
+                if (visited[j]) { continue; }
+                double cur = a(i0 - 1, j - 1) - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= n; j++) {
+                if (visited[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            size_t j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+    for (size_t j = 1; j <= n; j++) {
+        if (p[j] >= 1 && p[j] <= rows && j <= cols) { result[p[j] - 1] = (int) j - 1; }
+    }
+    return result;
+}
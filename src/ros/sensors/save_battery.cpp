@@ -3,17 +3,14 @@
 //
 
 #include <ros/ros.h>
-#include <dji_osdk_ros/BatteryState.h>
-#include <fstream>
+#include <sensor_msgs/BatteryState.h>
+#include <telemetry_log.h>
 
-std::ofstream battery_data;
+TelemetryLogWriter battery_data;
 
 
-void callback(const dji_osdk_ros::BatteryState::ConstPtr &msg){
-
-    if(battery_data.is_open()){
-        battery_data << msg->
-    }
+void callback(const sensor_msgs::BatteryState::ConstPtr &msg) {
+    battery_data.append(msg->header.stamp.toSec(), {msg->percentage, msg->voltage, msg->current});
 }
 
 int main(int argc, char **argv) {
@@ -22,9 +19,12 @@ int main(int argc, char **argv) {
     ros::init(argc, argv, "battery_state_save");
 
     ros::NodeHandle nh;
-    battery_data.open("sensor_data.txt");
-    ros::Subscriber sub_battery = nh.subscribe("/dji_osdk_ros/battery_state", 1, callback);
+    if (!battery_data.open("battery_data.txt", {"percentage", "voltage", "current"})) {
+        return -1;
+    }
+    ros::Subscriber sub_battery = nh.subscribe("/dji_osdk_ros/battery_state", 10, callback);
 
     ros::spin();
+    battery_data.close();
     return 0;
-}
\ No newline at end of file
+}
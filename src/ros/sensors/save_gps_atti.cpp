@@ -9,9 +9,10 @@
 #include <ignition/math/Pose3.hh>
 #include <message_filters/subscriber.h>
 #include <message_filters/sync_policies/approximate_time.h>
+#include <telemetry_log.h>
 
 #define RAD2DEG(RAD) ((RAD) * 180 / M_PI)
-std::ofstream sensor_data;
+TelemetryLogWriter sensor_data;
 
 void callback(const sensor_msgs::NavSatFix::ConstPtr &gps_msg,
               const geometry_msgs::QuaternionStamped::ConstPtr &atti_msg) {
@@ -19,11 +20,9 @@ void callback(const sensor_msgs::NavSatFix::ConstPtr &gps_msg,
     ignition::math::Quaterniond rpy;
     rpy.Set(atti_msg->quaternion.w, atti_msg->quaternion.x, atti_msg->quaternion.y, atti_msg->quaternion.z);
 
-    if (sensor_data.is_open()) {
-        sensor_data << RAD2DEG(rpy.Roll()) << "," << RAD2DEG(rpy.Pitch()) << "," << RAD2DEG(rpy.Yaw())
-                    << "\t " << std::setprecision(10) << gps_msg->latitude << "\t" << std::setprecision(10)
-                    << gps_msg->longitude << "\t " << std::setprecision(10) << gps_msg->altitude << "\n";
-    }
+    sensor_data.append(gps_msg->header.stamp.toSec(),
+                       {RAD2DEG(rpy.Roll()), RAD2DEG(rpy.Pitch()), RAD2DEG(rpy.Yaw()),
+                        gps_msg->latitude, gps_msg->longitude, gps_msg->altitude});
 }
 
 int main(int argc, char **argv) {
@@ -34,14 +33,15 @@ int main(int argc, char **argv) {
     message_filters::Subscriber<sensor_msgs::NavSatFix> gps(nh, "/dji_osdk_ros/gps_position", 1);
     message_filters::Subscriber<geometry_msgs::QuaternionStamped> atti(nh, "/dji_osdk_ros/attitude", 1);
 
-    sensor_data.open("sensor_data.txt");
+    if (!sensor_data.open("sensor_data.txt", {"roll", "pitch", "yaw", "latitude", "longitude", "altitude"})) {
+        return -1;
+    }
     typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::NavSatFix, geometry_msgs::QuaternionStamped> MySyncPolicy;
     // ExactTime takes a queue size as its constructor argument, hence MySyncPolicy(10)
     message_filters::Synchronizer<MySyncPolicy> sync(MySyncPolicy(100), gps, atti);
     sync.registerCallback(boost::bind(&callback, _1, _2));
 
-    while (ros::ok()) {
-        ros::spinOnce();
-    }
+    ros::spin();
+    sensor_data.close();
     return 0;
 }
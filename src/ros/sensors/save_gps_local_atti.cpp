@@ -9,10 +9,10 @@
 #include <ignition/math/Pose3.hh>
 #include <message_filters/subscriber.h>
 #include <message_filters/sync_policies/approximate_time.h>
-#include <fstream>
 #include <sensor_msgs/BatteryState.h>
+#include <telemetry_log.h>
 
-std::ofstream sensor_data;
+TelemetryLogWriter sensor_data;
 
 #define RAD2DEG(RAD) ((RAD) * 180 / M_PI)
 
@@ -24,14 +24,11 @@ void callback(const sensor_msgs::NavSatFix::ConstPtr &gps_msg,
 
     ignition::math::Quaterniond rpy;
     rpy.Set(atti_msg->quaternion.w, atti_msg->quaternion.x, atti_msg->quaternion.y, atti_msg->quaternion.z);
-    if (sensor_data.is_open()) {
-        sensor_data << RAD2DEG(rpy.Roll()) << "\t" << RAD2DEG(rpy.Pitch()) << "\t" << RAD2DEG(rpy.Yaw())
-                    << "\t " << std::setprecision(10) << gps_msg->latitude << "\t" << std::setprecision(10)
-                    << gps_msg->longitude << "\t" << std::setprecision(10) << gps_msg->altitude
-                    << "\t " << std::setprecision(6) << local_msg->point.x << "\t" << std::setprecision(6)
-                    << local_msg->point.y << "\t " << std::setprecision(6) << local_msg->point.z << "\t"
-                    << bat_msg->percentage << "\t" << bat_msg->voltage << "\t" << bat_msg->current << "\n";
-    }
+    sensor_data.append(gps_msg->header.stamp.toSec(),
+                       {RAD2DEG(rpy.Roll()), RAD2DEG(rpy.Pitch()), RAD2DEG(rpy.Yaw()),
+                        gps_msg->latitude, gps_msg->longitude, gps_msg->altitude,
+                        local_msg->point.x, local_msg->point.y, local_msg->point.z,
+                        bat_msg->percentage, bat_msg->voltage, bat_msg->current});
 
 }
 
@@ -45,15 +42,17 @@ int main(int argc, char **argv) {
     message_filters::Subscriber<geometry_msgs::PointStamped> local(nh, "/dji_osdk_ros/local_position", 1);
     message_filters::Subscriber<sensor_msgs::BatteryState> battery(nh, "/dji_osdk_ros/battery_state", 1);
 
-    sensor_data.open("position_data.txt");
+    if (!sensor_data.open("position_data.txt", {"roll", "pitch", "yaw", "latitude", "longitude", "altitude",
+                                                 "x", "y", "z", "battery", "voltage", "current"})) {
+        return -1;
+    }
 
     typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::NavSatFix, geometry_msgs::QuaternionStamped, geometry_msgs::PointStamped, sensor_msgs::BatteryState> MySyncPolicy;
     // ExactTime takes a queue size as its constructor argument, hence MySyncPolicy(10)
     message_filters::Synchronizer<MySyncPolicy> sync(MySyncPolicy(100), gps, atti, local, battery);
     sync.registerCallback(boost::bind(&callback, _1, _2, _3, _4));
 
-    while (ros::ok()) {
-        ros::spinOnce();
-    }
+    ros::spin();
+    sensor_data.close();
     return 0;
 }
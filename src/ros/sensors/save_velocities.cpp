@@ -6,20 +6,17 @@
 #include <ros/ros.h>
 #include <message_filters/subscriber.h>
 #include <message_filters/sync_policies/approximate_time.h>
-#include "fstream"
+#include <telemetry_log.h>
 #define RAD2DEG(RAD) ((RAD) * 180 / M_PI)
-std::ofstream sensor_data;
+TelemetryLogWriter sensor_data;
 
 void callback(const geometry_msgs::Vector3Stamped::ConstPtr &ground_v,
               const geometry_msgs::Vector3Stamped::ConstPtr &fused_w) {
 
 
-    if (sensor_data.is_open()) {
-        sensor_data << std::setprecision(10) << ground_v->vector.x << "\t" << std::setprecision(10)
-                    << ground_v->vector.y << "\t " << std::setprecision(10) << ground_v->vector.z
-                    << std::setprecision(10) << fused_w->vector.x << "\t" << std::setprecision(10)
-                    << fused_w->vector.y << "\t " << std::setprecision(10) << fused_w->vector.z << "\n";
-    }
+    sensor_data.append(ground_v->header.stamp.toSec(),
+                       {ground_v->vector.x, ground_v->vector.y, ground_v->vector.z,
+                        fused_w->vector.x, fused_w->vector.y, fused_w->vector.z});
 }
 
 int main(int argc, char **argv) {
@@ -30,15 +27,15 @@ int main(int argc, char **argv) {
     message_filters::Subscriber<geometry_msgs::Vector3Stamped> ground_vel(nh, "/dji_osdk_ros/acceleration_ground_fused", 1);
     message_filters::Subscriber<geometry_msgs::Vector3Stamped> angular_vel(nh, "/dji_osdk_ros/angular_velocity_fused", 1);
 
-    sensor_data.open("velocity_data.txt");
-    sensor_data << "Ground E" << "\t" << "Ground N" << "\t" << "Up" << "\t" << "p" << "\t" << "q" << "\t" << "r" << std::endl;
+    if (!sensor_data.open("velocity_data.txt", {"ground_e", "ground_n", "up", "p", "q", "r"})) {
+        return -1;
+    }
     typedef message_filters::sync_policies::ApproximateTime<geometry_msgs::Vector3Stamped , geometry_msgs::Vector3Stamped> MySyncPolicy;
     // ExactTime takes a queue size as its constructor argument, hence MySyncPolicy(10)
     message_filters::Synchronizer<MySyncPolicy> sync(MySyncPolicy(100), ground_vel, angular_vel);
     sync.registerCallback(boost::bind(&callback, _1, _2));
 
-    while (ros::ok()) {
-        ros::spinOnce();
-    }
+    ros::spin();
+    sensor_data.close();
     return 0;
 }
@@ -12,35 +12,23 @@
 /// Variavel para leitura GPS RTK
 
 #include "colormap.h"
+#include "stereo_utility/preview_worker.hpp"
 
 
-cv::Mat_<cv::Vec3b> disparity_color;
+M210_STEREO::PreviewWorker::Ptr preview;
 
 
-void callback(const stereo_msgs::DisparityImageConstPtr &msg) {
-
-    cv_bridge::CvImagePtr cv_ptr;
-
-    namespace enc = sensor_msgs::image_encodings;
-    ROS_INFO("MIN: %f, MAX: %f", msg->min_disparity, msg->max_disparity);
-    try {
-        cv_ptr = cv_bridge::toCvCopy(msg->image, sensor_msgs::image_encodings::TYPE_32FC1);
-    }
-    catch (cv_bridge::Exception &e) {
-        ROS_ERROR("cv_bridge exception: %s", e.what());
-        return;
-    }
-    float multiplier = 255.0f / (msg->max_disparity - msg->min_disparity);
-    const cv::Mat_<float> dmat(msg->image.height, msg->image.width,
-                               (float *) &msg->image.data[0], msg->image.step);
-    disparity_color.create(msg->image.height, msg->image.width);
+//! Colormap of the downscaled disparity, runs on the preview thread
+cv::Mat colorize(const cv::Mat &dmat, float min_disparity, float max_disparity) {
+    float multiplier = 255.0f / (max_disparity - min_disparity);
+    cv::Mat_<cv::Vec3b> disparity_color(dmat.rows, dmat.cols);
 
     for (int row = 0; row < disparity_color.rows; ++row) {
-        const float *d = dmat[row];
+        const float *d = dmat.ptr<float>(row);
         cv::Vec3b *disparity_color_v = disparity_color[row],
                 *disparity_color_end = disparity_color_v + disparity_color.cols;
         for (; disparity_color_v < disparity_color_end; ++disparity_color_v, ++d) {
-            int index = (*d - msg->min_disparity) * multiplier + 0.5;
+            int index = (*d - min_disparity) * multiplier + 0.5;
             index = std::min(255, std::max(0, index));
             // Fill as BGR
             (*disparity_color_v)[2] = colormap[3 * index + 0];
@@ -48,11 +36,27 @@ void callback(const stereo_msgs::DisparityImageConstPtr &msg) {
             (*disparity_color_v)[0] = colormap[3 * index + 2];
         }
     }
+    return disparity_color;
+}
 
-    cv::imshow("Disparity", disparity_color);
-    cv::waitKey(10);
 
+void callback(const stereo_msgs::DisparityImageConstPtr &msg) {
 
+    ROS_INFO("MIN: %f, MAX: %f", msg->min_disparity, msg->max_disparity);
+    if (!preview || !preview->wantsFrame("Disparity")) { return; }
+
+    cv_bridge::CvImageConstPtr cv_ptr;
+    try {
+        cv_ptr = cv_bridge::toCvShare(msg->image, msg, sensor_msgs::image_encodings::TYPE_32FC1);
+    }
+    catch (cv_bridge::Exception &e) {
+        ROS_ERROR("cv_bridge exception: %s", e.what());
+        return;
+    }
+    float min_disparity = msg->min_disparity, max_disparity = msg->max_disparity;
+    preview->show("Disparity", cv_ptr->image, [min_disparity, max_disparity](cv::Mat &image, double) {
+        return colorize(image, min_disparity, max_disparity);
+    });
 }
 
 
@@ -61,10 +65,19 @@ int main(int argc, char **argv) {
     ros::init(argc, argv, "disparity_show");
     ros::NodeHandle nh;
 
+    bool headless;
+    double preview_rate, preview_scale;
+    nh.param("/disparity_show/headless", headless, M210_STEREO::PreviewWorker::noDisplay());
+    nh.param("/disparity_show/preview_rate", preview_rate, 10.0);
+    nh.param("/disparity_show/preview_scale", preview_scale, 1.0);
+    if (!headless) {
+        preview = M210_STEREO::PreviewWorker::createPreviewWorker(preview_rate, preview_scale);
+        preview->start();
+    }
+
     ros::Subscriber disp = nh.subscribe("/stereo_depth_perception/disparity_front_left_image", 10, callback);
 
-    while (ros::ok()) {
-        ros::spinOnce();
-    }
+    ros::spin();
+    preview.reset();
     return 0;
 }
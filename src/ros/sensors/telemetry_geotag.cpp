@@ -0,0 +1,72 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Tags inspection photos with the drone state at their capture stamp, interpolated from a
+// log of save_positions or save_gps_atti. The photo list has a name and a stamp per row, or
+// is a captures_<time>.txt written by the capture scheduler (stamp, wp and file columns).
+//
+//   telemetry_geotag <position_data.txt> <captures_<time>.txt | photos.txt> [max gap s] > geotags.txt
+//
+
+#include <telemetry_log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <telemetry log> <photo list: name<TAB>stamp> [max gap s]\n";
+        return -1;
+    }
+    TelemetryLog log;
+    if (!log.open(argv[1])) {
+        std::cerr << "Cannot read " << argv[1] << "\n";
+        return -1;
+    }
+    log.setAngleColumn("roll");
+    log.setAngleColumn("pitch");
+    log.setAngleColumn("yaw");
+    if (argc > 3) { log.setMaxGap(atof(argv[3])); }
+
+    DelimitedReader photos;
+    if (!photos.open(argv[2], "\t,", false)) {
+        std::cerr << "Cannot read " << argv[2] << "\n";
+        return -1;
+    }
+
+    printf("name\tstamp");
+    for (const std::string &name : log.getNames()) { printf("\t%s", name.c_str()); }
+    printf("\n");
+
+    std::vector<double> values;
+    size_t tagged = 0, missed = 0;
+    size_t name_column = 0, stamp_column = 1;
+    while (photos.next()) {
+        //! A capture log names its columns, the file is the photo name
+        if (photos.getLine() == 1 && photos.size() > 0 && photos.field(0).str() == "stamp") {
+            for (size_t i = 1; i < photos.size(); i++) {
+                if (photos.field(i).str() == "file") { name_column = i; }
+            }
+            stamp_column = 0;
+            continue;
+        }
+        double stamp;
+        //! A header row or a line without a stamp is skipped
+        if (photos.size() <= std::max(name_column, stamp_column) || !photos.getDouble(stamp_column, stamp)) {
+            continue;
+        }
+        const std::string name = photos.field(name_column).str();
+        if (!log.at(stamp, values)) {
+            std::cerr << name << ": no telemetry at " << std::fixed << stamp << "\n";
+            missed++;
+            continue;
+        }
+        printf("%s\t%.6f", name.c_str(), stamp);
+        for (double value : values) { printf("\t%.12g", value); }
+        printf("\n");
+        tagged++;
+    }
+    std::cerr << tagged << " photos tagged, " << missed << " outside the log or in a dropout\n";
+    return missed == 0 ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <standoff_filter.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+void StandoffFilter::setParameters(int window, int min_n, double ema_alpha, double gate, double age) {
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    window_size = std::max(window, 1);
+    min_samples = std::max(1, std::min(min_n, window_size));
+    alpha = ema_alpha;
+    outlier_gate = gate;
+    max_age = age;
+}
+
+void StandoffFilter::reset() {
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    window.clear();
+    estimate = 0;
+    last_stamp = 0;
+    accepted = 0;
+    rejected = 0;
+}
+
+double StandoffFilter::median() const {
+    std::vector<double> sorted(window.begin(), window.end());
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    return sorted[sorted.size() / 2];
+}
+
+bool StandoffFilter::update(double stamp, double range) {
+    if (!std::isfinite(range) || range <= 0) { return false; }
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    //! Gate against the median only once the window can tell what an outlier is
+    if ((int) window.size() >= min_samples && fabs(range - median()) > outlier_gate) {
+        rejected++;
+        return false;
+    }
+    window.push_back(range);
+    if ((int) window.size() > window_size) { window.pop_front(); }
+    estimate = accepted == 0 ? range : alpha * range + (1 - alpha) * estimate;
+    accepted++;
+    last_stamp = stamp;
+    return true;
+}
+
+bool StandoffFilter::valid(double now) const {
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    return (int) window.size() >= min_samples && now - last_stamp <= max_age;
+}
+
+double StandoffFilter::getEstimate() const {
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    return estimate;
+}
+
+int StandoffFilter::getRejected() const {
+    std::lock_guard<std::mutex> lock(filter_mutex);
+    return rejected;
+}
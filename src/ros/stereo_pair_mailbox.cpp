@@ -0,0 +1,124 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <stereo_pair_mailbox.h>
+
+StereoPairMailbox::StereoPairMailbox() : running(false) {
+}
+
+StereoPairMailbox::~StereoPairMailbox() {
+    stop();
+}
+
+void StereoPairMailbox::setMatching(double tolerance_s, bool by_sequence) {
+    std::lock_guard<std::mutex> lock(mailbox_mutex);
+    tolerance = std::max(tolerance_s, 0.0);
+    match_sequence = by_sequence;
+}
+
+void StereoPairMailbox::subscribe(ros::NodeHandle &nh, const std::string &left_topic, const std::string &right_topic) {
+    left_sub = nh.subscribe<sensor_msgs::Image>(left_topic, 1, &StereoPairMailbox::pushLeft, this);
+    right_sub = nh.subscribe<sensor_msgs::Image>(right_topic, 1, &StereoPairMailbox::pushRight, this);
+}
+
+void StereoPairMailbox::start(const PairCallback &pair_callback) {
+    if (running) { return; }
+    callback = pair_callback;
+    stats_time = ros::WallTime::now();
+    running = true;
+    worker = std::thread(&StereoPairMailbox::run, this);
+}
+
+void StereoPairMailbox::stop() {
+    if (!running) { return; }
+    running = false;
+    pair_ready.notify_all();
+    if (worker.joinable()) { worker.join(); }
+}
+
+bool StereoPairMailbox::matches(const sensor_msgs::ImageConstPtr &a, const sensor_msgs::ImageConstPtr &b) const {
+    if (match_sequence) { return a->header.seq == b->header.seq; }
+    return fabs((a->header.stamp - b->header.stamp).toSec()) <= tolerance;
+}
+
+void StereoPairMailbox::push(const sensor_msgs::ImageConstPtr &msg, bool is_left) {
+    std::unique_lock<std::mutex> lock(mailbox_mutex);
+    (is_left ? received_left : received_right)++;
+    //! Anything not newer than the last pair can never be used
+    if (!last_pair.isZero() && msg->header.stamp <= last_pair) {
+        late++;
+        return;
+    }
+    sensor_msgs::ImageConstPtr &own = is_left ? left : right;
+    sensor_msgs::ImageConstPtr &other = is_left ? right : left;
+    if (own) { mismatched++; }
+    own = msg;
+    if (!other) { return; }
+
+    if (!matches(own, other)) {
+        //! The other side is older than this frame, its partner is not coming anymore
+        bool stale = match_sequence ? other->header.seq < own->header.seq
+                                    : (own->header.stamp - other->header.stamp).toSec() > tolerance;
+        if (stale) {
+            mismatched++;
+            other.reset();
+        }
+        return;
+    }
+
+    if (ready_left) { dropped++; }
+    ready_left = left;
+    ready_right = right;
+    last_pair = std::max(left->header.stamp, right->header.stamp);
+    left.reset();
+    right.reset();
+    pair_ready.notify_one();
+    if (observer) {
+        sensor_msgs::ImageConstPtr pair_left = ready_left, pair_right = ready_right;
+        lock.unlock();
+        observer(pair_left, pair_right);
+    }
+}
+
+void StereoPairMailbox::run() {
+    while (running) {
+        sensor_msgs::ImageConstPtr pair_left, pair_right;
+        {
+            std::unique_lock<std::mutex> lock(mailbox_mutex);
+            pair_ready.wait(lock, [this]() { return !running || ready_left; });
+            if (!running) { break; }
+            pair_left.swap(ready_left);
+            pair_right.swap(ready_right);
+            delivered++;
+        }
+        double age = (ros::Time::now() - pair_left->header.stamp).toSec();
+        ros::WallTime start = ros::WallTime::now();
+        callback(pair_left, pair_right);
+        double elapsed = (ros::WallTime::now() - start).toSec();
+
+        std::lock_guard<std::mutex> lock(mailbox_mutex);
+        processing_time = processing_time > 0 ? 0.9 * processing_time + 0.1 * elapsed : elapsed;
+        latency = latency > 0 ? 0.9 * latency + 0.1 * age : age;
+    }
+}
+
+riser_inspection::StereoPipelineStats StereoPairMailbox::getStats() {
+    std::lock_guard<std::mutex> lock(mailbox_mutex);
+    riser_inspection::StereoPipelineStats stats;
+    stats.header.stamp = ros::Time::now();
+    stats.received_left = received_left;
+    stats.received_right = received_right;
+    stats.delivered = delivered;
+    stats.dropped = dropped;
+    stats.mismatched = mismatched;
+    stats.late = late;
+    ros::WallTime now = ros::WallTime::now();
+    double dt = (now - stats_time).toSec();
+    stats.rate = dt > 0 ? (float) ((delivered - stats_delivered) / dt) : 0.f;
+    stats_delivered = delivered;
+    stats_time = now;
+    stats.processing_time = (float) processing_time;
+    stats.latency = (float) latency;
+    return stats;
+}
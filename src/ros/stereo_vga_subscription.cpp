@@ -3,6 +3,7 @@
 //
 
 #include <dji_osdk_ros/StereoVGASubscription.h>
+#include <riser_inspection/StereoPipelineStats.h>
 #include "ros/ros.h"
 #include <signal.h>
 
@@ -11,6 +12,25 @@ ros::ServiceClient stereo_vga_subscription_client;
 dji_osdk_ros::StereoVGASubscription subscription;
 
 bool vga_imgs_subscribed = false;
+const int VGA_OFF = -1;
+int vga_freq = VGA_OFF;
+volatile sig_atomic_t shutdown_requested = 0;
+
+//! Pipeline load, from /stereo_depth_perception/pipeline_stats
+riser_inspection::StereoPipelineStats last_stats;
+ros::WallTime last_stats_time;
+uint64_t window_delivered = 0, window_lost = 0;
+int overload_checks = 0, headroom_checks = 0;
+
+/// Parameters
+std::string image_topic;
+double check_period = 2.0;   // s
+double idle_timeout = 5.0;   // s without a consumer before unsubscribing
+double overload_load = 0.9;  // processing time over frame period that is too slow for 20 Hz
+double headroom_load = 0.6;  // projected 20 Hz load below which 10 Hz goes back to 20 Hz
+double max_drop_ratio = 0.2; // lost pairs over received pairs
+int overload_hold = 2;       // checks before dropping to 10 Hz
+int headroom_hold = 5;       // checks before going back to 20 Hz
 
 
 bool imgSubscriptionHelper(dji_osdk_ros::StereoVGASubscription &service) {
@@ -22,7 +42,10 @@ bool imgSubscriptionHelper(dji_osdk_ros::StereoVGASubscription &service) {
         action = "subscribed";
     }
 
-    stereo_vga_subscription_client.call(service);
+    if (!stereo_vga_subscription_client.call(service)) {
+        ROS_ERROR("Service %s not available", stereo_vga_subscription_client.getService().c_str());
+        return false;
+    }
     if (service.response.result == true) {
         ROS_INFO("Successfully %s to VGA images", action.c_str());
         if (service.request.unsubscribe_vga) {
@@ -38,32 +61,104 @@ bool imgSubscriptionHelper(dji_osdk_ros::StereoVGASubscription &service) {
     return true;
 }
 
-void shutDownHandler(int s) {
-    ROS_INFO("Caught signal %d", s);
-
+/// Subscribe the front pair at freq (VGA_10_HZ or VGA_20_HZ), VGA_OFF unsubscribes
+bool setVgaFrequency(int freq) {
+    if (freq == vga_freq && vga_imgs_subscribed == (freq != VGA_OFF)) { return true; }
+    //! The OSDK keeps the rate of an active subscription, so a change goes through unsubscribe
     if (vga_imgs_subscribed) {
         subscription.request.unsubscribe_vga = 1;
-        imgSubscriptionHelper(subscription);
+        if (!imgSubscriptionHelper(subscription)) { return false; }
+        vga_freq = VGA_OFF;
     }
+    if (freq == VGA_OFF) { return true; }
+    subscription.request.vga_freq = (uint8_t) freq;
+    subscription.request.front_vga = 1;
+    subscription.request.unsubscribe_vga = 0;
+    if (!imgSubscriptionHelper(subscription)) { return false; }
+    vga_freq = freq;
+    ROS_INFO("Front VGA pair at %s", freq == subscription.request.VGA_20_HZ ? "20 Hz" : "10 Hz");
+    overload_checks = headroom_checks = 0;
+    window_delivered = window_lost = 0;
+    return true;
+}
 
-    exit(1);
+/// Nodes other than this one subscribed to the VGA images, from the master
+int countConsumers() {
+    XmlRpc::XmlRpcValue args, result, payload;
+    args[0] = ros::this_node::getName();
+    if (!ros::master::execute("getSystemState", args, result, payload, false)) { return -1; }
+    int consumers = 0;
+    XmlRpc::XmlRpcValue &subscribers = payload[1];
+    for (int i = 0; i < subscribers.size(); i++) {
+        if (std::string(subscribers[i][0]) != image_topic) { continue; }
+        for (int j = 0; j < subscribers[i][1].size(); j++) {
+            if (std::string(subscribers[i][1][j]) != ros::this_node::getName()) { consumers++; }
+        }
+    }
+    return consumers;
 }
 
-int
-main(int argc, char **argv) {
-    ros::init(argc, argv, "rosservice_stereo_vga");
-    ros::NodeHandle nh;
+void statsCallback(const riser_inspection::StereoPipelineStats::ConstPtr &stats) {
+    if (last_stats_time.toSec() > 0 && stats->delivered >= last_stats.delivered) {
+        window_delivered += stats->delivered - last_stats.delivered;
+        window_lost += (stats->dropped - last_stats.dropped) + (stats->mismatched - last_stats.mismatched);
+    }
+    last_stats = *stats;
+    last_stats_time = ros::WallTime::now();
+}
 
-    stereo_vga_subscription_client = nh.serviceClient<dji_osdk_ros::StereoVGASubscription>("stereo_vga_subscription");
+/** Every check_period: no consumer for idle_timeout unsubscribes, a pipeline that cannot
+ *  keep up with 20 Hz (processing time or lost pairs) drops to 10 Hz, and a pipeline with
+ *  headroom at 10 Hz goes back to 20 Hz. Both switches need several checks in a row. */
+void checkLoad(ros::WallTime &last_consumer) {
+    const ros::WallTime now = ros::WallTime::now();
+    int consumers = countConsumers();
+    if (consumers != 0) { last_consumer = now; }
+    if ((now - last_consumer).toSec() > idle_timeout) {
+        if (vga_imgs_subscribed) {
+            ROS_INFO("No consumer of %s, unsubscribing", image_topic.c_str());
+            setVgaFrequency(VGA_OFF);
+        }
+        return;
+    }
+    if (!vga_imgs_subscribed) {
+        setVgaFrequency(subscription.request.VGA_20_HZ);
+        return;
+    }
+    if ((now - last_stats_time).toSec() > 2 * check_period) { return; }
+
+    const double period = vga_freq == subscription.request.VGA_20_HZ ? 0.05 : 0.1;
+    const double load = last_stats.processing_time / period;
+    const double drop_ratio = window_delivered + window_lost > 0
+                              ? (double) window_lost / (double) (window_delivered + window_lost) : 0;
+    window_delivered = window_lost = 0;
+
+    if (vga_freq == subscription.request.VGA_20_HZ) {
+        overload_checks = load > overload_load || drop_ratio > max_drop_ratio ? overload_checks + 1 : 0;
+        if (overload_checks >= overload_hold) {
+            ROS_WARN("Stereo pipeline at %.0f%% load, %.0f%% pairs lost, dropping to 10 Hz",
+                     load * 100, drop_ratio * 100);
+            setVgaFrequency(subscription.request.VGA_10_HZ);
+        }
+    } else {
+        //! Load measured at 10 Hz, the same processing time at 20 Hz doubles it
+        headroom_checks = load * 2 < headroom_load && drop_ratio < max_drop_ratio / 2 ? headroom_checks + 1 : 0;
+        if (headroom_checks >= headroom_hold) {
+            ROS_INFO("Stereo pipeline at %.0f%% load, back to 20 Hz", load * 100);
+            setVgaFrequency(subscription.request.VGA_20_HZ);
+        }
+    }
+}
 
-    subscription.request.vga_freq = subscription.request.VGA_20_HZ;
-    subscription.request.front_vga = 1;
-    subscription.request.unsubscribe_vga = 0;
+void shutDownHandler(int s) {
+    //! Only flag it here, the service call is made from the main loop
+    shutdown_requested = s;
+}
 
-    if (!imgSubscriptionHelper(subscription)) {
-        return -1;
-    }
-    ros::Duration(1).sleep();
+int
+main(int argc, char **argv) {
+    ros::init(argc, argv, "m210_stereo_vga_subscription", ros::init_options::NoSigintHandler);
+    ros::NodeHandle nh;
 
     struct sigaction sigIntHandler;
     sigIntHandler.sa_handler = shutDownHandler;
@@ -71,4 +166,48 @@ main(int argc, char **argv) {
     sigIntHandler.sa_flags = 0;
     sigaction(SIGINT, &sigIntHandler, NULL);
 
-}
\ No newline at end of file
+    std::string stats_topic;
+    nh.param("/m210_stereo_vga_subscription/image_topic", image_topic,
+             std::string("/dji_osdk_ros/stereo_vga_front_left_images"));
+    nh.param("/m210_stereo_vga_subscription/stats_topic", stats_topic,
+             std::string("/stereo_depth_perception/pipeline_stats"));
+    nh.param("/m210_stereo_vga_subscription/check_period", check_period, 2.0);
+    nh.param("/m210_stereo_vga_subscription/idle_timeout", idle_timeout, 5.0);
+    nh.param("/m210_stereo_vga_subscription/overload_load", overload_load, 0.9);
+    nh.param("/m210_stereo_vga_subscription/headroom_load", headroom_load, 0.6);
+    nh.param("/m210_stereo_vga_subscription/max_drop_ratio", max_drop_ratio, 0.2);
+    nh.param("/m210_stereo_vga_subscription/overload_hold", overload_hold, 2);
+    nh.param("/m210_stereo_vga_subscription/headroom_hold", headroom_hold, 5);
+
+    stereo_vga_subscription_client = nh.serviceClient<dji_osdk_ros::StereoVGASubscription>("stereo_vga_subscription");
+    ros::Subscriber stats_sub = nh.subscribe(stats_topic, 1, statsCallback);
+
+    if (!stereo_vga_subscription_client.waitForExistence(ros::Duration(10))) {
+        ROS_ERROR("Service %s not available", stereo_vga_subscription_client.getService().c_str());
+        return -1;
+    }
+
+    //! Subscribe straight away, consumers usually start with this node
+    if (!setVgaFrequency(subscription.request.VGA_20_HZ)) {
+        return -1;
+    }
+    ros::WallTime last_consumer = ros::WallTime::now();
+    ros::WallTime last_check = last_consumer;
+
+    ros::Rate rate(10);
+    while (ros::ok() && !shutdown_requested) {
+        ros::spinOnce();
+        if ((ros::WallTime::now() - last_check).toSec() >= check_period) {
+            last_check = ros::WallTime::now();
+            checkLoad(last_consumer);
+        }
+        rate.sleep();
+    }
+
+    if (vga_imgs_subscribed) {
+        ROS_INFO("Caught signal %d", (int) shutdown_requested);
+        setVgaFrequency(VGA_OFF);
+    }
+    ros::shutdown();
+    return 0;
+}
@@ -0,0 +1,230 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+
+#include <telemetry_log.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+TelemetryLogWriter::~TelemetryLogWriter() {
+    close();
+}
+
+bool TelemetryLogWriter::open(const std::string &path, const std::vector<std::string> &names, uint32_t every) {
+    close();
+    log = fopen(path.c_str(), "w");
+    index = fopen((path + ".idx").c_str(), "wb");
+    if (log == nullptr || index == nullptr) {
+        std::cerr << "Cannot create " << path << "\n";
+        close();
+        return false;
+    }
+    index_every = std::max<uint32_t>(every, 1);
+    const uint32_t index_header[2] = {TELEMETRY_INDEX_MAGIC, index_every};
+    fwrite(index_header, sizeof(index_header), 1, index);
+
+    std::string header = "stamp";
+    for (const std::string &name : names) { header += "\t" + name; }
+    header += "\n";
+    fputs(header.c_str(), log);
+    offset = header.size();
+    columns = names.size();
+    rows = 0;
+    last_indexed = -1e300;
+    return true;
+}
+
+bool TelemetryLogWriter::append(double stamp, const std::vector<double> &values) {
+    return writeRow(stamp, values, nullptr);
+}
+
+bool TelemetryLogWriter::append(double stamp, const std::vector<double> &values, const std::string &text) {
+    return writeRow(stamp, values, &text);
+}
+
+bool TelemetryLogWriter::writeRow(double stamp, const std::vector<double> &values, const std::string *text) {
+    if (log == nullptr || values.size() + (text ? 1 : 0) != columns) { return false; }
+    //! Only rows in time order are indexed, the binary search needs sorted stamps
+    if (rows++ % index_every == 0 && stamp >= last_indexed) {
+        TelemetryIndexEntry entry = {stamp, offset};
+        fwrite(&entry, sizeof(entry), 1, index);
+        last_indexed = stamp;
+    }
+    char line[64];
+    int written = snprintf(line, sizeof(line), "%.6f", stamp);
+    fputs(line, log);
+    offset += (uint64_t) written;
+    for (double value : values) {
+        written = snprintf(line, sizeof(line), "\t%.12g", value);
+        fputs(line, log);
+        offset += (uint64_t) written;
+    }
+    if (text) {
+        std::string field = "\t" + *text;
+        std::replace_if(field.begin() + 1, field.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; },
+                        '_');
+        fputs(field.c_str(), log);
+        offset += field.size();
+    }
+    fputc('\n', log);
+    offset++;
+    return true;
+}
+
+void TelemetryLogWriter::flush() {
+    //! Log first, an index entry never points past the end of the log
+    if (log) { fflush(log); }
+    if (index) { fflush(index); }
+}
+
+void TelemetryLogWriter::close() {
+    flush();
+    if (log) { fclose(log); }
+    if (index) { fclose(index); }
+    log = index = nullptr;
+}
+
+bool TelemetryLog::open(const std::string &path) {
+    if (!reader.open(path, "\t", true)) { return false; }
+    const std::vector<std::string> &header = reader.getNames();
+    if (header.empty() || header[0] != "stamp") {
+        std::cerr << path << " has no stamp column\n";
+        return false;
+    }
+    names.assign(header.begin() + 1, header.end());
+    angle.assign(names.size(), false);
+    first_row = reader.tell();
+    entries.clear();
+
+    const std::string index_path = path + ".idx";
+    FILE *index = fopen(index_path.c_str(), "rb");
+    if (index == nullptr) { return buildIndex(index_path); }
+    uint32_t index_header[2] = {0, 0};
+    bool valid = fread(index_header, sizeof(index_header), 1, index) == 1 && index_header[0] == TELEMETRY_INDEX_MAGIC;
+    TelemetryIndexEntry entry;
+    while (valid && fread(&entry, sizeof(entry), 1, index) == 1) {
+        //! Entries written after the last flush of the log are dropped
+        if (!reader.seek(entry.offset)) { break; }
+        //! An offset inside a row belongs to another version of the log, the index is stale
+        if (entry.offset < first_row || !reader.isRowStart(entry.offset)) {
+            std::cerr << index_path << " does not match the log, rebuilding it\n";
+            valid = false;
+            break;
+        }
+        entries.push_back(entry);
+    }
+    fclose(index);
+    return valid ? true : buildIndex(index_path);
+}
+
+bool TelemetryLog::buildIndex(const std::string &index_path) {
+    entries.clear();
+    reader.seek(first_row);
+    const uint32_t every = 64;
+    size_t rows = 0;
+    double last = -1e300;
+    for (size_t offset = reader.tell(); reader.next(); offset = reader.tell()) {
+        double stamp;
+        if (rows++ % every == 0 && reader.getDouble(0, stamp) && stamp >= last) {
+            entries.push_back({stamp, offset});
+            last = stamp;
+        }
+    }
+    FILE *index = fopen(index_path.c_str(), "wb");
+    if (index) {
+        const uint32_t index_header[2] = {TELEMETRY_INDEX_MAGIC, every};
+        fwrite(index_header, sizeof(index_header), 1, index);
+        fwrite(entries.data(), sizeof(TelemetryIndexEntry), entries.size(), index);
+        fclose(index);
+    }
+    return true;
+}
+
+int TelemetryLog::column(const std::string &name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) { return (int) i; }
+    }
+    return -1;
+}
+
+void TelemetryLog::setAngleColumn(const std::string &name) {
+    int i = column(name);
+    if (i >= 0) { angle[i] = true; }
+}
+
+bool TelemetryLog::readRow(double &stamp, std::vector<double> &values) {
+    while (reader.next()) {
+        if (!reader.getDouble(0, stamp)) { continue; }
+        values.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            values[i] = reader.asDouble(i + 1, NAN);
+        }
+        return true;
+    }
+    return false;
+}
+
+void TelemetryLog::locate(double t) {
+    auto it = std::upper_bound(entries.begin(), entries.end(), t,
+                               [](double stamp, const TelemetryIndexEntry &entry) { return stamp < entry.stamp; });
+    reader.seek(it == entries.begin() ? first_row : (it - 1)->offset);
+}
+
+bool TelemetryLog::at(double t, std::vector<double> &values) {
+    locate(t);
+    double stamp, previous_stamp = 0;
+    bool have_previous = false;
+    while (readRow(stamp, row)) {
+        if (stamp <= t) {
+            previous.swap(row);
+            previous_stamp = stamp;
+            have_previous = true;
+            continue;
+        }
+        if (!have_previous) { return false; }
+        if (previous_stamp == t) { break; }
+        if (stamp - previous_stamp > max_gap) { return false; }
+        const double w = (t - previous_stamp) / (stamp - previous_stamp);
+        values.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            double delta = row[i] - previous[i];
+            if (angle[i]) { delta = std::remainder(delta, 360.0); }
+            values[i] = previous[i] + w * delta;
+            if (angle[i]) { values[i] = std::remainder(values[i], 360.0); }
+        }
+        return true;
+    }
+    //! Exactly on a row, also the last one of the log
+    if (have_previous && previous_stamp == t) {
+        values = previous;
+        return true;
+    }
+    return false;
+}
+
+size_t TelemetryLog::range(double t0, double t1, const std::function<void(double, const std::vector<double> &)> &visit) {
+    locate(t0);
+    size_t count = 0;
+    double stamp;
+    while (readRow(stamp, row)) {
+        if (stamp < t0) { continue; }
+        if (stamp > t1) { break; }
+        visit(stamp, row);
+        count++;
+    }
+    return count;
+}
+
+double TelemetryLog::getStart() {
+    reader.seek(first_row);
+    double stamp;
+    return readRow(stamp, row) ? stamp : NAN;
+}
+
+double TelemetryLog::getEnd() {
+    reader.seek(entries.empty() ? first_row : entries.back().offset);
+    double stamp, last = NAN;
+    while (readRow(stamp, row)) { last = stamp; }
+    return last;
+}
@@ -1,48 +1,413 @@
-#include <ostream>
-#include <string>
+//
+// Created by vant3d on 19/10/2026.
+//
+// Relabel and validate a YOLO label set (one "class cx cy w h" line per object, normalised
+// coordinates) in parallel.
+//
+//   change_txt <labels dir> [--map OLD:NEW,...] [--images dir] [--min-pixels N] [--clamp]
+//              [--threads N] [--dry-run]
+//
+// --map remaps classes, "*:N" maps every class not listed and "OLD:-" deletes the objects
+// of a class. Boxes must lie inside the image: with --images the size of the image of each
+// label (same name, .png or .jpg) is read from its header and boxes smaller than min-pixels
+// are rejected. Invalid lines are reported and dropped, or clipped with --clamp. Files are
+// memory-mapped, every line is kept, and a changed file is replaced atomically through a
+// temporary file and rename, so an interrupted run never leaves a truncated label.
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
-#include <boost/algorithm/string.hpp>
-
-
-int main()//(int argv, char** argc)
-{
-    // Extracting path of individual image stored in a given directory
-    // Path of the folder containing checkerboard images
-    std::string img_counter_;
-    for (int i = 1; i < 922; i++) {
-        if (i < 10) {
-            img_counter_ = "0";
-        } else if (i >= 10) {
-            img_counter_ = "";
-        }
-        std::string path = "/home/vant3d/Documents/labels/labmetro_image_" + img_counter_ + std::to_string(i) + ".txt";
-
-        std::ifstream input(path);
-        std::ofstream output;
-        std::vector<std::vector<std::string>> dataList;
-        std::string line;
-        std::vector<std::string> vec;
-        // Iterate through each line and split the content using delimeter
-        while (getline(input, line)) {
-            boost::algorithm::split(vec, line, boost::is_any_of(" "));
-            vec[0] = std::to_string(1);
-        }
-        output.open(path);
-            if (output.is_open()) {
-                for (int k = 0; k<5; k++) {
-                    if(k==4){
-                    output << vec[k];
-                }else{
-                    output << vec[k] << " ";
-                    }
-                }
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const int DROP_CLASS = -1;
+
+struct Options {
+    std::string labels_dir;
+    std::string images_dir;
+    std::map<int, int> class_map;
+    int default_class = -2; // -2 keeps unlisted classes
+    double min_pixels = 2;
+    bool clamp = false;
+    bool dry_run = false;
+    unsigned threads = 0;
+};
+
+struct Stats {
+    size_t files = 0, changed = 0, failed = 0, missing_image = 0;
+    size_t boxes = 0, relabelled = 0, deleted = 0, invalid = 0, clamped = 0;
+
+    void add(const Stats &other) {
+        files += other.files;
+        changed += other.changed;
+        failed += other.failed;
+        missing_image += other.missing_image;
+        boxes += other.boxes;
+        relabelled += other.relabelled;
+        deleted += other.deleted;
+        invalid += other.invalid;
+        clamped += other.clamped;
+    }
+};
+
+/// Read-only view of a whole file, empty when the file is empty or cannot be mapped
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        fd_ = open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) { return; }
+        struct stat st;
+        if (fstat(fd_, &st) == 0 && st.st_size > 0) {
+            void *data = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (data != MAP_FAILED) {
+                data_ = (const char *) data;
+                size_ = (size_t) st.st_size;
+                madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    ~MappedFile() {
+        if (data_) { munmap((void *) data_, size_); }
+        if (fd_ >= 0) { close(fd_); }
+    }
+
+    bool opened() const { return fd_ >= 0; }
+
+    const char *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    int fd_ = -1;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+//! Number parsers over [p, end), the mapped file is not NUL terminated
+static void skipBlanks(const char *&p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) { p++; }
+}
+
+static bool parseInt(const char *&p, const char *end, int &value) {
+    skipBlanks(p, end);
+    bool negative = p < end && *p == '-';
+    if (negative || (p < end && *p == '+')) { p++; }
+    if (p >= end || *p < '0' || *p > '9') { return false; }
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') { value = value * 10 + (*p++ - '0'); }
+    if (negative) { value = -value; }
+    return true;
+}
+
+static bool parseDouble(const char *&p, const char *end, double &value) {
+    skipBlanks(p, end);
+    const char *start = p;
+    bool negative = p < end && *p == '-';
+    if (negative || (p < end && *p == '+')) { p++; }
+    double mantissa = 0;
+    int exponent = 0, digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        mantissa = mantissa * 10 + (*p++ - '0');
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + (*p++ - '0');
+            exponent--;
+            digits++;
+        }
+    }
+    if (digits == 0) {
+        p = start;
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        int power;
+        if (parseInt(e, end, power)) {
+            exponent += power;
+            p = e;
+        }
+    }
+    value = mantissa * std::pow(10.0, exponent);
+    if (negative) { value = -value; }
+    return true;
+}
+
+//! Image size from the PNG IHDR or the JPEG SOF header, without decoding
+static bool imageSize(const std::string &path, int &width, int &height) {
+    MappedFile file(path);
+    const unsigned char *d = (const unsigned char *) file.data();
+    const size_t n = file.size();
+    if (n >= 24 && d[0] == 0x89 && d[1] == 'P' && d[2] == 'N' && d[3] == 'G') {
+        width = (d[16] << 24) | (d[17] << 16) | (d[18] << 8) | d[19];
+        height = (d[20] << 24) | (d[21] << 16) | (d[22] << 8) | d[23];
+        return true;
+    }
+    if (n >= 4 && d[0] == 0xFF && d[1] == 0xD8) {
+        size_t i = 2;
+        while (i + 9 < n) {
+            if (d[i] != 0xFF) { return false; }
+            unsigned char marker = d[i + 1];
+            size_t length = (d[i + 2] << 8) | d[i + 3];
+            //! SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC)
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                height = (d[i + 5] << 8) | d[i + 6];
+                width = (d[i + 7] << 8) | d[i + 8];
+                return true;
+            }
+            i += 2 + length;
+        }
+    }
+    return false;
+}
+
+static bool writeAtomically(const std::string &path, const std::string &content) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { return false; }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = write(fd, content.data() + written, content.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            close(fd);
+            unlink(tmp.c_str());
+            return false;
+        }
+        written += (size_t) n;
+    }
+    bool ok = fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void report(std::mutex &log_mutex, const std::string &file, int line, const char *what) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    std::cerr << file << ":" << line << ": " << what << "\n";
+}
+
+/** Relabel and validate every line of one label file, the file is rewritten only if a line
+ *  changed. Empty lines are dropped, an empty file stays a valid background image. */
+static void processLabel(const std::string &name, const Options &options, Stats &stats, std::mutex &log_mutex) {
+    const std::string path = options.labels_dir + "/" + name;
+    stats.files++;
+
+    int width = 0, height = 0;
+    if (!options.images_dir.empty()) {
+        const std::string stem = options.images_dir + "/" + name.substr(0, name.size() - 4);
+        if (!imageSize(stem + ".png", width, height) && !imageSize(stem + ".jpg", width, height)) {
+            stats.missing_image++;
+            report(log_mutex, path, 0, "no image to validate against");
+        }
+    }
+
+    MappedFile file(path);
+    if (!file.opened()) {
+        stats.failed++;
+        report(log_mutex, path, 0, "cannot open");
+        return;
+    }
+    const char *p = file.data(), *end = p + file.size();
+    std::string output;
+    output.reserve(file.size() + 16);
+    bool changed = false;
+    char buffer[96];
+    for (int line = 1; p < end; line++) {
+        const char *eol = (const char *) memchr(p, '\n', (size_t) (end - p));
+        if (eol == nullptr) { eol = end; }
+        const char *q = p;
+        const char *line_start = p;
+        p = eol + 1;
+
+        skipBlanks(q, eol);
+        if (q == eol) {
+            changed = changed || eol > line_start;
+            continue;
+        }
+        int label;
+        double box[4];
+        bool parsed = parseInt(q, eol, label);
+        for (int k = 0; k < 4 && parsed; k++) { parsed = parseDouble(q, eol, box[k]); }
+        skipBlanks(q, eol);
+        if (!parsed || q != eol) {
+            stats.invalid++;
+            changed = true;
+            report(log_mutex, path, line, "not a class cx cy w h line, dropped");
+            continue;
+        }
+        stats.boxes++;
+
+        int mapped = label;
+        auto it = options.class_map.find(label);
+        if (it != options.class_map.end()) {
+            mapped = it->second;
+        } else if (options.default_class != -2) {
+            mapped = options.default_class;
+        }
+        if (mapped == DROP_CLASS) {
+            stats.deleted++;
+            changed = true;
+            continue;
+        }
+        if (mapped != label) { stats.relabelled++; }
+        //! Only this line decides whether it is reformatted, changed decides whether the file is written
+        bool line_changed = mapped != label;
+
+        //! Box bounds in normalised coordinates, with half a pixel of slack when the size is known
+        const double slack = width > 0 ? 0.5 / width : 1e-6;
+        const double slack_y = height > 0 ? 0.5 / height : 1e-6;
+        double x0 = box[0] - box[2] / 2, x1 = box[0] + box[2] / 2;
+        double y0 = box[1] - box[3] / 2, y1 = box[1] + box[3] / 2;
+        bool inside = box[2] > 0 && box[3] > 0 && x0 >= -slack && x1 <= 1 + slack && y0 >= -slack_y &&
+                      y1 <= 1 + slack_y;
+        if (!inside && options.clamp) {
+            x0 = std::max(0.0, x0), x1 = std::min(1.0, x1);
+            y0 = std::max(0.0, y0), y1 = std::min(1.0, y1);
+            if (x1 > x0 && y1 > y0) {
+                box[0] = (x0 + x1) / 2, box[2] = x1 - x0;
+                box[1] = (y0 + y1) / 2, box[3] = y1 - y0;
+                inside = true;
+                stats.clamped++;
+                line_changed = true;
+            }
+        }
+        if (inside && width > 0 && (box[2] * width < options.min_pixels || box[3] * height < options.min_pixels)) {
+            inside = false;
+        }
+        if (!inside) {
+            stats.invalid++;
+            changed = true;
+            report(log_mutex, path, line, "box outside the image or too small, dropped");
+            continue;
+        }
+
+        if (!line_changed) {
+            //! Untouched line, copied verbatim so the file stays byte-identical
+            output.append(line_start, (size_t) (eol - line_start));
+            if (output.back() == '\r') { output.pop_back(); }
+            output.push_back('\n');
+            continue;
+        }
+        changed = true;
+        int n = snprintf(buffer, sizeof(buffer), "%d %.6f %.6f %.6f %.6f\n", mapped, box[0], box[1], box[2], box[3]);
+        output.append(buffer, (size_t) n);
+    }
+    //! A last line without newline or with CR endings is normalised only if something else changed
+    if (!changed) { return; }
+
+    stats.changed++;
+    if (!options.dry_run && !writeAtomically(path, output)) {
+        stats.failed++;
+        report(log_mutex, path, 0, "failed to write");
+    }
+}
+
+static bool parseMap(const std::string &text, Options &options) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t comma = text.find(',', start);
+        std::string entry = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        start = comma == std::string::npos ? text.size() : comma + 1;
+        size_t colon = entry.find(':');
+        if (colon == std::string::npos) { return false; }
+        std::string from = entry.substr(0, colon), to = entry.substr(colon + 1);
+        int target = to == "-" ? DROP_CLASS : atoi(to.c_str());
+        if (from == "*") {
+            options.default_class = target;
+        } else {
+            options.class_map[atoi(from.c_str())] = target;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--map" && has_value) {
+            if (!parseMap(argv[++i], options)) {
+                std::cerr << "Bad class map, expected OLD:NEW,...\n";
+                return -1;
             }
-//        0 0.124512 0.491167 0.248535 0.978333
-        output.close();
+        } else if (arg == "--images" && has_value) {
+            options.images_dir = argv[++i];
+        } else if (arg == "--min-pixels" && has_value) {
+            options.min_pixels = atof(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            options.threads = (unsigned) atoi(argv[++i]);
+        } else if (arg == "--clamp") {
+            options.clamp = true;
+        } else if (arg == "--dry-run") {
+            options.dry_run = true;
+        } else if (options.labels_dir.empty() && arg[0] != '-') {
+            options.labels_dir = arg;
+        } else {
+            options.labels_dir.clear();
+            break;
+        }
+    }
+    if (options.labels_dir.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <labels dir> [--map OLD:NEW,...] [--images dir]"
+                  << " [--min-pixels N] [--clamp] [--threads N] [--dry-run]\n";
+        return -1;
+    }
+
+    std::vector<std::string> labels;
+    DIR *dir = opendir(options.labels_dir.c_str());
+    if (dir == nullptr) {
+        std::cerr << "Cannot open " << options.labels_dir << "\n";
+        return -1;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0 && name != "classes.txt") {
+            labels.push_back(name);
+        }
     }
+    closedir(dir);
 
-    return 0;
+    //! Workers pull the next file from a shared counter, a slow file never stalls a whole chunk
+    unsigned n_threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Stats> stats(n_threads);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next(0);
+    std::mutex log_mutex;
+    for (unsigned t = 0; t < n_threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = next++; i < labels.size(); i = next++) {
+                processLabel(labels[i], options, stats[t], log_mutex);
+            }
+        });
+    }
+    for (std::thread &worker : workers) { worker.join(); }
 
+    Stats total;
+    for (const Stats &s : stats) { total.add(s); }
+    printf("%zu label files, %zu boxes: %zu relabelled, %zu deleted, %zu clamped, %zu invalid\n",
+           total.files, total.boxes, total.relabelled, total.deleted, total.clamped, total.invalid);
+    printf("%zu files %s, %zu failed, %zu without image\n", total.changed,
+           options.dry_run ? "would change" : "rewritten", total.failed, total.missing_image);
+    return total.failed > 0 ? 1 : 0;
 }
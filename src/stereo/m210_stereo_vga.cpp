@@ -1,21 +1,43 @@
 #include "m210_stereo_vga.h"
 #include <darknet_ros_msgs/BoundingBoxes.h>
+#include <cv_bridge/cv_bridge.h>
+#include <ctime>
 
 using namespace M210_STEREO;
 
 // for visualization purpose
 bool is_disp_filterd;
-int count = 1;
+PreviewWorker::Ptr preview;
+//! Compressed rectified left and disparity for the ground station link
+CompressedPreview compressed_preview;
+int preview_left_stream = -1;
+int preview_disparity_stream = -1;
+StereoPairMailbox stereo_mailbox;
+//! Raw VGA pairs of the last minutes, for reprocessing with other matcher settings
+RawStereoRing::Ptr black_box;
+bool in_air = false;
+ros::Publisher pipeline_stats_publisher;
 dji_osdk_ros::StereoVGASubscription subscription;
 ros::Publisher rect_img_left_publisher;
+ros::Publisher detection_img_publisher;
+int detection_stride = 1;
+unsigned int frame_count = 0;
 ros::Publisher rect_img_right_publisher;
 ros::Publisher left_disparity_publisher;
+ros::Publisher raw_disparity_publisher;
+ros::Publisher riser_cylinder_publisher;
+bool fit_cylinder = false;
+CylinderFitter::Ptr cylinder_fitter;
+ros::Publisher sector_distances_publisher;
+ProximityGuard::Ptr proximity_guard;
 
 int main(int argc, char **argv) {
     ros::init(argc, argv, "m210_stereo_perception");
     ros::NodeHandle nh;
 
-    std::string yaml_file_path = "/home/vant3d/catkin_ws/src/stereo_image/config/tb_matlab_m210_stereo_calib.yaml";
+    std::string yaml_file_path;
+    nh.param("/m210_stereo/calibration_file", yaml_file_path,
+             std::string("/home/vant3d/catkin_ws/src/stereo_image/config/tb_matlab_m210_stereo_calib.yaml"));
     Config::setParamFile(yaml_file_path);
 
     //! Instantiate some relevant objects
@@ -23,10 +45,6 @@ int main(int argc, char **argv) {
     CameraParam::Ptr camera_right_ptr;
     StereoFrame::Ptr stereo_frame_ptr;
 
-    message_filters::Subscriber<sensor_msgs::Image> img_left_sub;
-    message_filters::Subscriber<sensor_msgs::Image> img_right_sub;
-    message_filters::Subscriber<darknet_ros_msgs::BoundingBoxes> bb_darknet_sub;
-    message_filters::TimeSynchronizer<sensor_msgs::Image, sensor_msgs::Image> *topic_synchronizer;
 
 
     //! Setup stereo frame
@@ -39,33 +57,182 @@ int main(int argc, char **argv) {
     //! Setup ros related stuff
     rect_img_left_publisher =
             nh.advertise<sensor_msgs::Image>("/stereo_depth_perception/rectified_vga_front_left_image", 10);
+    //! Every Nth rectified left image for darknet, the tracker fills the frames in between
+    nh.param("/m210_stereo/detection_stride", detection_stride, 1);
+    detection_img_publisher =
+            nh.advertise<sensor_msgs::Image>("/stereo_depth_perception/detection_left_image", 1);
     rect_img_right_publisher =
             nh.advertise<sensor_msgs::Image>("/stereo_depth_perception/rectified_vga_front_right_image", 10);
     left_disparity_publisher =
             nh.advertise<sensor_msgs::Image>("/stereo_depth_perception/disparity_front_left_image", 10);
+    //! StereoBM output (16SC1, 4 fractional bits) for the dataset exporter, only built when subscribed
+    raw_disparity_publisher =
+            nh.advertise<sensor_msgs::Image>("/stereo_depth_perception/raw_disparity_front_left_image", 10);
+
+
+    //! Riser cylinder fit, seeds the inspection distance and diameter
+    nh.param("/m210_stereo/fit_cylinder", fit_cylinder, false);
+    if (fit_cylinder) {
+        bool inclined;
+        int stride, iterations;
+        double min_radius, max_radius, max_depth, inlier_threshold;
+        nh.param("/m210_stereo/cylinder_inclined", inclined, false);
+        nh.param("/m210_stereo/cylinder_stride", stride, 2);
+        nh.param("/m210_stereo/cylinder_iterations", iterations, 200);
+        nh.param("/m210_stereo/cylinder_inlier_threshold", inlier_threshold, 0.03);
+        nh.param("/m210_stereo/cylinder_min_radius", min_radius, 0.05);
+        nh.param("/m210_stereo/cylinder_max_radius", max_radius, 1.0);
+        nh.param("/m210_stereo/cylinder_max_depth", max_depth, 15.0);
+        cylinder_fitter = CylinderFitter::createCylinderFitter();
+        cylinder_fitter->setInclinedAxis(inclined);
+        cylinder_fitter->setStride(stride);
+        cylinder_fitter->setRansac(iterations, (float) inlier_threshold);
+        cylinder_fitter->setRadiusRange((float) min_radius, (float) max_radius);
+        cylinder_fitter->setDepthRange(0.5f, (float) max_depth);
+        riser_cylinder_publisher =
+                nh.advertise<riser_inspection::RiserCylinder>("/stereo_depth_perception/riser_cylinder", 10);
+    }
 
+    //! Nearest depth per sector for the mission proximity guard
+    bool use_proximity_guard;
+    nh.param("/m210_stereo/proximity_guard", use_proximity_guard, false);
+    if (use_proximity_guard) {
+        int sector_cols, sector_rows, min_pixels;
+        double max_range;
+        nh.param("/m210_stereo/sector_cols", sector_cols, 5);
+        nh.param("/m210_stereo/sector_rows", sector_rows, 3);
+        nh.param("/m210_stereo/sector_min_pixels", min_pixels, 50);
+        nh.param("/m210_stereo/sector_max_range", max_range, 20.0);
+        proximity_guard = ProximityGuard::createProximityGuard(sector_cols, sector_rows);
+        proximity_guard->setMinPixels(min_pixels);
+        proximity_guard->setDepthRange(0.3f, (float) max_range);
+        sector_distances_publisher =
+                nh.advertise<riser_inspection::SectorDistances>("/stereo_depth_perception/sector_distances", 1);
+    }
 
-    img_left_sub.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_left_images", 1);
-    img_right_sub.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_right_images", 1);
+    //! Preview of the rectified pair and disparity, off the stereo thread and never on the aircraft
+    bool headless;
+    double preview_rate, preview_scale;
+    nh.param("/m210_stereo/headless", headless, PreviewWorker::noDisplay());
+    nh.param("/m210_stereo/preview_rate", preview_rate, 5.0);
+    nh.param("/m210_stereo/preview_scale", preview_scale, 0.5);
+    if (!headless) {
+        preview = PreviewWorker::createPreviewWorker(preview_rate, preview_scale);
+        preview->start();
+    }
 
-    topic_synchronizer = new message_filters::TimeSynchronizer
-            <sensor_msgs::Image, sensor_msgs::Image>(img_left_sub, img_right_sub, 10);
+    bool preview_stream;
+    nh.param("/m210_stereo/preview_stream", preview_stream, false);
+    if (preview_stream) {
+        double bitrate, max_rate, min_scale, disparity_share;
+        int min_quality, max_quality;
+        nh.param("/m210_stereo/preview_bitrate", bitrate, 256.0); // kbit/s
+        nh.param("/m210_stereo/preview_max_rate", max_rate, 5.0);
+        nh.param("/m210_stereo/preview_min_scale", min_scale, 0.25);
+        nh.param("/m210_stereo/preview_min_quality", min_quality, 30);
+        nh.param("/m210_stereo/preview_max_quality", max_quality, 80);
+        nh.param("/m210_stereo/preview_disparity_share", disparity_share, 0.4);
+        compressed_preview.setBudget(bitrate * 1e3, max_rate, min_scale, min_quality, max_quality);
+        preview_left_stream = compressed_preview.addStream(
+                nh, "/stereo_depth_perception/preview/rectified_vga_front_left_image/compressed",
+                CompressedPreview::JPEG, 1.0 - disparity_share);
+        preview_disparity_stream = compressed_preview.addStream(
+                nh, "/stereo_depth_perception/preview/disparity_front_left_image/compressed",
+                CompressedPreview::PNG16, disparity_share);
+        compressed_preview.start();
+    }
 
+    //! Newest complete pair only, a slow frame drops the pairs behind it instead of queueing them
+    double match_tolerance;
+    bool match_sequence;
+    nh.param("/m210_stereo/match_tolerance", match_tolerance, 0.0);
+    nh.param("/m210_stereo/match_sequence", match_sequence, false);
+    stereo_mailbox.setMatching(match_tolerance, match_sequence);
+
+    //! Every complete pair goes to the ring on the subscriber thread, the matcher never waits on it
+    bool use_black_box;
+    nh.param("/m210_stereo/black_box", use_black_box, false);
+    ros::ServiceServer black_box_service;
+    ros::Subscriber flight_status_sub;
+    if (use_black_box) {
+        char default_file[64];
+        time_t now = time(nullptr);
+        strftime(default_file, sizeof(default_file), "stereo_black_box_%Y%m%d_%H%M%S.ring", localtime(&now));
+        std::string black_box_file;
+        double duration, rate;
+        nh.param("/m210_stereo/black_box_file", black_box_file, std::string(default_file));
+        nh.param("/m210_stereo/black_box_duration", duration, 60.0); // s
+        nh.param("/m210_stereo/black_box_rate", rate, 20.0);         // Hz of the VGA subscription
+        black_box = RawStereoRing::createRawStereoRing(black_box_file, (size_t) std::max(duration * rate, 1.0));
+        if (black_box) {
+            ROS_INFO("Stereo black box %s, %zu pairs", black_box_file.c_str(), black_box->getSlots());
+            stereo_mailbox.setPairObserver(&recordBlackBox);
+            black_box_service = nh.advertiseService("/stereo_depth_perception/flush_black_box",
+                                                    &flushBlackBoxCallback);
+            flight_status_sub = nh.subscribe("/dji_osdk_ros/flight_status", 10, &flightStatusCallback);
+        } else {
+            ROS_ERROR("Stereo black box disabled, cannot create %s", black_box_file.c_str());
+        }
+    }
+    stereo_mailbox.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_left_images",
+                             "/dji_osdk_ros/stereo_vga_front_right_images");
+    stereo_mailbox.start(boost::bind(&displayStereoFilteredDisparityCallback, _1, _2, stereo_frame_ptr));
+
+    //! Switch calibration without restarting the node, maps are rebuilt off the pipeline
+    ros::ServiceServer calibration_service = nh.advertiseService<riser_inspection::LoadCalibration::Request,
+            riser_inspection::LoadCalibration::Response>(
+            "/stereo_depth_perception/load_calibration",
+            boost::bind(&loadCalibrationCallback, _1, _2, stereo_frame_ptr));
+
+    pipeline_stats_publisher =
+            nh.advertise<riser_inspection::StereoPipelineStats>("/stereo_depth_perception/pipeline_stats", 1);
+    ros::WallTimer stats_timer = nh.createWallTimer(ros::WallDuration(1.0), [](const ros::WallTimerEvent &) {
+        pipeline_stats_publisher.publish(stereo_mailbox.getStats());
+    });
 
-    //! For signal handling, e.g. if user terminate the program with Ctrl+C
-    //! this program will unsubscribe the image stream if it's subscribed
+    ros::spin();
+    stereo_mailbox.stop();
+    black_box.reset();
+    compressed_preview.stop();
+    preview.reset();
+}
 
-    topic_synchronizer->registerCallback(boost::bind(&displayStereoFilteredDisparityCallback,
-                                                     _1, _2, stereo_frame_ptr));
 
+void recordBlackBox(const sensor_msgs::ImageConstPtr &img_left, const sensor_msgs::ImageConstPtr &img_right) {
+    if (img_left->data.size() < (size_t) VGA_WIDTH * VGA_HEIGHT ||
+        img_right->data.size() < (size_t) VGA_WIDTH * VGA_HEIGHT) {
+        return;
+    }
+    black_box->write(&img_left->data[0], &img_right->data[0], img_left->header.stamp.toSec(),
+                     img_right->header.stamp.toSec(), img_left->header.seq, img_right->header.seq);
+}
 
-    ros::spin();
+bool flushBlackBoxCallback(std_srvs::Trigger::Request &, std_srvs::Trigger::Response &response) {
+    black_box->flush();
+    response.success = true;
+    response.message = std::to_string(std::min<uint64_t>(black_box->getWritten(), black_box->getSlots())) +
+                       " pairs being written to disk";
+    return true;
 }
 
+//! Landing flushes and freezes the ring so the flight is kept, take-off starts recording again
+void flightStatusCallback(const std_msgs::UInt8::ConstPtr &status) {
+    const bool now_in_air = status->data == 2; // DJI M210: 0 stopped, 1 on ground, 2 in air
+    if (in_air && !now_in_air) {
+        black_box->setFrozen(true);
+        black_box->flush();
+        ROS_INFO("Landed, stereo black box frozen and flushed");
+    } else if (!in_air && now_in_air && black_box->isFrozen()) {
+        black_box->setFrozen(false);
+        ROS_INFO("Take-off, stereo black box recording");
+    }
+    in_air = now_in_air;
+}
 
 void displayStereoFilteredDisparityCallback(const sensor_msgs::ImageConstPtr &img_left,
                                             const sensor_msgs::ImageConstPtr &img_right,
                                             StereoFrame::Ptr stereo_frame_ptr) {
+    timer received = std::chrono::high_resolution_clock::now();
     //! Read raw images
     stereo_frame_ptr->readStereoImgs(img_left, img_right);
 
@@ -79,15 +246,19 @@ void displayStereoFilteredDisparityCallback(const sensor_msgs::ImageConstPtr &im
     stereo_frame_ptr->computeDisparityMap();
     timer disp_end = std::chrono::high_resolution_clock::now();
 
+    //! Before anything else, the guard is on the stop-the-aircraft path
+    if (proximity_guard) { publishSectorDistances(img_left->header, received, stereo_frame_ptr); }
+
     //! Filter disparity map
     timer filter_start = std::chrono::high_resolution_clock::now();
     stereo_frame_ptr->filterDisparityMap();
     is_disp_filterd = false;
     timer filter_end = std::chrono::high_resolution_clock::now();
 
-//    visualizeRectImgHelper(stereo_frame_ptr);
-
-//    visualizeDisparityMapHelper(stereo_frame_ptr);
+    if (preview) {
+        visualizeRectImgHelper(stereo_frame_ptr);
+        visualizeDisparityMapHelper(stereo_frame_ptr);
+    }
 
     sensor_msgs::Image rect_left_img = *img_left;
     sensor_msgs::Image rect_right_img = *img_right;
@@ -115,10 +286,19 @@ void displayStereoFilteredDisparityCallback(const sensor_msgs::ImageConstPtr &im
 
 
     rect_img_left_publisher.publish(rect_left_img);
+    if (frame_count++ % std::max(detection_stride, 1) == 0) { detection_img_publisher.publish(rect_left_img); }
     rect_img_right_publisher.publish(rect_right_img);
     left_disparity_publisher.publish(disparity_map);
+    if (raw_disparity_publisher.getNumSubscribers() > 0) {
+        raw_disparity_publisher.publish(
+                cv_bridge::CvImage(img_left->header, "16SC1", stereo_frame_ptr->getRawDisparityMap()).toImageMsg());
+    }
+    if (preview_left_stream >= 0) {
+        compressed_preview.submit(preview_left_stream, img_left->header, stereo_frame_ptr->getRectLeftImg());
+        compressed_preview.submit(preview_disparity_stream, img_left->header, stereo_frame_ptr->getRawDisparityMap());
+    }
 
-    cv::waitKey(1);
+    if (fit_cylinder) { fitRiserCylinder(img_left->header, stereo_frame_ptr); }
 
     duration rectify_time_diff = rectify_end - rectify_start;
     duration disp_time_diff = disp_end - disp_start;
@@ -133,55 +313,101 @@ void displayStereoFilteredDisparityCallback(const sensor_msgs::ImageConstPtr &im
 }
 
 
+bool loadCalibrationCallback(riser_inspection::LoadCalibration::Request &request,
+                             riser_inspection::LoadCalibration::Response &response,
+                             StereoFrame::Ptr stereo_frame_ptr) {
+    std::string file = request.file;
+    std::string current = stereo_frame_ptr->getCalibrationFile();
+    if (!file.empty() && file[0] != '/' && current.find('/') != std::string::npos) {
+        file = current.substr(0, current.rfind('/') + 1) + file;
+    }
+    response.result = stereo_frame_ptr->loadCalibration(file, response.message);
+    response.active_file = current;
+    if (response.result) {
+        ROS_INFO("%s", response.message.c_str());
+    } else {
+        ROS_ERROR("%s", response.message.c_str());
+    }
+    return true;
+}
+
+void publishSectorDistances(const std_msgs::Header &header, timer received, StereoFrame::Ptr stereo_frame_ptr) {
+    std::vector<float> distances = proximity_guard->compute(stereo_frame_ptr->getRawDisparityMap(),
+                                                            stereo_frame_ptr->getQ());
+    riser_inspection::SectorDistances sectors;
+    sectors.header = header;
+    sectors.rows = (uint8_t) proximity_guard->getRows();
+    sectors.cols = (uint8_t) proximity_guard->getCols();
+    sectors.distances = distances;
+    auto closest = std::min_element(distances.begin(), distances.end());
+    sectors.min_distance = *closest;
+    sectors.closest_sector = (uint8_t) (closest - distances.begin());
+    duration processing = std::chrono::high_resolution_clock::now() - received;
+    sectors.processing_time = processing.count();
+    sector_distances_publisher.publish(sectors);
+}
+
+void fitRiserCylinder(const std_msgs::Header &header, StereoFrame::Ptr stereo_frame_ptr) {
+    CylinderModel model = cylinder_fitter->fit(stereo_frame_ptr->getRawDisparityMap(), stereo_frame_ptr->getQ());
+    if (!model.valid) {
+        ROS_DEBUG("No riser cylinder in %d points (%.1f ms)", cylinder_fitter->getNumPoints(),
+                  cylinder_fitter->getFitTime() * 1000.0);
+        return;
+    }
+    riser_inspection::RiserCylinder cylinder;
+    cylinder.header = header;
+    cylinder.axis_point.x = model.axis_point.x;
+    cylinder.axis_point.y = model.axis_point.y;
+    cylinder.axis_point.z = model.axis_point.z;
+    cylinder.axis_direction.x = model.axis_direction[0];
+    cylinder.axis_direction.y = model.axis_direction[1];
+    cylinder.axis_direction.z = model.axis_direction[2];
+    cylinder.radius = model.radius;
+    cylinder.distance = model.distance;
+    cylinder.rms = model.rms;
+    cylinder.inliers = (uint32_t) model.inliers;
+    riser_cylinder_publisher.publish(cylinder);
+    ROS_DEBUG("Riser at %.2f m, radius %.3f m, %d inliers, %.1f ms", model.distance, model.radius,
+              model.inliers, cylinder_fitter->getFitTime() * 1000.0);
+}
+
+
 void
 visualizeRectImgHelper(StereoFrame::Ptr stereo_frame_ptr) {
+    static const std::string window = "Rectified Stereo Imgs with epipolar lines";
+    if (!preview->wantsFrame(window)) { return; }
     cv::Mat img_to_show;
 
     cv::hconcat(stereo_frame_ptr->getRectLeftImg(),
                 stereo_frame_ptr->getRectRightImg(),
                 img_to_show);
 
-    cv::resize(img_to_show, img_to_show,
-               cv::Size(M210_STEREO::VGA_WIDTH * 2, M210_STEREO::VGA_HEIGHT),
-               (0, 0), (0, 0), cv::INTER_LINEAR);
-
     // draw epipolar lines to visualize rectification
-    for (int j = 0; j < img_to_show.rows; j += 24) {
-        line(img_to_show, cv::Point(0, j),
-             cv::Point(img_to_show.cols, j),
-             cv::Scalar(255, 0, 0, 255), 1, 8);
-    }
-    cv::imshow("Rectified Stereo Imgs with epipolar lines", img_to_show);
-
-    std::stringstream writeD;
-    writeD << "Disparity" << count << ".png";
-    cv::imwrite(writeD.str(), stereo_frame_ptr->getDisparityMap());
-    count++;
+    preview->show(window, img_to_show, [](cv::Mat &image, double scale) {
+        for (int j = 0; j < image.rows; j += std::max(1, (int) (24 * scale))) {
+            line(image, cv::Point(0, j),
+                 cv::Point(image.cols, j),
+                 cv::Scalar(255, 0, 0, 255), 1, 8);
+        }
+        return image;
+    });
 }
 
 
 void
 visualizeDisparityMapHelper(StereoFrame::Ptr stereo_frame_ptr) {
-    cv::Mat mean, stddev;
-    cv::Mat raw_disp_map;
-
-    if (is_disp_filterd) {
-        raw_disp_map = stereo_frame_ptr->getFilteredDispMap().clone();
-    } else {
-        raw_disp_map = stereo_frame_ptr->getDisparityMap().clone();
-    }
-
-    double min_val, max_val;
-    cv::minMaxLoc(raw_disp_map, &min_val, &max_val, NULL, NULL);
-
-    cv::Mat scaled_disp_map;
-//    raw_disp_map.convertTo(scaled_disp_map, CV_8U, 255 / (max_val - min_val), -min_val / (max_val - min_val));
-    scaled_disp_map = (raw_disp_map / (float) 16.0 - (float) stereo_frame_ptr->getMinDisparity()) /
-                      ((float) stereo_frame_ptr->getNumDisparities());
-
-
-    cv::imshow("Scaled disparity map", scaled_disp_map);
+    static const std::string window = "Scaled disparity map";
+    if (!preview->wantsFrame(window)) { return; }
+
+    //! Scaled on the preview thread, only the downscaled copy is converted
+    float min_disparity = (float) stereo_frame_ptr->getMinDisparity();
+    float num_disparities = (float) stereo_frame_ptr->getNumDisparities();
+    preview->show(window, is_disp_filterd ? stereo_frame_ptr->getFilteredDispMap()
+                                          : stereo_frame_ptr->getDisparityMap(),
+                  [min_disparity, num_disparities](cv::Mat &image, double) {
+                      cv::Mat scaled_disp_map;
+                      image.convertTo(scaled_disp_map, CV_32F);
+                      scaled_disp_map = (scaled_disp_map / 16.0f - min_disparity) / num_disparities;
+                      return scaled_disp_map;
+                  });
 }
-
-
-
@@ -0,0 +1,231 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Stereo calibration from checkerboard image pairs, writes the YAML read by CameraParam
+// and StereoFrame (config/*_m210_stereo_calib.yaml).
+//
+//   stereo_calibration <left glob> <right glob> <inner corners x> <inner corners y> <square size m>
+//                      <output.yaml> [max pair error px]
+//
+// Left and right images are paired in sorted name order. Corners of every pair are found
+// in parallel, each camera is calibrated on its own (both at once) and the result seeds
+// stereoCalibrate. Pairs above the maximum error are reported, dropped and the stereo
+// calibration is run again without them.
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdio.h>
+
+struct PairCorners {
+    std::string left_file, right_file;
+    std::vector<cv::Point2f> left, right;
+    bool found = false;
+};
+
+struct StereoResult {
+    cv::Mat intrinsic[2], distortion[2];
+    cv::Mat R, T, E, F;
+    double rms = 0;
+    std::vector<double> pair_error; // px, RMS of both images of each pair used
+};
+
+//! Corners of both images of a pair, a pair counts only if the board is seen in both
+void findPairCorners(PairCorners &pair, const cv::Size &board, cv::Size &image_size) {
+    cv::Mat left = cv::imread(pair.left_file, cv::IMREAD_GRAYSCALE);
+    cv::Mat right = cv::imread(pair.right_file, cv::IMREAD_GRAYSCALE);
+    if (left.empty() || right.empty() || left.size() != right.size()) {
+        return;
+    }
+    image_size = left.size();
+    const int flags = cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK;
+    if (!cv::findChessboardCorners(left, board, pair.left, flags) ||
+        !cv::findChessboardCorners(right, board, pair.right, flags)) {
+        return;
+    }
+    const cv::TermCriteria criteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01);
+    cv::cornerSubPix(left, pair.left, cv::Size(5, 5), cv::Size(-1, -1), criteria);
+    cv::cornerSubPix(right, pair.right, cv::Size(5, 5), cv::Size(-1, -1), criteria);
+    pair.found = true;
+}
+
+double projectionError(const std::vector<cv::Point3f> &board, const std::vector<cv::Point2f> &corners,
+                       const cv::Mat &rvec, const cv::Mat &tvec, const cv::Mat &intrinsic, const cv::Mat &distortion) {
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(board, rvec, tvec, intrinsic, distortion, projected);
+    double error = cv::norm(corners, projected, cv::NORM_L2);
+    return error * error;
+}
+
+/** Calibrate left and right on their own in parallel, then the stereo extrinsics with the
+ *  intrinsics as initial guess. The pair error uses the left board pose of the single camera
+ *  calibration carried to the right camera by R, T. */
+StereoResult calibrate(const std::vector<PairCorners *> &pairs, const std::vector<cv::Point3f> &board,
+                       const cv::Size &image_size) {
+    std::vector<std::vector<cv::Point3f>> object_points(pairs.size(), board);
+    std::vector<std::vector<cv::Point2f>> image_points[2];
+    for (const PairCorners *pair : pairs) {
+        image_points[0].push_back(pair->left);
+        image_points[1].push_back(pair->right);
+    }
+
+    StereoResult result;
+    std::vector<cv::Mat> rvecs[2], tvecs[2];
+    std::future<double> single[2];
+    for (int i = 0; i < 2; i++) {
+        single[i] = std::async(std::launch::async, [&, i]() {
+            return cv::calibrateCamera(object_points, image_points[i], image_size, result.intrinsic[i],
+                                       result.distortion[i], rvecs[i], tvecs[i]);
+        });
+    }
+    double single_rms[2] = {single[0].get(), single[1].get()};
+    printf("Single camera RMS: left %.3f px, right %.3f px\n", single_rms[0], single_rms[1]);
+
+    result.rms = cv::stereoCalibrate(object_points, image_points[0], image_points[1],
+                                     result.intrinsic[0], result.distortion[0],
+                                     result.intrinsic[1], result.distortion[1], image_size,
+                                     result.R, result.T, result.E, result.F,
+                                     cv::CALIB_USE_INTRINSIC_GUESS,
+                                     cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-6));
+
+    result.pair_error.resize(pairs.size());
+    cv::parallel_for_(cv::Range(0, (int) pairs.size()), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            cv::Mat left_rot, right_rot, right_rvec;
+            cv::Rodrigues(rvecs[0][i], left_rot);
+            right_rot = result.R * left_rot;
+            cv::Rodrigues(right_rot, right_rvec);
+            cv::Mat right_tvec = result.R * tvecs[0][i] + result.T;
+            double error = projectionError(board, pairs[i]->left, rvecs[0][i], tvecs[0][i],
+                                           result.intrinsic[0], result.distortion[0]) +
+                           projectionError(board, pairs[i]->right, right_rvec, right_tvec,
+                                           result.intrinsic[1], result.distortion[1]);
+            result.pair_error[i] = sqrt(error / (2.0 * board.size()));
+        }
+    });
+    return result;
+}
+
+bool writeCalibration(const std::string &file, const StereoResult &result, const cv::Size &image_size) {
+    cv::Mat rect[2], proj[2], Q;
+    cv::stereoRectify(result.intrinsic[0], result.distortion[0], result.intrinsic[1], result.distortion[1],
+                      image_size, result.R, result.T, rect[0], rect[1], proj[0], proj[1], Q,
+                      cv::CALIB_ZERO_DISPARITY, -1, cv::Size(0, 0));
+
+    cv::FileStorage storage(file, cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        return false;
+    }
+    storage << "leftCameraIntrinsicMatrix" << result.intrinsic[0];
+    storage << "rightCameraIntrinsicMatrix" << result.intrinsic[1];
+    storage << "leftDistCoeffs" << result.distortion[0].reshape(1, (int) result.distortion[0].total());
+    storage << "rightDistCoeffs" << result.distortion[1].reshape(1, (int) result.distortion[1].total());
+    storage << "stereoRotationMatrix" << result.R;
+    storage << "stereoTransVector" << result.T;
+    storage << "leftRectificationMatrix" << rect[0];
+    storage << "rightRectificationMatrix" << rect[1];
+    storage << "leftProjectionMatrix" << proj[0];
+    storage << "rightProjectionMatrix" << proj[1];
+    storage << "stereoRMS" << result.rms;
+    storage.release();
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 7) {
+        std::cerr << "Usage: " << argv[0] << " <left glob> <right glob> <inner corners x> <inner corners y>"
+                  << " <square size m> <output.yaml> [max pair error px]\n";
+        return -1;
+    }
+    const cv::Size board_size(atoi(argv[3]), atoi(argv[4]));
+    const float square = (float) atof(argv[5]);
+    const std::string output = argv[6];
+    const double max_error = argc > 7 ? atof(argv[7]) : 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<cv::String> left_files, right_files;
+    cv::glob(argv[1], left_files);
+    cv::glob(argv[2], right_files);
+    std::sort(left_files.begin(), left_files.end());
+    std::sort(right_files.begin(), right_files.end());
+    if (left_files.empty() || left_files.size() != right_files.size()) {
+        std::cerr << "Found " << left_files.size() << " left and " << right_files.size() << " right images\n";
+        return -1;
+    }
+
+    std::vector<PairCorners> pairs(left_files.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        pairs[i].left_file = left_files[i];
+        pairs[i].right_file = right_files[i];
+    }
+
+    //! One pair per task on every core, results land in their own slot
+    std::vector<cv::Size> sizes(pairs.size());
+    cv::parallel_for_(cv::Range(0, (int) pairs.size()), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            findPairCorners(pairs[i], board_size, sizes[i]);
+        }
+    });
+
+    std::vector<PairCorners *> used;
+    cv::Size image_size;
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (!pairs[i].found) {
+            printf("No board in %s / %s\n", pairs[i].left_file.c_str(), pairs[i].right_file.c_str());
+            continue;
+        }
+        if (image_size.area() == 0) { image_size = sizes[i]; }
+        if (sizes[i] != image_size) {
+            printf("Size mismatch in %s, skipped\n", pairs[i].left_file.c_str());
+            continue;
+        }
+        used.push_back(&pairs[i]);
+    }
+    double detect_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Board found in %zu of %zu pairs (%.2f s, %i threads)\n", used.size(), pairs.size(), detect_time,
+           cv::getNumThreads());
+    if (used.size() < 3) {
+        std::cerr << "Not enough pairs to calibrate\n";
+        return -1;
+    }
+
+    std::vector<cv::Point3f> board;
+    for (int y = 0; y < board_size.height; y++) {
+        for (int x = 0; x < board_size.width; x++) {
+            board.emplace_back(x * square, y * square, 0.f);
+        }
+    }
+
+    StereoResult result = calibrate(used, board, image_size);
+    printf("Stereo RMS %.3f px over %zu pairs\n", result.rms, used.size());
+    for (size_t i = 0; i < used.size(); i++) {
+        printf("  %-40s %.3f px%s\n", used[i]->left_file.c_str(), result.pair_error[i],
+               max_error > 0 && result.pair_error[i] > max_error ? "  (dropped)" : "");
+    }
+
+    if (max_error > 0) {
+        std::vector<PairCorners *> kept;
+        for (size_t i = 0; i < used.size(); i++) {
+            if (result.pair_error[i] <= max_error) { kept.push_back(used[i]); }
+        }
+        if (kept.size() < used.size() && kept.size() >= 3) {
+            result = calibrate(kept, board, image_size);
+            printf("Stereo RMS %.3f px over %zu pairs after dropping %zu\n", result.rms, kept.size(),
+                   used.size() - kept.size());
+        } else if (kept.size() < 3) {
+            printf("Too few pairs under %.3f px, keeping all\n", max_error);
+        }
+    }
+
+    if (!writeCalibration(output, result, image_size)) {
+        std::cerr << "Failed to write " << output << "\n";
+        return -1;
+    }
+    printf("Baseline %.4f m, written to %s in %.2f s\n", cv::norm(result.T), output.c_str(),
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
@@ -12,11 +12,10 @@
 #include <opencv2/ximgproc/disparity_filter.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <mutex>
+#include "stereo_utility/preview_worker.hpp"
 
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/exact_time.h>
-#include <message_filters/sync_policies/approximate_time.h>
+#include "stereo_pair_mailbox.h"
 
 // initialize values for StereoSGBM parameters
 int numDisparities = 2;
@@ -35,6 +34,8 @@ int dispType = CV_16S;
 cv::Ptr<cv::StereoBM> stereo = cv::StereoBM::create();
 cv::Ptr<cv::ximgproc::DisparityWLSFilter> wls_filter;
 cv::Ptr<cv::StereoMatcher> right_matcher = cv::ximgproc::createRightMatcher(stereo);
+//! The trackbars run on the preview thread, the matcher is only touched under this lock
+std::mutex stereo_mutex;
 cv::Mat left_intrinic = (cv::Mat_<double>(3, 3) << 459.15, 0.22858, 319.31, 0, 459.06, 231.4, 0, 0, 1.0000);
 cv::Mat left_dist = (cv::Mat_<double>(5, 1) << 0.041614, -0.031405, 0.0077662, -0.0027449, 0.00023564);
 cv::Mat right_intrinic = (cv::Mat_<double>(3, 3) << 460.4, -0.0056765, 329.22, 0, 460.58, 234.58, 0, 0, 1.0000);
@@ -51,27 +52,39 @@ static const std::string OPENCV_WINDOW_D = "Image D window";
 class ImageConverter {
     ros::NodeHandle nh_;
 
-    message_filters::Subscriber<sensor_msgs::Image> image_left_sub_;
-    message_filters::Subscriber<sensor_msgs::Image> image_right_sub_;
-    typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::Image, sensor_msgs::Image>
-            StereoPolicy;
-    typedef message_filters::Synchronizer<StereoPolicy> Sync;
-    boost::shared_ptr<Sync> sync_;
+    /// Newest left/right pair within 10 ms, processed on the mailbox thread
+    StereoPairMailbox mailbox_;
+    ros::Publisher stats_pub_;
+    ros::WallTimer stats_timer_;
+
+    /// Windows and trackbars, null when headless
+    M210_STEREO::PreviewWorker::Ptr preview_;
 
 public:
     ImageConverter() {
+        bool headless;
+        double preview_rate, preview_scale;
+        nh_.param("/disparity_param/headless", headless, M210_STEREO::PreviewWorker::noDisplay());
+        nh_.param("/disparity_param/preview_rate", preview_rate, 10.0);
+        nh_.param("/disparity_param/preview_scale", preview_scale, 1.0);
+        if (!headless) {
+            //! HighGUI belongs to the preview thread, so the windows and trackbars are created there
+            preview_ = M210_STEREO::PreviewWorker::createPreviewWorker(preview_rate, preview_scale);
+            preview_->setSetup([this]() {
+                cv::namedWindow(OPENCV_WINDOW_S);
+                cv::namedWindow(OPENCV_WINDOW_D);
+                create_trackbars();
+            });
+            preview_->start();
+        }
         initSubscriber(nh_);
-        cv::namedWindow(OPENCV_WINDOW_S);
-        cv::namedWindow(OPENCV_WINDOW_D);
-
-        create_trackbars();
 //        initStereoParam();
 
     }
 
     ~ImageConverter() {
-        cv::destroyWindow(OPENCV_WINDOW_S);
-        cv::destroyWindow(OPENCV_WINDOW_D);
+        mailbox_.stop();
+        preview_.reset();
     }
 
     void create_trackbars() {
@@ -109,11 +122,15 @@ public:
 
     void initSubscriber(ros::NodeHandle &nh) {
         ros::NodeHandle nh_private("~");
-        image_left_sub_.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_left_images", 1);
-        image_right_sub_.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_right_images", 1);
-
-        sync_.reset(new Sync(StereoPolicy(10), image_left_sub_, image_right_sub_));
-        sync_->registerCallback(boost::bind(&ImageConverter::imageCb_disp, this, _1, _2));
+        mailbox_.setMatching(0.01, false);
+        mailbox_.subscribe(nh, "/dji_osdk_ros/stereo_vga_front_left_images",
+                           "/dji_osdk_ros/stereo_vga_front_right_images");
+        mailbox_.start(boost::bind(&ImageConverter::imageCb_disp, this, _1, _2));
+
+        stats_pub_ = nh.advertise<riser_inspection::StereoPipelineStats>("/disparity_param/pipeline_stats", 1);
+        stats_timer_ = nh.createWallTimer(ros::WallDuration(1.0), [this](const ros::WallTimerEvent &) {
+            stats_pub_.publish(mailbox_.getStats());
+        });
     }
 
 
@@ -152,8 +169,12 @@ public:
                                     rectified_mapping1, rectified_mapping2);
         cv::remap(imgR_grey, img_rect_R, rectified_mapping1, rectified_mapping2, cv::INTER_LINEAR);
 
-        stereo->compute(img_rect_L,img_rect_R,stereoBM_disp);
-        stereo->compute(img_rect_L,img_rect_R,stereoBM_16_disp);
+        {
+            std::lock_guard<std::mutex> lock(stereo_mutex);
+            stereo->compute(img_rect_L, img_rect_R, stereoBM_disp);
+        }
+        stereoBM_16_disp = stereoBM_disp.clone();
+        if (!preview_ || !preview_->wantsFrame(OPENCV_WINDOW_D)) { return; }
 
         stereoBM_disp.convertTo(stereoBM_disp, CV_32F, 0.01);
         stereoBM_16_disp.convertTo(stereoBM_16_disp, CV_16S, 10);
@@ -186,75 +207,84 @@ public:
 //        cv::imshow(OPENCV_WINDOW_D, stereoBM_16_disp);
         view_stereo_images(img_rect_L, img_rect_R, OPENCV_WINDOW_S, true);
         view_stereo_images(stereoBM_disp, stereoBM_16_disp, OPENCV_WINDOW_D, false);
-
-        cv::waitKey(3);
     }
 
     void view_stereo_images(cv::Mat image1, cv::Mat image2, std::string win_name, bool rect_image) {
         cv::Mat image_to_show;
         cv::hconcat(image1, image2, image_to_show);
 
-        cv::resize(image_to_show, image_to_show,
-                   cv::Size(image1.cols * 2, image1.rows),
-                   (0, 0), (0, 0), cv::INTER_LINEAR);
-        if(rect_image){
-            for (int j = 0; j < image_to_show.rows; j += 24) {
-                line(image_to_show, cv::Point(0, j),
-                     cv::Point(image_to_show.cols, j),
-                     cv::Scalar(255, 0, 0, 255), 1, 8);
+        //! Epipolar lines are drawn by the preview thread on the downscaled copy
+        preview_->show(win_name, image_to_show, [rect_image](cv::Mat &image, double scale) {
+            if (rect_image) {
+                for (int j = 0; j < image.rows; j += std::max(1, (int) (24 * scale))) {
+                    line(image, cv::Point(0, j),
+                         cv::Point(image.cols, j),
+                         cv::Scalar(255, 0, 0, 255), 1, 8);
+                }
             }
-        }
-        cv::imshow(win_name, image_to_show);
+            return image;
+        });
     }
     // Defining callback functions for the trackbars to update parameter values
 
 
     static void on_trackbar1(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setNumDisparities(numDisparities * 16);
         numDisparities = numDisparities * 16;
     }
 
     static void on_trackbar2(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setBlockSize(blockSize * 2 + 5);
         blockSize = blockSize * 2 + 5;
     }
 
     static void on_trackbar3(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setPreFilterType(preFilterType);
     }
 
     static void on_trackbar4(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setPreFilterSize(preFilterSize * 2 + 5);
         preFilterSize = preFilterSize * 2 + 5;
     }
 
     static void on_trackbar5(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setPreFilterCap(preFilterCap);
     }
 
     static void on_trackbar6(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setTextureThreshold(textureThreshold);
     }
 
 
     static void on_trackbar7(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setUniquenessRatio(uniquenessRatio);
     }
 
     static void on_trackbar8(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setSpeckleRange(speckleRange);
     }
 
     static void on_trackbar9(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setSpeckleWindowSize(speckleWindowSize * 2);
         speckleWindowSize = speckleWindowSize * 2;
     }
 
     static void on_trackbar10(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setDisp12MaxDiff(disp12MaxDiff);
     }
 
     static void on_trackbar11(int, void *) {
+        std::lock_guard<std::mutex> lock(stereo_mutex);
         stereo->setMinDisparity(minDisparity);
     }
 
@@ -0,0 +1,250 @@
+//
+// Created by vant3d on 19/10/2026.
+//
+// Full quality reprocessing of recorded stereo flights (black box ring files) on a ground
+// workstation: rectification, StereoBM, WLS filter, sector distances and optionally point
+// clouds for every recorded pair, not only what the aircraft managed at 20 Hz.
+//
+//   stereo_reprocess <calibration.yaml> <output dir> <ring file>... [--threads N] [--clouds]
+//                    [--sectors COLS ROWS]
+//
+// Every worker owns a StereoFrame (its own maps, matcher and filter) and a ProximityGuard.
+// Frames are dealt round robin to per-worker queues, an idle worker steals from the others,
+// and results are committed in frame order to a dataset (see dataset_store.h):
+//
+//   <output dir>/chunk_*.rds, index.rds   rectified left + filtered CV_16S disparity per frame
+//   <output dir>/distances.txt            frame, stamp, nearest depth of every sector (m)
+//   <output dir>/Q.yaml                   disparity-to-depth mapping of the calibration
+//   <output dir>/cloud_NNNNNN.ply         with --clouds, points of valid disparity (m)
+//
+
+#include "stereo_utility/stereo_frame.hpp"
+#include "stereo_utility/config.hpp"
+#include "stereo_utility/camera_param.hpp"
+#include "stereo_utility/proximity_guard.hpp"
+#include "stereo_utility/raw_stereo_ring.hpp"
+#include <dataset_store.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace M210_STEREO;
+
+struct FrameRef {
+    size_t reader;
+    size_t index;
+};
+
+/// Per-worker queues of frame numbers, a worker takes its own oldest frame or steals another's
+class WorkStealingQueues {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> frames;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+
+public:
+    WorkStealingQueues(size_t workers, size_t frames) {
+        for (size_t i = 0; i < workers; i++) { queues.emplace_back(new Queue()); }
+        //! Round robin keeps every worker close to the commit point, the reorder window stays small
+        for (size_t i = 0; i < frames; i++) { queues[i % workers]->frames.push_back(i); }
+    }
+
+    bool next(size_t worker, size_t &frame) {
+        for (size_t k = 0; k < queues.size(); k++) {
+            Queue &queue = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.frames.empty()) {
+                //! Oldest first also when stealing, the commit point waits on the oldest frames
+                frame = queue.frames.front();
+                queue.frames.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/// Results wait here until every earlier frame is done, then go out in frame order
+class OrderedCommit {
+private:
+    std::mutex mutex;
+    std::condition_variable advanced;
+    std::map<size_t, DatasetFrame> waiting;
+    std::map<size_t, std::vector<float>> waiting_sectors;
+    size_t next_frame = 0;
+    size_t window;
+    DatasetWriter &writer;
+    std::ofstream &distances;
+
+public:
+    OrderedCommit(size_t window_size, DatasetWriter &dataset, std::ofstream &distance_file)
+            : window(window_size), writer(dataset), distances(distance_file) {}
+
+    //! Blocks a worker that runs more than window frames ahead, bounding the memory held
+    void waitTurn(size_t frame) {
+        std::unique_lock<std::mutex> lock(mutex);
+        advanced.wait(lock, [&]() { return frame < next_frame + window; });
+    }
+
+    void commit(size_t frame, DatasetFrame &&result, std::vector<float> &&sectors) {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting[frame] = std::move(result);
+        waiting_sectors[frame] = std::move(sectors);
+        while (!waiting.empty() && waiting.begin()->first == next_frame) {
+            DatasetFrame &ready = waiting.begin()->second;
+            distances << next_frame << "\t" << std::setprecision(17) << ready.header.stamp << std::setprecision(4);
+            for (float depth : waiting_sectors.begin()->second) { distances << "\t" << depth; }
+            distances << "\n";
+            writer.push(std::move(ready), true);
+            waiting.erase(waiting.begin());
+            waiting_sectors.erase(waiting_sectors.begin());
+            next_frame++;
+        }
+        advanced.notify_all();
+    }
+};
+
+bool writeCloud(const std::string &file, const cv::Mat &disparity, const cv::Mat &Q) {
+    cv::Mat disparity_px, points;
+    disparity.convertTo(disparity_px, CV_32F, 1.0 / 16.0);
+    cv::reprojectImageTo3D(disparity_px, points, Q, true);
+    std::vector<cv::Vec3f> valid;
+    valid.reserve(points.total());
+    for (int v = 0; v < points.rows; v++) {
+        const cv::Vec3f *row = points.ptr<cv::Vec3f>(v);
+        const float *d = disparity_px.ptr<float>(v);
+        for (int u = 0; u < points.cols; u++) {
+            if (d[u] > 0 && std::isfinite(row[u][2])) { valid.push_back(row[u]); }
+        }
+    }
+    std::ofstream ply(file, std::ios::binary);
+    if (!ply) { return false; }
+    ply << "ply\nformat binary_little_endian 1.0\nelement vertex " << valid.size()
+        << "\nproperty float x\nproperty float y\nproperty float z\nend_header\n";
+    ply.write((const char *) valid.data(), (std::streamsize) (valid.size() * sizeof(cv::Vec3f)));
+    return (bool) ply;
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> ring_files;
+    int threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    int sector_cols = 5, sector_rows = 3;
+    bool clouds = false;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--clouds") {
+            clouds = true;
+        } else if (arg == "--sectors" && i + 2 < argc) {
+            sector_cols = atoi(argv[++i]);
+            sector_rows = atoi(argv[++i]);
+        } else {
+            ring_files.push_back(arg);
+        }
+    }
+    if (argc < 4 || ring_files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <calibration.yaml> <output dir> <ring file>... [--threads N]"
+                  << " [--clouds] [--sectors COLS ROWS]\n";
+        return -1;
+    }
+    const std::string output = argv[2];
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<RawStereoRingReader::Ptr> readers;
+    std::vector<FrameRef> frames;
+    for (const std::string &file : ring_files) {
+        RawStereoRingReader::Ptr reader = RawStereoRingReader::createRawStereoRingReader(file);
+        if (!reader) {
+            std::cerr << "Cannot read " << file << "\n";
+            return -1;
+        }
+        const RawRingHeader &header = reader->getHeader();
+        if (header.width != (uint32_t) VGA_WIDTH || header.height != (uint32_t) VGA_HEIGHT) {
+            std::cerr << file << " is not VGA\n";
+            return -1;
+        }
+        for (size_t i = 0; i < reader->size(); i++) { frames.push_back({readers.size(), i}); }
+        readers.push_back(reader);
+    }
+
+    //! Config reads a shared FileStorage, so every worker state is built here before any thread
+    Config::setParamFile(argv[1]);
+    CameraParam::Ptr camera_left = CameraParam::createCameraParam(CameraParam::FRONT_LEFT);
+    CameraParam::Ptr camera_right = CameraParam::createCameraParam(CameraParam::FRONT_RIGHT);
+    threads = (int) std::min<size_t>((size_t) threads, std::max<size_t>(frames.size(), 1));
+    std::vector<StereoFrame::Ptr> stereo_frames;
+    std::vector<ProximityGuard::Ptr> guards;
+    for (int i = 0; i < threads; i++) {
+        stereo_frames.push_back(StereoFrame::createStereoFrame(camera_left, camera_right));
+        guards.push_back(ProximityGuard::createProximityGuard(sector_cols, sector_rows));
+    }
+    //! Frame level parallelism, OpenCV's own threads inside every worker would oversubscribe the cores
+    if (threads > 1) { cv::setNumThreads(1); }
+
+    DatasetWriter writer;
+    if (!writer.open(output, 256, (size_t) threads * 2)) { return -1; }
+    std::ofstream distances(output + "/distances.txt");
+    distances << "# frame\tstamp\tdepth per sector, " << sector_cols << "x" << sector_rows << " row major (m)\n";
+    cv::FileStorage q_file(output + "/Q.yaml", cv::FileStorage::WRITE);
+    q_file << "Q" << stereo_frames[0]->getQ();
+    q_file.release();
+
+    WorkStealingQueues queues((size_t) threads, frames.size());
+    OrderedCommit commit((size_t) threads * 4, writer, distances);
+    std::atomic<size_t> done(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; w++) {
+        workers.emplace_back([&, w]() {
+            StereoFrame &stereo = *stereo_frames[w];
+            size_t frame;
+            while (queues.next((size_t) w, frame)) {
+                commit.waitTurn(frame);
+                cv::Mat left, right;
+                RawRingSlot slot;
+                readers[frames[frame].reader]->read(frames[frame].index, left, right, slot);
+                const uint32_t nsec = (uint32_t) ((slot.stamp_left - floor(slot.stamp_left)) * 1e9);
+                stereo.readStereoImgs(left, right, frame, nsec);
+                stereo.rectifyImgs();
+                stereo.computeDisparityMap();
+                stereo.filterDisparityMap();
+
+                DatasetFrame result;
+                result.header.stamp = slot.stamp_left;
+                //! The frame's buffers are reused for the next pair, the result keeps copies
+                result.image = stereo.getRectLeftImg().clone();
+                result.disparity = stereo.getRawFilteredDispMap().clone();
+                std::vector<float> sectors = guards[w]->compute(result.disparity, stereo.getQ());
+                if (clouds) {
+                    char name[32];
+                    snprintf(name, sizeof(name), "/cloud_%06zu.ply", frame);
+                    writeCloud(output + name, result.disparity, stereo.getQ());
+                }
+                commit.commit(frame, std::move(result), std::move(sectors));
+                size_t finished = ++done;
+                if (finished % 500 == 0) {
+                    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    printf("%zu / %zu frames, %.1f frames/s\n", finished, frames.size(), finished / elapsed);
+                }
+            }
+        });
+    }
+    for (std::thread &worker : workers) { worker.join(); }
+    writer.close();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu frames from %zu files in %.1f s (%.1f frames/s, %i threads), %lu written to %s\n",
+           frames.size(), readers.size(), elapsed, frames.size() / std::max(elapsed, 1e-9), threads,
+           (unsigned long) writer.getWritten(), output.c_str());
+    return writer.getWritten() == frames.size() ? 0 : -1;
+}
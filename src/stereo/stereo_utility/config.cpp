@@ -35,6 +35,7 @@ void M210_STEREO::Config::setParamFile(const std::string& file_name)
     }
 
     Config::instancePtr()->file_ = cv::FileStorage( file_name, cv::FileStorage::READ );
+    Config::instancePtr()->file_name_ = file_name;
 
     if(!Config::instancePtr()->file_.isOpened())
     {
@@ -0,0 +1,238 @@
+#include "stereo_utility/cylinder_fitter.hpp"
+#include <opencv2/core/hal/intrin.hpp>
+
+M210_STEREO::CylinderFitter::CylinderFitter() : rng_(std::random_device{}()) {
+}
+
+M210_STEREO::CylinderFitter::~CylinderFitter() {
+
+}
+
+M210_STEREO::CylinderFitter::Ptr
+M210_STEREO::CylinderFitter::createCylinderFitter() {
+    return std::make_shared<CylinderFitter>();
+}
+
+/** Reproject the valid disparities of every stride-th row. With the Q of stereoRectify
+ *  the reprojection reduces to X = (u + Q03) / W, Y = (v + Q13) / W, Z = Q23 / W with
+ *  W = Q32 * d + Q33, evaluated four pixels at a time. */
+void
+M210_STEREO::CylinderFitter::reprojectPoints(const cv::Mat &raw_disparity, const cv::Mat &Q, const cv::Rect &roi) {
+    px_.clear();
+    py_.clear();
+    pz_.clear();
+
+    cv::Mat_<double> q;
+    Q.convertTo(q, CV_64F);
+    const float q03 = (float) q(0, 3), q13 = (float) q(1, 3), q23 = (float) q(2, 3);
+    const float q32 = (float) q(3, 2), q33 = (float) q(3, 3);
+    //! Sign of the baseline, so Z comes out positive in front of the camera
+    const float sign = q23 * q32 >= 0 ? 1.f : -1.f;
+
+    cv::Rect area = roi.area() > 0 ? roi & cv::Rect(0, 0, raw_disparity.cols, raw_disparity.rows)
+                                   : cv::Rect(0, 0, raw_disparity.cols, raw_disparity.rows);
+    float tmp_x[4], tmp_y[4], tmp_z[4], tmp_d[4];
+
+    for (int v = area.y; v < area.y + area.height; v += stride_) {
+        const short *row = raw_disparity.ptr<short>(v);
+        int u = area.x;
+        const int u_end = area.x + area.width;
+#if CV_SIMD128
+        const cv::v_float32x4 v_scale = cv::v_setall_f32(1.f / 16.f);
+        const cv::v_float32x4 v_q32 = cv::v_setall_f32(q32), v_q33 = cv::v_setall_f32(q33);
+        const cv::v_float32x4 v_q23 = cv::v_setall_f32(q23 * sign);
+        const cv::v_float32x4 v_y = cv::v_setall_f32(((float) v + q13) * sign);
+        const cv::v_float32x4 v_one = cv::v_setall_f32(1.f);
+        for (; u + 8 <= u_end; u += 8) {
+            cv::v_int32x4 d_lo, d_hi;
+            cv::v_expand(cv::v_load(row + u), d_lo, d_hi);
+            for (int half = 0; half < 2; half++) {
+                int u0 = u + half * 4;
+                cv::v_float32x4 d = cv::v_cvt_f32(half == 0 ? d_lo : d_hi) * v_scale;
+                cv::v_float32x4 inv_w = v_one / (d * v_q32 + v_q33);
+                cv::v_float32x4 cols((float) u0, (float) u0 + 1, (float) u0 + 2, (float) u0 + 3);
+                cv::v_store(tmp_x, (cols + cv::v_setall_f32(q03)) * cv::v_setall_f32(sign) * inv_w);
+                cv::v_store(tmp_y, v_y * inv_w);
+                cv::v_store(tmp_z, v_q23 * inv_w);
+                cv::v_store(tmp_d, d);
+                for (int k = 0; k < 4; k++) {
+                    if (tmp_d[k] > 0 && tmp_z[k] > min_depth_ && tmp_z[k] < max_depth_) {
+                        px_.push_back(tmp_x[k]);
+                        py_.push_back(tmp_y[k]);
+                        pz_.push_back(tmp_z[k]);
+                    }
+                }
+            }
+        }
+#endif
+        for (; u < u_end; u++) {
+            float d = (float) row[u] / 16.f;
+            if (d <= 0) { continue; }
+            float inv_w = sign / (d * q32 + q33);
+            float z = q23 * inv_w;
+            if (z > min_depth_ && z < max_depth_) {
+                px_.push_back(((float) u + q03) * inv_w);
+                py_.push_back(((float) v + q13) * inv_w);
+                pz_.push_back(z);
+            }
+        }
+    }
+}
+
+/** Vertical riser: camera down axis. Inclined riser: principal direction of the points,
+ *  accepted only if it clearly dominates, otherwise a short section falls back to vertical. */
+cv::Vec3f
+M210_STEREO::CylinderFitter::estimateAxis() {
+    cv::Vec3f vertical(0, 1, 0);
+    if (!inclined_axis_ || px_.size() < 10) { return vertical; }
+
+    const int n = (int) px_.size();
+    cv::Vec3d mean(0, 0, 0);
+    for (int i = 0; i < n; i++) { mean += cv::Vec3d(px_[i], py_[i], pz_[i]); }
+    mean /= (double) n;
+    cv::Mat cov = cv::Mat::zeros(3, 3, CV_64F);
+    for (int i = 0; i < n; i++) {
+        cv::Vec3d p = cv::Vec3d(px_[i], py_[i], pz_[i]) - mean;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) { cov.at<double>(r, c) += p[r] * p[c]; }
+        }
+    }
+    cv::Mat eigen_values, eigen_vectors;
+    cv::eigen(cov, eigen_values, eigen_vectors);
+    if (eigen_values.at<double>(0) < 2 * eigen_values.at<double>(1)) { return vertical; }
+
+    cv::Vec3f axis((float) eigen_vectors.at<double>(0, 0), (float) eigen_vectors.at<double>(0, 1),
+                   (float) eigen_vectors.at<double>(0, 2));
+    if (axis[1] < 0) { axis = -axis; }
+    return cv::normalize(axis);
+}
+
+void
+M210_STEREO::CylinderFitter::projectToPlane(const cv::Vec3f &axis) {
+    //! v along the camera forward direction, u to the side, both normal to the axis
+    cv::Vec3f forward(0, 0, 1);
+    plane_v_ = cv::normalize(forward - axis * forward.dot(axis));
+    plane_u_ = axis.cross(plane_v_);
+
+    const int n = (int) px_.size();
+    u_.resize(n);
+    v_.resize(n);
+    for (int i = 0; i < n; i++) {
+        u_[i] = px_[i] * plane_u_[0] + py_[i] * plane_u_[1] + pz_[i] * plane_u_[2];
+        v_[i] = px_[i] * plane_v_[0] + py_[i] * plane_v_[1] + pz_[i] * plane_v_[2];
+    }
+}
+
+//! Number of points within inlier_threshold_ of the circle, the RANSAC hot loop
+int
+M210_STEREO::CylinderFitter::countInliers(float cx, float cy, float r) {
+    const int n = (int) u_.size();
+    int i = 0, count = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 v_cx = cv::v_setall_f32(cx), v_cy = cv::v_setall_f32(cy);
+    const cv::v_float32x4 v_r = cv::v_setall_f32(r), v_t = cv::v_setall_f32(inlier_threshold_);
+    cv::v_int32x4 acc = cv::v_setall_s32(0);
+    for (; i + 4 <= n; i += 4) {
+        cv::v_float32x4 du = cv::v_load(&u_[i]) - v_cx;
+        cv::v_float32x4 dv = cv::v_load(&v_[i]) - v_cy;
+        cv::v_float32x4 dist = cv::v_sqrt(du * du + dv * dv);
+        //! Mask lanes are all ones, i.e. -1 as integers
+        acc = acc + cv::v_reinterpret_as_s32(cv::v_abs(dist - v_r) < v_t);
+    }
+    count = -cv::v_reduce_sum(acc);
+#endif
+    for (; i < n; i++) {
+        float du = u_[i] - cx, dv = v_[i] - cy;
+        if (fabs(sqrt(du * du + dv * dv) - r) < inlier_threshold_) { count++; }
+    }
+    return count;
+}
+
+//! Gauss-Newton on the geometric distance of the current inliers
+bool
+M210_STEREO::CylinderFitter::refineCircle(float &cx, float &cy, float &r, float &rms, int &inliers) {
+    const int n = (int) u_.size();
+    for (int iteration = 0; iteration < 5; iteration++) {
+        cv::Mat JtJ = cv::Mat::zeros(3, 3, CV_64F);
+        cv::Mat Jtr = cv::Mat::zeros(3, 1, CV_64F);
+        double sum_sq = 0;
+        int used = 0;
+        for (int i = 0; i < n; i++) {
+            double du = u_[i] - cx, dv = v_[i] - cy;
+            double dist = sqrt(du * du + dv * dv);
+            double res = dist - r;
+            if (fabs(res) >= inlier_threshold_ || dist < 1e-6) { continue; }
+            double J[3] = {-du / dist, -dv / dist, -1};
+            for (int row = 0; row < 3; row++) {
+                for (int col = 0; col < 3; col++) { JtJ.at<double>(row, col) += J[row] * J[col]; }
+                Jtr.at<double>(row) += J[row] * res;
+            }
+            sum_sq += res * res;
+            used++;
+        }
+        if (used < 3) { return false; }
+        cv::Mat step;
+        if (!cv::solve(JtJ, -Jtr, step, cv::DECOMP_CHOLESKY)) { return false; }
+        cx += (float) step.at<double>(0);
+        cy += (float) step.at<double>(1);
+        r += (float) step.at<double>(2);
+        rms = (float) sqrt(sum_sq / used);
+        inliers = used;
+        if (cv::norm(step) < 1e-4) { break; }
+    }
+    return r >= min_radius_ && r <= max_radius_;
+}
+
+M210_STEREO::CylinderModel
+M210_STEREO::CylinderFitter::fit(const cv::Mat &raw_disparity, const cv::Mat &Q, const cv::Rect &roi) {
+    int64 start = cv::getTickCount();
+    CylinderModel model;
+
+    reprojectPoints(raw_disparity, Q, roi);
+    const int n = (int) px_.size();
+    if (n < 30) {
+        fit_time_ = (double) (cv::getTickCount() - start) / cv::getTickFrequency();
+        return model;
+    }
+    cv::Vec3f axis = estimateAxis();
+    projectToPlane(axis);
+
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    float best_cx = 0, best_cy = 0, best_r = 0;
+    int best_count = 0;
+    for (int iteration = 0; iteration < iterations_; iteration++) {
+        int a = pick(rng_), b = pick(rng_), c = pick(rng_);
+        //! Circumcircle of the three samples
+        float ax = u_[a], ay = v_[a], bx = u_[b], by = v_[b], qx = u_[c], qy = v_[c];
+        float det = 2 * (ax * (by - qy) + bx * (qy - ay) + qx * (ay - by));
+        if (fabs(det) < 1e-9f) { continue; }
+        float a2 = ax * ax + ay * ay, b2 = bx * bx + by * by, c2 = qx * qx + qy * qy;
+        float cx = (a2 * (by - qy) + b2 * (qy - ay) + c2 * (ay - by)) / det;
+        float cy = (a2 * (qx - bx) + b2 * (ax - qx) + c2 * (bx - ax)) / det;
+        float r = sqrt((ax - cx) * (ax - cx) + (ay - cy) * (ay - cy));
+        //! Only the near side of the riser is visible, its axis lies behind the samples
+        if (r < min_radius_ || r > max_radius_ || cy < (ay + by + qy) / 3) { continue; }
+        int count = countInliers(cx, cy, r);
+        if (count > best_count) {
+            best_count = count;
+            best_cx = cx;
+            best_cy = cy;
+            best_r = r;
+        }
+    }
+
+    float rms = 0;
+    int inliers = best_count;
+    if (best_count >= 30 && refineCircle(best_cx, best_cy, best_r, rms, inliers)) {
+        cv::Vec3f centre = plane_u_ * best_cx + plane_v_ * best_cy;
+        model.axis_point = cv::Point3f(centre[0], centre[1], centre[2]);
+        model.axis_direction = axis;
+        model.radius = best_r;
+        model.distance = (float) cv::norm(centre) - best_r;
+        model.rms = rms;
+        model.inliers = inliers;
+        model.valid = true;
+    }
+    fit_time_ = (double) (cv::getTickCount() - start) / cv::getTickFrequency();
+    return model;
+}
@@ -0,0 +1,104 @@
+#include "stereo_utility/preview_worker.hpp"
+
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+M210_STEREO::PreviewWorker::PreviewWorker(double rate, double scale)
+        : period_(rate > 0 ? 1.0 / rate : 0), scale_(std::min(1.0, std::max(0.05, scale))), running_(false) {
+}
+
+M210_STEREO::PreviewWorker::~PreviewWorker() {
+    stop();
+}
+
+M210_STEREO::PreviewWorker::Ptr
+M210_STEREO::PreviewWorker::createPreviewWorker(double rate, double scale) {
+    return std::make_shared<PreviewWorker>(rate, scale);
+}
+
+bool
+M210_STEREO::PreviewWorker::noDisplay() {
+    const char *display = std::getenv("DISPLAY");
+    return display == nullptr || display[0] == '\0';
+}
+
+void
+M210_STEREO::PreviewWorker::start() {
+    if (running_) { return; }
+    running_ = true;
+    thread_ = std::thread(&PreviewWorker::run, this);
+}
+
+void
+M210_STEREO::PreviewWorker::stop() {
+    if (!running_) { return; }
+    running_ = false;
+    frame_ready_.notify_all();
+    if (thread_.joinable()) { thread_.join(); }
+}
+
+bool
+M210_STEREO::PreviewWorker::wantsFrame(const std::string &window) {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    auto slot = slots_.find(window);
+    if (slot == slots_.end()) { return running_; }
+    return running_ && std::chrono::duration<double>(clock::now() - slot->second.last).count() >= period_;
+}
+
+bool
+M210_STEREO::PreviewWorker::show(const std::string &window, const cv::Mat &image, Render render) {
+    if (!running_ || image.empty() || !wantsFrame(window)) { return false; }
+
+    //! Downscale outside the lock, the preview thread only ever sees the small copy
+    cv::Mat small;
+    if (scale_ < 1.0) {
+        cv::resize(image, small, cv::Size(), scale_, scale_, cv::INTER_NEAREST);
+    } else {
+        small = image.clone();
+    }
+
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    Slot &slot = slots_[window];
+    slot.image = small;
+    slot.render = render;
+    slot.last = clock::now();
+    slot.fresh = true;
+    frame_ready_.notify_one();
+    return true;
+}
+
+void
+M210_STEREO::PreviewWorker::run() {
+#ifdef __linux__
+    //! Lowest priority for this thread only, the stereo pipeline always wins the CPU
+    setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), 19);
+#endif
+    if (setup_) { setup_(); }
+
+    std::vector<std::pair<std::string, Slot>> pending;
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(slots_mutex_);
+            //! Wake up regularly anyway, waitKey keeps the windows and trackbars responsive
+            frame_ready_.wait_for(lock, std::chrono::milliseconds(30));
+            for (auto &slot : slots_) {
+                if (!slot.second.fresh) { continue; }
+                pending.emplace_back(slot.first, slot.second);
+                slot.second.fresh = false;
+                slot.second.image.release();
+            }
+        }
+        for (auto &frame : pending) {
+            cv::Mat to_show = frame.second.render ? frame.second.render(frame.second.image, scale_)
+                                                  : frame.second.image;
+            if (!to_show.empty()) { cv::imshow(frame.first, to_show); }
+        }
+        pending.clear();
+        cv::waitKey(1);
+    }
+    cv::destroyAllWindows();
+}
@@ -0,0 +1,65 @@
+#include "stereo_utility/proximity_guard.hpp"
+
+M210_STEREO::ProximityGuard::ProximityGuard(int cols, int rows)
+        : cols_(std::max(1, cols)), rows_(std::max(1, rows)),
+          histogram_((size_t) std::max(1, cols) * std::max(1, rows) * DISPARITY_BINS, 0) {
+}
+
+M210_STEREO::ProximityGuard::~ProximityGuard() {
+
+}
+
+M210_STEREO::ProximityGuard::Ptr
+M210_STEREO::ProximityGuard::createProximityGuard(int cols, int rows) {
+    return std::make_shared<ProximityGuard>(cols, rows);
+}
+
+std::vector<float>
+M210_STEREO::ProximityGuard::compute(const cv::Mat &raw_disparity, const cv::Mat &Q) {
+    int64 start = cv::getTickCount();
+    const int width = raw_disparity.cols, height = raw_disparity.rows;
+    const int n_sectors = cols_ * rows_;
+    std::fill(histogram_.begin(), histogram_.end(), 0);
+
+    //! Each band of rows fills a private histogram and merges it once
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range &range) {
+        std::vector<int> local((size_t) n_sectors * DISPARITY_BINS, 0);
+        for (int v = range.start; v < range.end; v++) {
+            const short *row = raw_disparity.ptr<short>(v);
+            int *row_hist = &local[(size_t) (v * rows_ / height) * cols_ * DISPARITY_BINS];
+            for (int u = 0; u < width; u++) {
+                //! Negative or zero is unmatched, 4 fractional bits
+                if (row[u] <= 0) { continue; }
+                int bin = std::min(row[u] >> 4, DISPARITY_BINS - 1);
+                row_hist[(u * cols_ / width) * DISPARITY_BINS + bin]++;
+            }
+        }
+        std::lock_guard<std::mutex> lock(histogram_mutex_);
+        for (size_t k = 0; k < local.size(); k++) { histogram_[k] += local[k]; }
+    }, std::max(1, height / 32));
+
+    cv::Mat_<double> q;
+    Q.convertTo(q, CV_64F);
+    const double q23 = q(2, 3), q32 = q(3, 2), q33 = q(3, 3);
+    const double sign = q23 * q32 >= 0 ? 1 : -1;
+
+    std::vector<float> distances((size_t) n_sectors, max_depth_);
+    for (int s = 0; s < n_sectors; s++) {
+        const int *hist = &histogram_[(size_t) s * DISPARITY_BINS];
+        int count = 0;
+        for (int bin = DISPARITY_BINS - 1; bin > 0; bin--) {
+            count += hist[bin];
+            if (count < min_pixels_) { continue; }
+            //! Upper edge of the bin, errs on the near side
+            double depth = sign * q23 / (q32 * (bin + 1) + q33);
+            if (depth < min_depth_) {
+                count = 0;
+                continue;
+            }
+            distances[s] = (float) std::min(depth, (double) max_depth_);
+            break;
+        }
+    }
+    compute_time_ = (double) (cv::getTickCount() - start) / cv::getTickFrequency();
+    return distances;
+}
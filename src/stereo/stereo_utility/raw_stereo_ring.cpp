@@ -0,0 +1,169 @@
+#include "stereo_utility/raw_stereo_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    size_t pageAlign(size_t bytes) {
+        return (bytes + M210_STEREO::RAW_RING_PAGE - 1) / M210_STEREO::RAW_RING_PAGE * M210_STEREO::RAW_RING_PAGE;
+    }
+}
+
+M210_STEREO::RawStereoRing::RawStereoRing() : frozen_(false), flushing_(false) {
+}
+
+M210_STEREO::RawStereoRing::~RawStereoRing() {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        if (flusher_.joinable()) { flusher_.join(); }
+    }
+    if (map_) {
+        msync(map_, map_bytes_, MS_SYNC);
+        munmap(map_, map_bytes_);
+    }
+    if (fd_ >= 0) { close(fd_); }
+}
+
+M210_STEREO::RawStereoRing::Ptr
+M210_STEREO::RawStereoRing::createRawStereoRing(const std::string &file, size_t slots, int width, int height) {
+    Ptr ring = std::make_shared<RawStereoRing>();
+    if (!ring->open(file, slots, width, height)) { return nullptr; }
+    return ring;
+}
+
+bool M210_STEREO::RawStereoRing::open(const std::string &file, size_t slots, int width, int height) {
+    slots_ = std::max<size_t>(slots, 1);
+    image_bytes_ = (size_t) width * height;
+    slot_bytes_ = pageAlign(sizeof(RawRingSlot) + 2 * image_bytes_);
+    map_bytes_ = RAW_RING_PAGE + slots_ * slot_bytes_;
+
+    fd_ = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Cannot create " << file << "\n";
+        return false;
+    }
+    //! Real blocks now, a full disk shows up here and not as SIGBUS in flight
+    if (posix_fallocate(fd_, 0, (off_t) map_bytes_) != 0) {
+        std::cerr << "Cannot allocate " << (map_bytes_ >> 20) << " MB for " << file << "\n";
+        return false;
+    }
+    int flags = MAP_SHARED;
+#ifdef __linux__
+    //! Fault every page in up front, the first lap of the ring must not page fault
+    flags |= MAP_POPULATE;
+#endif
+    void *map = mmap(nullptr, map_bytes_, PROT_READ | PROT_WRITE, flags, fd_, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Cannot map " << file << "\n";
+        return false;
+    }
+    map_ = (uint8_t *) map;
+    header_ = (RawRingHeader *) map_;
+    header_->magic = RAW_RING_MAGIC;
+    header_->version = 1;
+    header_->width = (uint32_t) width;
+    header_->height = (uint32_t) height;
+    header_->slots = slots_;
+    header_->slot_bytes = slot_bytes_;
+    header_->written = 0;
+    return true;
+}
+
+bool M210_STEREO::RawStereoRing::write(const uint8_t *left, const uint8_t *right, double stamp_left,
+                                       double stamp_right, uint32_t seq_left, uint32_t seq_right) {
+    if (frozen_ || map_ == nullptr) { return false; }
+    const uint64_t sequence = header_->written + 1;
+    uint8_t *slot_start = map_ + RAW_RING_PAGE + (size_t) ((sequence - 1) % slots_) * slot_bytes_;
+    RawRingSlot *slot = (RawRingSlot *) slot_start;
+
+    //! Invalidate, fill, then publish the sequence, a reader of the mapping never sees a half written pair.
+    //! The fences order the stores in memory, not their writeback to disk, flush() covers that.
+    slot->sequence = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->stamp_left = stamp_left;
+    slot->stamp_right = stamp_right;
+    slot->seq_left = seq_left;
+    slot->seq_right = seq_right;
+    memcpy(slot_start + sizeof(RawRingSlot), left, image_bytes_);
+    memcpy(slot_start + sizeof(RawRingSlot) + image_bytes_, right, image_bytes_);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->sequence = sequence;
+    header_->written = sequence;
+    return true;
+}
+
+void M210_STEREO::RawStereoRing::flush() {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    if (flushing_ || map_ == nullptr) { return; }
+    if (flusher_.joinable()) { flusher_.join(); }
+    flushing_ = true;
+    flusher_ = std::thread([this]() {
+        msync(map_, map_bytes_, MS_SYNC);
+        fdatasync(fd_);
+        flushing_ = false;
+    });
+}
+
+M210_STEREO::RawStereoRingReader::~RawStereoRingReader() {
+    if (map_) { munmap(map_, map_bytes_); }
+}
+
+M210_STEREO::RawStereoRingReader::Ptr
+M210_STEREO::RawStereoRingReader::createRawStereoRingReader(const std::string &file) {
+    Ptr reader = std::make_shared<RawStereoRingReader>();
+    if (!reader->open(file)) { return nullptr; }
+    return reader;
+}
+
+bool M210_STEREO::RawStereoRingReader::open(const std::string &file) {
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < RAW_RING_PAGE) {
+        ::close(fd);
+        return false;
+    }
+    map_bytes_ = (size_t) info.st_size;
+    void *map = mmap(nullptr, map_bytes_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        map_ = nullptr;
+        return false;
+    }
+    map_ = (uint8_t *) map;
+    header_ = (const RawRingHeader *) map_;
+    if (header_->magic != RAW_RING_MAGIC ||
+        header_->slot_bytes < sizeof(RawRingSlot) + 2 * (size_t) header_->width * header_->height ||
+        RAW_RING_PAGE + header_->slots * header_->slot_bytes > map_bytes_) {
+        std::cerr << file << " is not a stereo ring file\n";
+        return false;
+    }
+#ifdef __linux__
+    madvise(map_, map_bytes_, MADV_SEQUENTIAL);
+#endif
+
+    std::vector<std::pair<uint64_t, size_t>> sequences;
+    for (size_t i = 0; i < header_->slots; i++) {
+        const RawRingSlot *slot = (const RawRingSlot *) (map_ + RAW_RING_PAGE + i * header_->slot_bytes);
+        if (slot->sequence != 0) { sequences.emplace_back(slot->sequence, i); }
+    }
+    std::sort(sequences.begin(), sequences.end());
+    order_.reserve(sequences.size());
+    for (const auto &sequence : sequences) { order_.push_back(sequence.second); }
+    return true;
+}
+
+bool M210_STEREO::RawStereoRingReader::read(size_t index, cv::Mat &left, cv::Mat &right, RawRingSlot &slot) {
+    if (index >= order_.size()) { return false; }
+    uint8_t *slot_start = map_ + RAW_RING_PAGE + order_[index] * header_->slot_bytes;
+    slot = *(const RawRingSlot *) slot_start;
+    const int rows = (int) header_->height, cols = (int) header_->width;
+    left = cv::Mat(rows, cols, CV_8UC1, slot_start + sizeof(RawRingSlot));
+    right = cv::Mat(rows, cols, CV_8UC1, slot_start + sizeof(RawRingSlot) + (size_t) rows * cols);
+    return true;
+}
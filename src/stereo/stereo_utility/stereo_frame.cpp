@@ -6,7 +6,8 @@
 M210_STEREO::StereoFrame::StereoFrame(CameraParam::Ptr left_cam,
                                       CameraParam::Ptr right_cam)
         : camera_left_ptr_(left_cam), camera_right_ptr_(right_cam),
-          raw_disparity_map_(cv::Mat(VGA_HEIGHT, VGA_WIDTH, CV_16SC1)) {
+          raw_disparity_map_(cv::Mat(VGA_HEIGHT, VGA_WIDTH, CV_16SC1)),
+          calibration_pending_(false), calibration_loading_(false) {
     if (!this->initStereoParam()) {
         ROS_ERROR("Failed to init stereo parameters\n");
     }
@@ -19,61 +20,154 @@ M210_STEREO::StereoFrame::StereoFrame(CameraParam::Ptr left_cam,
 }
 
 M210_STEREO::StereoFrame::~StereoFrame() {
-
+    if (calibration_loader_.joinable()) {
+        calibration_loader_.join();
+    }
 }
 
 bool
 M210_STEREO::StereoFrame::initStereoParam() {
-    param_rect_left_ = Config::get<cv::Mat>("leftRectificationMatrix");
-    param_rect_right_ = Config::get<cv::Mat>("rightRectificationMatrix");
-    param_proj_left_ = Config::get<cv::Mat>("leftProjectionMatrix");
-    param_proj_right_ = Config::get<cv::Mat>("rightProjectionMatrix");
-    param_rot_stereo_ = Config::get<cv::Mat>("stereoRotationMatrix");
-    param_tran_stereo_ = Config::get<cv::Mat>("stereoTransVector");
-    cv::Mat Q;
-    cv::stereoRectify(camera_left_ptr_->getIntrinsic(), camera_left_ptr_->getDistortion(),
-                      camera_right_ptr_->getIntrinsic(), camera_right_ptr_->getDistortion(),
-                      cv::Size(VGA_WIDTH, VGA_HEIGHT), param_rot_stereo_, param_tran_stereo_, param_rect_left_,
-                      param_rect_right_, param_proj_left_, param_proj_right_, Q, CV_CALIB_ZERO_DISPARITY, -1,
-                      cv::Size(0, 0));
-
-    initUndistortRectifyMap(camera_left_ptr_->getIntrinsic(),
-                            camera_left_ptr_->getDistortion(),
-                            param_rect_left_,
-                            param_proj_left_,
+    StereoCalibration::Ptr calibration = buildCalibration(camera_left_ptr_->getIntrinsic(),
+                                                          camera_left_ptr_->getDistortion(),
+                                                          camera_right_ptr_->getIntrinsic(),
+                                                          camera_right_ptr_->getDistortion(),
+                                                          Config::get<cv::Mat>("stereoRotationMatrix"),
+                                                          Config::get<cv::Mat>("stereoTransVector"));
+    if (!calibration) {
+        return false;
+    }
+    calibration->file = Config::getParamFile();
+    applyCalibration(calibration);
+    return true;
+}
+
+M210_STEREO::StereoCalibration::Ptr
+M210_STEREO::StereoFrame::buildCalibration(const cv::Mat &intrinsic_left, const cv::Mat &dist_left,
+                                           const cv::Mat &intrinsic_right, const cv::Mat &dist_right,
+                                           const cv::Mat &rot_stereo, const cv::Mat &tran_stereo) {
+    if (intrinsic_left.size() != cv::Size(3, 3) || intrinsic_right.size() != cv::Size(3, 3) ||
+        rot_stereo.size() != cv::Size(3, 3) || tran_stereo.total() != 3 ||
+        dist_left.total() < 4 || dist_right.total() < 4) {
+        return nullptr;
+    }
+    StereoCalibration::Ptr calibration = std::make_shared<StereoCalibration>();
+    calibration->rot_stereo = rot_stereo;
+    calibration->tran_stereo = tran_stereo;
+    cv::stereoRectify(intrinsic_left, dist_left, intrinsic_right, dist_right,
+                      cv::Size(VGA_WIDTH, VGA_HEIGHT), rot_stereo, tran_stereo, calibration->rect_left,
+                      calibration->rect_right, calibration->proj_left, calibration->proj_right, calibration->q,
+                      CV_CALIB_ZERO_DISPARITY, -1, cv::Size(0, 0));
+
+    initUndistortRectifyMap(intrinsic_left,
+                            dist_left,
+                            calibration->rect_left,
+                            calibration->proj_left,
                             cv::Size(VGA_WIDTH, VGA_HEIGHT), CV_32F,
-                            rectified_mapping_[0][0], rectified_mapping_[0][1]);
-    initUndistortRectifyMap(camera_right_ptr_->getIntrinsic(),
-                            camera_right_ptr_->getDistortion(),
-                            param_rect_right_,
-                            param_proj_right_,
+                            calibration->mapping[0][0], calibration->mapping[0][1]);
+    initUndistortRectifyMap(intrinsic_right,
+                            dist_right,
+                            calibration->rect_right,
+                            calibration->proj_right,
                             cv::Size(VGA_WIDTH, VGA_HEIGHT), CV_32F,
-                            rectified_mapping_[1][0], rectified_mapping_[1][1]);
-
-    block_matcher_ = cv::StereoBM::create();
-    block_matcher_->setNumDisparities(numDisparities*16);
-    block_matcher_->setBlockSize(blockSize*2+5);
-    block_matcher_->setPreFilterType(preFilterType);
-    block_matcher_->setPreFilterSize(preFilterSize*2+5);
-    block_matcher_->setPreFilterCap(preFilterCap);
-    block_matcher_->setTextureThreshold(textureThreshold);
-    block_matcher_->setUniquenessRatio(uniquenessRatio);
-    block_matcher_->setSpeckleRange(speckleRange);
-    block_matcher_->setSpeckleWindowSize(speckleWindowSize);
-    block_matcher_->setDisp12MaxDiff(disp12MaxDiff);
-    block_matcher_->setMinDisparity(minDisparity);
-
+                            calibration->mapping[1][0], calibration->mapping[1][1]);
+
+    //! A matcher per calibration, the running one is never reconfigured under the pipeline
+    cv::Ptr<cv::StereoBM> block_matcher = cv::StereoBM::create();
+    block_matcher->setNumDisparities(numDisparities*16);
+    block_matcher->setBlockSize(blockSize*2+5);
+    block_matcher->setPreFilterType(preFilterType);
+    block_matcher->setPreFilterSize(preFilterSize*2+5);
+    block_matcher->setPreFilterCap(preFilterCap);
+    block_matcher->setTextureThreshold(textureThreshold);
+    block_matcher->setUniquenessRatio(uniquenessRatio);
+    block_matcher->setSpeckleRange(speckleRange);
+    block_matcher->setSpeckleWindowSize(speckleWindowSize);
+    block_matcher->setDisp12MaxDiff(disp12MaxDiff);
+    block_matcher->setMinDisparity(minDisparity);
+    calibration->block_matcher = block_matcher;
+
+
+    calibration->wls_filter = cv::ximgproc::createDisparityWLSFilter(block_matcher); // left_matcher
+    calibration->wls_filter->setLambda(8000.0);
+    calibration->wls_filter->setSigmaColor(1.5);
+
+    calibration->right_matcher = cv::ximgproc::createRightMatcher(block_matcher);
+
+    return calibration;
+}
 
-    wls_filter_ = cv::ximgproc::createDisparityWLSFilter(block_matcher_); // left_matcher
-    wls_filter_->setLambda(8000.0);
-    wls_filter_->setSigmaColor(1.5);
+void
+M210_STEREO::StereoFrame::applyCalibration(const StereoCalibration::Ptr &calibration) {
+    param_rect_left_ = calibration->rect_left;
+    param_rect_right_ = calibration->rect_right;
+    param_proj_left_ = calibration->proj_left;
+    param_proj_right_ = calibration->proj_right;
+    param_rot_stereo_ = calibration->rot_stereo;
+    param_tran_stereo_ = calibration->tran_stereo;
+    param_q_ = calibration->q;
+    for (int i = 0; i < 2; i++) {
+        rectified_mapping_[i][0] = calibration->mapping[i][0];
+        rectified_mapping_[i][1] = calibration->mapping[i][1];
+    }
+    block_matcher_ = calibration->block_matcher;
+    wls_filter_ = calibration->wls_filter;
+    right_matcher_ = calibration->right_matcher;
 
-    right_matcher_ = cv::ximgproc::createRightMatcher(block_matcher_);
+    std::lock_guard<std::mutex> lock(calibration_mutex_);
+    calibration_file_ = calibration->file;
+}
 
+bool
+M210_STEREO::StereoFrame::loadCalibration(const std::string &file, std::string &message) {
+    if (calibration_loading_) {
+        message = "A calibration is already loading";
+        return false;
+    }
+    cv::FileStorage calibration_file(file, cv::FileStorage::READ);
+    if (!calibration_file.isOpened()) {
+        message = "Failed to open " + file;
+        return false;
+    }
+    cv::Mat intrinsic_left, dist_left, intrinsic_right, dist_right, rot_stereo, tran_stereo;
+    calibration_file["leftCameraIntrinsicMatrix"] >> intrinsic_left;
+    calibration_file["leftDistCoeffs"] >> dist_left;
+    calibration_file["rightCameraIntrinsicMatrix"] >> intrinsic_right;
+    calibration_file["rightDistCoeffs"] >> dist_right;
+    calibration_file["stereoRotationMatrix"] >> rot_stereo;
+    calibration_file["stereoTransVector"] >> tran_stereo;
+    if (intrinsic_left.empty() || dist_left.empty() || intrinsic_right.empty() || dist_right.empty() ||
+        rot_stereo.empty() || tran_stereo.empty()) {
+        message = "Missing camera or stereo parameters in " + file;
+        return false;
+    }
 
+    if (calibration_loader_.joinable()) {
+        calibration_loader_.join();
+    }
+    calibration_loading_ = true;
+    calibration_loader_ = std::thread([=]() {
+        StereoCalibration::Ptr calibration = buildCalibration(intrinsic_left, dist_left, intrinsic_right,
+                                                              dist_right, rot_stereo, tran_stereo);
+        if (calibration) {
+            calibration->file = file;
+            std::lock_guard<std::mutex> lock(calibration_mutex_);
+            pending_calibration_ = calibration;
+            calibration_pending_ = true;
+        } else {
+            ROS_ERROR("Invalid calibration in %s, keeping %s", file.c_str(), getCalibrationFile().c_str());
+        }
+        calibration_loading_ = false;
+    });
+    message = "Rebuilding rectification maps for " + file;
     return true;
 }
 
+std::string
+M210_STEREO::StereoFrame::getCalibrationFile() {
+    std::lock_guard<std::mutex> lock(calibration_mutex_);
+    return calibration_file_;
+}
+
 M210_STEREO::StereoFrame::Ptr
 M210_STEREO::StereoFrame::createStereoFrame(CameraParam::Ptr left_cam, CameraParam::Ptr right_cam) {
     return std::make_shared<StereoFrame>(left_cam, right_cam);
@@ -92,8 +186,33 @@ void M210_STEREO::StereoFrame::readStereoImgs(const sensor_msgs::ImageConstPtr &
     frame_right_ptr_->time_stamp = img_right->header.stamp.nsec;
 }
 
+void M210_STEREO::StereoFrame::readStereoImgs(const cv::Mat &img_left, const cv::Mat &img_right,
+                                              uint64_t id, uint32_t time_stamp) {
+    //! Same size and type as the frame buffers, copyTo does not reallocate
+    img_left.copyTo(frame_left_ptr_->raw_image);
+    img_right.copyTo(frame_right_ptr_->raw_image);
+
+    frame_left_ptr_->id = id;
+    frame_right_ptr_->id = id;
+    frame_left_ptr_->time_stamp = time_stamp;
+    frame_right_ptr_->time_stamp = time_stamp;
+}
+
 void
 M210_STEREO::StereoFrame::rectifyImgs() {
+    //! A rebuilt calibration takes over at a frame boundary, no frame is lost
+    if (calibration_pending_) {
+        StereoCalibration::Ptr calibration;
+        {
+            std::lock_guard<std::mutex> lock(calibration_mutex_);
+            calibration.swap(pending_calibration_);
+            calibration_pending_ = false;
+        }
+        if (calibration) {
+            applyCalibration(calibration);
+            ROS_INFO("Stereo calibration switched to %s", calibration->file.c_str());
+        }
+    }
 
     cv::remap(frame_left_ptr_->getImg(), rectified_img_left_,
               rectified_mapping_[0][0], rectified_mapping_[0][1], cv::INTER_LINEAR);